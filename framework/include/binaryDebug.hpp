@@ -7,6 +7,10 @@
 #include "rose.h"
 /* get instruction decoding functions.  */
 #include "mipsISA.hpp"
+/* function cfg and its compact form */
+#include "cfgHandler.hpp"
+/* time spent printing */
+#include "rewriterStatistics.hpp"
 /* string stream */
 #include <sstream>
 #include <string>
@@ -14,6 +18,9 @@
 
 /* function declarations  */
 void printBasicBlockInstructions(SgAsmBlock*);
+/*  Times repeated traversals of the blocks and successors of a function,
+    once in the boost cfg and once in its compact snapshot. */
+void benchmarkCFGTraversal(CFG*, compactCFG*, unsigned);
 
 
 #endif
@@ -9,15 +9,79 @@
 #include "mipsISA.hpp"
 #include "symbolicRegisters.hpp"
 #include "naiveTransform.hpp"
+#include "linearScanTransform.hpp"
+#include "instructionScheduler.hpp"
+#include "delaySlotFiller.hpp"
+#include "relocationHandler.hpp"
+#include "elfWriter.hpp"
+#include "nodeRegistry.hpp"
+#include "transformCache.hpp"
+#include "cfgCache.hpp"
+#include "rewriterStatistics.hpp"
+#include "growthReport.hpp"
+#include "differentialHarness.hpp"
+#include "voterLibrary.hpp"
+#include "syncPointTMR.hpp"
+#include "patternRewriter.hpp"
 
 // Boost lib headers
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/vector_as_graph.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 // Rose headers
 #include "rose.h"
 
 
+/* Register allocation methods that can be selected */
+enum registerAllocationMode {
+    NAIVE_ALLOCATION,       //Saves and restores registers around every inserted region.
+    LINEAR_SCAN_ALLOCATION  //Liveness based, only spills when no register is free.
+};
+
+/* Instruction scheduling methods that can be selected */
+enum instructionSchedulingMode {
+    NO_SCHEDULING,          //Instructions are kept in the order they were inserted.
+    LIST_SCHEDULING         //Reorders instructions in the blocks to hide latencies.
+};
+
+/* Hardening transformations the framework applies after the user traversal */
+enum hardeningMode {
+    NO_HARDENING,           //Only the user transformations are applied.
+    SYNC_POINT_TMR          //Triplicates arithmetic, votes before stores, branches and calls.
+};
+
+/* Handler of an instruction kind, a member function of the user extension */
+class BinaryRewriter;
+typedef void (BinaryRewriter::*instructionHandler)(SgAsmMipsInstruction*);
+
+/* A function transformed in a run and the state of its traversal */
+struct functionTransform {
+    //constructor
+    functionTransform(): cfgContainer(NULL), shadowStatementListPtr(NULL),
+        inspectedInstruction(NULL), decisionsMade(0), growth(NULL) {};
+    /* Name of the function */
+    std::string name;
+    /* Cfghandler holding the function cfg */
+    CFGhandler* cfgContainer;
+    /* Nodes built by the framework for the function */
+    nodeRegistry nodes;
+    //Shadow statement list. This list will be swaped with the statementlist
+    //att the end of traversing a basic blocks statement list. (vector)
+    SgAsmStatementPtrList* shadowStatementListPtr;
+    //Current instruction being inspected.
+    SgAsmMipsInstruction* inspectedInstruction;
+    //number of decisions made
+    int decisionsMade;
+    /* Timers and counters of the function */
+    rewriterStatistics statistics;
+    /* Code growth of the function, when a report is written */
+    growthReport* growth;
+    /* Why the function is left out of the output, empty when it is not */
+    std::string error;
+};
+
 /* Class declaration */
 class BinaryRewriter {
     public:
@@ -32,19 +96,62 @@ class BinaryRewriter {
         * Configuration functions
         **********************************************************************/
         //Configure register allocation
-        void selectRegisterAllocation();
+        void selectRegisterAllocation(registerAllocationMode);
         //Configure instruction scheduling
-        void selectInstructionScheduling();
+        void selectInstructionScheduling(instructionSchedulingMode);
+        //  Configure hardening and the voter it inserts. Sync point TMR keeps
+        //  shadow registers across original instructions, so it is always
+        //  allocated with the linear scan.
+        void selectHardening(hardeningMode, voterKind);
+        //  Rewrite instruction sequences with the rules of the pattern
+        //  rewriter after the user traversal. The rules are compiled here,
+        //  the rewriter is not owned.
+        void setPatternRewriter(patternRewriter*);
+        //Configure filling of branch delay slots
+        void setDelaySlotFilling(bool);
+        //Write the rewritten binary to a file when transformed.
+        void setOutputFile(std::string);
+        //Write the code growth of every block to a file, JSON when the
+        //name ends in .json and CSV otherwise.
+        void setGrowthReport(std::string);
+        //  Run the selected function in the interpreter before and after it
+        //  is transformed, with up to four arguments, and print the overhead.
+        void setMeasurement(std::vector<uint32_t>);
+        //  Also run it as main with the argv, the results before and after
+        //  are compared.
+        void addMeasurementArgv(std::vector<std::string>);
+        //  Also run it as main with generated argv, the seed decides them.
+        void generateMeasurementArgv(unsigned, unsigned);
         //enable debugg printing.
         void setDebug(bool);
         /* Function that is to be transformed */
         void functionSelect(std::string);
+        /* Functions transformed by transformProgram, all if none are selected */
+        void selectFunctions(std::vector<std::string>);
+        //  Number of threads transformProgram uses, one by default. With more
+        //  than one, transformDecision, the instruction handlers and the
+        //  pattern actions run on several threads at once. They must be
+        //  thread safe then: no shared state without a lock, and only the
+        //  instruction passed in may be changed.
+        void setWorkerThreads(unsigned);
+        //  Reuse the transformed functions of earlier runs that are kept in
+        //  the file, functions that did not change are not transformed again.
+        void setTransformCache(std::string);
+        //  Extra key of the cached functions. The program image, the
+        //  registered handlers, the pattern rules and the framework settings
+        //  are always part of the key, a version is only needed when the
+        //  decisions depend on input outside the program, like a file.
+        void setTransformVersion(std::string);
 
         /**********************************************************************
         * Traversal functions. 
         **********************************************************************/
         //Function to begin rewriting
         void transformBinary();
+        //  Transforms all selected functions in one run. The functions are
+        //  transformed one after the other, or in parallel when more worker
+        //  threads are set, see setWorkerThreads.
+        void transformProgram();
 
         /**********************************************************************
         * Binary manipulation. 
@@ -57,14 +164,37 @@ class BinaryRewriter {
         void saveInstruction();
         //Virtual function that the user can change in his framework extension.
         virtual void transformDecision(SgAsmMipsInstruction*);
+        //  Registers a handler for an instruction kind, cast from a member
+        //  of the extension with static_cast<instructionHandler>. Once one is
+        //  registered transformDecision is no longer called, only the kinds
+        //  with a handler are visited and the others are copied unchanged.
+        void registerHandler(MipsInstructionKind, instructionHandler);
 
         /**********************************************************************
         * Misc. 
         **********************************************************************/
         //Print statistics.
         void printInformation();
+        //Write the phase timers and counters of the run as JSON.
+        bool writeStatistics(std::string);
         //Print out a basic blocks instructions.
         void printBasicBlock(SgAsmBlock*);
+        //Times traversals of the selected function cfg, boost against compact.
+        void benchmarkTraversal(unsigned);
+        //  Times the decision traversal of the selected function, the virtual
+        //  transformDecision path, or the handlers when registered, against
+        //  the traverseBlock of the extension. The decisions must keep the
+        //  instructions unchanged.
+        void benchmarkDecisions(unsigned);
+
+    protected:
+        /**********************************************************************
+        * Extension of the traversal. 
+        **********************************************************************/
+        //  Calls the decisions on the instructions of a block and fills the
+        //  shadow list of the function. Called once per block, extensions
+        //  that make their decisions statically override it.
+        virtual void traverseBlock(functionTransform*, SgAsmStatementPtrList*);
 
     private:
         /**********************************************************************
@@ -78,21 +208,66 @@ class BinaryRewriter {
         SgProject* binaryProjectPtr;
         /* Cfghandler pointer */
         CFGhandler* cfgContainer;
-        //Shadow statement list. This list will be swaped with the statementlist
-        //att the end of traversing a basic blocks statement list. (vector)
-        SgAsmStatementPtrList* shadowStatementListPtr;
-        //Current instruction being inspected.
-        SgAsmMipsInstruction* inspectedInstruction;
-        //number of decisions made
+        //number of decisions made, in all transformed functions
         int decisionsMade;
+        /* Phase timers and counters of the run */
+        rewriterStatistics statistics;
+        /* Selected register allocation */
+        registerAllocationMode allocationMode;
+        /* Selected instruction scheduling */
+        instructionSchedulingMode schedulingMode;
+        /* Handlers indexed by instruction kind, used when dispatching */
+        std::vector<instructionHandler> instructionHandlers;
+        bool dispatching;
+        /* Selected hardening and its voter */
+        hardeningMode hardening;
+        voterKind hardeningVoter;
+        /* Rules applied after the user traversal, none when NULL */
+        patternRewriter* patterns;
+        /* Is delay slot filling enabled */
+        bool fillDelaySlots;
+        /* Input binary and the file the output is written to */
+        std::string inputFile;
+        std::string outputFile;
+        /* File the growth report is written to, none when empty */
+        std::string growthReportFile;
+        /* Inputs the function is run with in the interpreter */
+        std::vector<harnessInput> measurementInputs;
         /* Is debugging enabled */
         bool debugging;
+        /* Functions selected for transformProgram */
+        std::vector<std::string> selectedFunctions;
+        /* Worker threads of transformProgram */
+        unsigned workerThreads;
+        /* Next function a worker takes and its lock */
+        size_t nextFunction;
+        boost::mutex functionMutex;
+        /* Transformed functions of earlier runs, used when the file is set */
+        transformCache functionCache;
+        std::string transformCacheFile;
+        std::string transformVersion;
+        /* Key of the policy, taken once before the functions are transformed */
+        std::string policyKey;
 
         /**********************************************************************
         * Private Functions. 
         **********************************************************************/
         //block traversal
         void blockTraversal();
+        //  Runs the user decisions, register allocation, scheduling and delay
+        //  slot filling on a function. Uses no state shared with other functions.
+        void transformFunction(functionTransform*);
+        //Calls the registered handlers on the instructions of a block
+        void dispatchBlock(functionTransform*, SgAsmStatementPtrList*);
+        //Worker loop of transformProgram
+        void transformWorker(std::vector<functionTransform*>*);
+        //Prints the blocks of a function cfg
+        void printFunction(compactCFG*);
+        //  Key of the program image, handlers and transformation settings,
+        //  part of the cached fingerprints
+        std::string transformPolicy();
+        //Writes and frees the growth reports of the transformed functions
+        void writeGrowthReports(std::vector<functionTransform*>&);
 };
 
 #endif 
@@ -0,0 +1,55 @@
+#ifndef CFGCACHE_H
+#define CFGCACHE_H
+/*
+* On disk cache of the disassembled program. The file is kept next to the
+* binary as <binary>.cfgcache and is valid for the binary and frontend
+* arguments it was written for, checked with their FNV-1a hash and size.
+* It holds the functions, the basic blocks with their decoded instructions
+* and raw bytes, and the edges of the program cfg. On a hit the blocks and
+* instructions are built from the file and frontend() is not run.
+* The file is a flat array of 64 bit words that is read through mmap.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/* Framework includes */
+#include "cfgHandler.hpp"
+#include "mipsISA.hpp"
+
+/* Object class for the program cfg cache. */
+class cfgCache {
+    public:
+        /* Constructor, takes the frontend arguments, the binary is the last */
+        cfgCache(int, char**);
+        /*  Builds the functions, blocks and instructions of the cached
+            program and adds them to the cfg. Returns false and leaves the
+            cfg empty when the cache is missing or does not match. */
+        bool load(CFG*);
+        /*  Writes the program cfg built by the frontend to the cache file.
+            Returns false when it has statements the cache can not rebuild. */
+        bool save(CFG*);
+        /* Name of the cache file */
+        std::string getCacheFile();
+
+    private:
+        /* Private variables */
+        std::string binaryFile;
+        std::string cacheFile;
+        /* Hash and size of the binary, the size is 0 if it can not be read */
+        uint64_t binaryHash;
+        uint64_t binarySize;
+        /* Hash of the other frontend arguments */
+        uint64_t argumentHash;
+
+        /* Functions */
+        //Hidding default constructor. I want the binary for this object
+        cfgCache() {};
+        /* FNV-1a hash of the input binary */
+        void hashBinary();
+};
+
+#endif
@@ -7,6 +7,10 @@
 **********************************************************************/
 /* Framework */
 #include "mipsISA.hpp"
+#include "relocationMap.hpp"
+#include "decodeCache.hpp"
+#include "symbolicRegisters.hpp"
+#include "compactCFG.hpp"
 
 #include "rose.h"
 /* std::map  */
@@ -15,6 +19,7 @@
 #include <limits>
 /* Boost includes. Adjacency list with propertymaps*/
 #include <boost/graph/adjacency_list.hpp>
+#include <boost/unordered_map.hpp>
 
 /**********************************************************************
 * Typedefs.
@@ -25,6 +30,23 @@ typedef boost::graph_traits<CFG>::edge_iterator CFGEIter;
 //map type for the property map in the cfg that contains the basic blocks.
 typedef boost::property_map<CFG, boost::vertex_name_t>::type basicBlockPropertyMap;
 
+/*  Vertices and edges of every function in the program cfg, built in one
+    pass over the program. The vertices of function n are
+    vertices[vertexStart[n]] to vertices[vertexStart[n + 1]], its edges are
+    stored the same way as pairs of positions in its vertex range. */
+struct functionBlockIndex {
+    /* Function name to its number */
+    boost::unordered_map<std::string, size_t> functionNumbers;
+    /* Function names by number */
+    std::vector<std::string> names;
+    /* Program cfg vertices, grouped by function */
+    std::vector<CFG::vertex_descriptor> vertices;
+    std::vector<size_t> vertexStart;
+    /* Edges inside the functions, grouped by function */
+    std::vector<std::pair<size_t, size_t> > edges;
+    std::vector<size_t> edgeStart;
+};
+
 
 /*******************************************************************************
 * Class containing information that is needed to perform transformations.
@@ -36,8 +58,17 @@ class CFGhandler {
 /**********************************************************************
 * Public Functions.
 **********************************************************************/
+        /* Constructor */
+        CFGhandler();
         /* Inital setup of the program cfg and this object */
         void initialize(SgProject*);
+        /*  Inital setup with a program cfg built from the cache, the
+            handler takes it over. */
+        void initialize(CFG*);
+        /*  Setup with the program cfg and function index of another
+            handler, used when several functions are transformed in the same
+            run. */
+        void initialize(CFGhandler*);
         /*  Extract a specific function from the whole program cfg.
             Returns a sub cfg that contains only the specified function.
             The cfg is build by adding the nodes(blocks) that belong to
@@ -51,10 +82,32 @@ class CFGhandler {
         rose_addr_t getNewAddress(rose_addr_t);
         /* return pointer to function cfg */
         CFG* getFunctionCFG();
+        /* return the name of the function the function cfg is based on */
+        std::string getFunctionName();
+        /* return the compact snapshot of the function cfg */
+        compactCFG* getCompactCFG();
         /* return pointer to program CFG */
         CFG* getProgramCFG();
+        /* return the mapping between old and new addresses */
+        relocationMap* getRelocationMap();
         /* Get the activation record pair*/
         std::pair<SgAsmInstruction*, SgAsmInstruction*> getActivationRecord();
+        /* return the decode cache of the function */
+        decodeCache* getDecodeCache();
+        /* return the symbolic registers of the function */
+        symbolicRegisterContext* getSymbolicContext();
+        /*  Makes the decode cache and symbolic registers of the function the
+            active ones of the calling thread */
+        void activate();
+        /* Highest and lowest instruction address of the function cfg */
+        std::pair<rose_addr_t, rose_addr_t> getAddressRange();
+        /*  Entry address of the function, where calls and function pointers
+            go. Not always the lowest block. */
+        rose_addr_t getFunctionEntry();
+        /* Names of all functions in the program, in address order */
+        std::vector<std::string> getFunctionNames();
+        /* Print the activation records and address range when set */
+        void setDebug(bool);
         
     private:
 /**********************************************************************
@@ -63,14 +116,24 @@ class CFGhandler {
         /* CFG pointers, for program and function cfg */
         CFG* programCFG;
         CFG* functionCFG;
+        /* Compact form of the function cfg, blocks in reverse post order */
+        compactCFG functionBlocks;
+        /* Blocks of every function, shared by the handlers of the program */
+        functionBlockIndex* programIndex;
         /* Name of the function that the function cfg is based on */
         std::string functionName;
         /* Variable to remember the address range the transformed instruction
             is withing. First = highest, second = lowest. */
         std::pair<rose_addr_t, rose_addr_t> addressRange;
         /*  Mapping between an old and new address, used later when correcting
-            branches and rewriting addresses */
-        std::map<rose_addr_t, rose_addr_t> instructionMap;
+            branches and rewriting addresses. Interval based, one entry per
+            run of instructions with the same displacement. */
+        relocationMap addressMap;
+        /*  Decoded instructions of the selected function, active while the
+            function is transformed. */
+        decodeCache functionDecodeCache;
+        /* Symbolic registers of the selected function */
+        symbolicRegisterContext functionSymbolicRegisters;
         /* Track forbidden instructions to transform, only for this selected
             function that is being transformed, search vector with std::find */
         std::vector<SgAsmInstruction*> forbiddenInstruction;
@@ -80,9 +143,13 @@ class CFGhandler {
         std::vector<SgAsmInstruction*> activationInstruction;
         /* first is the activationrecord, second is the deactivation record */
         std::pair<SgAsmInstruction*, SgAsmInstruction*> activationPair;
+        /* Is debugging enabled */
+        bool debugging;
 /**********************************************************************
 * Private Functions.
 **********************************************************************/
+        /* Builds the function index of the program cfg */
+        void buildFunctionIndex();
         /* Finds activation records in the functioncfg */
         void findActivationRecords();
         /* Find lowest address and highest address in the function cfg */
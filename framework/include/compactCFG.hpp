@@ -0,0 +1,60 @@
+#ifndef COMPACTCFG_H
+#define COMPACTCFG_H
+/*
+* Snapshot of a function cfg in compressed sparse row form. The blocks are
+* numbered in reverse post order and kept in one array, the successors and
+* predecessors of block n are a contiguous range of block numbers. The
+* analyses walk these arrays instead of the boost graph and its property
+* maps. The snapshot holds the blocks, not their statements, so it stays
+* valid while instructions are inserted into the blocks.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <vector>
+/* Boost includes. Adjacency list with propertymaps*/
+#include <boost/graph/adjacency_list.hpp>
+
+/* Typedefs of the boost cfg */
+typedef rose::BinaryAnalysis::ControlFlow::Graph CFG;
+
+/* Object class for the compact cfg. */
+class compactCFG {
+    public:
+        /* Constructor, empty graph */
+        compactCFG();
+        /* Builds the snapshot of a cfg */
+        void build(CFG*);
+        /* Number of blocks */
+        unsigned size();
+        /* Block with the number, numbers are in reverse post order */
+        SgAsmBlock* getBlock(unsigned);
+        /* Vertex of the block in the cfg the snapshot was built from */
+        CFG::vertex_descriptor getVertex(unsigned);
+        /* Number of the block of a vertex */
+        unsigned getNumber(CFG::vertex_descriptor);
+        /* Successors and predecessors as ranges of block numbers */
+        const unsigned* successorsBegin(unsigned);
+        const unsigned* successorsEnd(unsigned);
+        const unsigned* predecessorsBegin(unsigned);
+        const unsigned* predecessorsEnd(unsigned);
+        unsigned successorCount(unsigned);
+        unsigned predecessorCount(unsigned);
+
+    private:
+        /* Blocks and their vertices by number */
+        std::vector<SgAsmBlock*> blocks;
+        std::vector<CFG::vertex_descriptor> blockVertices;
+        /* Number of every vertex */
+        std::vector<unsigned> vertexNumbers;
+        /* Rows, the range of block n is start[n] to start[n + 1] */
+        std::vector<unsigned> successorStart;
+        std::vector<unsigned> successors;
+        std::vector<unsigned> predecessorStart;
+        std::vector<unsigned> predecessors;
+
+        /* Numbers the vertices in reverse post order */
+        void orderBlocks(CFG*);
+};
+
+#endif
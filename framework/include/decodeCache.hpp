@@ -0,0 +1,54 @@
+#ifndef DECODECACHE_H
+#define DECODECACHE_H
+/*
+* Cache of decoded instructions. Each instruction of the transformed
+* function is decoded once, later decodes of the same node are copies from
+* the cache. The cache of the selected function is active while it is
+* transformed and decodeInstruction uses it. Code that changes the operands
+* of an instruction invalidates it: buildInstruction for the new node, whose
+* memory can be that of a deleted one, insertInstruction for nodes the user
+* changed, the register allocators, the stack frame updates and the branch
+* patching of the relocation.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <map>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+
+/* Object class for the decode cache. */
+class decodeCache {
+    public:
+        /* Constructor */
+        decodeCache();
+        /* Returns the decoded instruction, decodes it on a miss */
+        const instructionStruct& decode(SgAsmMipsInstruction*);
+        /* Removes an instruction that was created or changed */
+        void invalidate(SgAsmMipsInstruction*);
+        /* Removes all instructions and resets the counters */
+        void clear();
+        /* Counters */
+        unsigned long getHits();
+        unsigned long getMisses();
+        /* Prints the counters */
+        void printStatistics();
+
+    private:
+        /* Decoded instructions */
+        std::map<SgAsmMipsInstruction*, instructionStruct> decodedInstructions;
+        /* Statistics */
+        unsigned long hits;
+        unsigned long misses;
+        unsigned long invalidations;
+};
+
+/* Sets the cache decodeInstruction uses, NULL disables caching */
+void setActiveDecodeCache(decodeCache*);
+/* Returns the active cache, NULL if there is none */
+decodeCache* getActiveDecodeCache();
+/* Invalidates an instruction in the active cache, if there is one */
+void invalidateDecodedInstruction(SgAsmMipsInstruction*);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef DELAYSLOTFILLER_H
+#define DELAYSLOTFILLER_H
+/*
+* Fills branch delay slots that contain a nop. An earlier instruction in
+* the same block that the branch and the instructions in between do not
+* depend on is moved into the delay slot and the nop is removed.
+*/
+
+/* Includes */
+#include "rose.h"
+/* Boost includes. Adjacency list with propertymaps*/
+#include <boost/graph/adjacency_list.hpp>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "registerLiveness.hpp"
+
+/* Object class for delay slot filling. */
+class delaySlotFiller {
+    public:
+        /* Constructor */
+        delaySlotFiller(CFGhandler* cfg);
+        /* Fills the delay slots in all blocks of the function cfg */
+        void applyFilling();
+        /* Prints the delay slots found and filled */
+        void printStatistics();
+
+    private:
+        /* Private variables */
+        CFGhandler* cfgContainer;
+        /* Statistics, nop delay slots found and filled */
+        int slotsFound;
+        int slotsFilled;
+
+        /* Functions */
+        //Hidding default constructor. I want a cfghandler for this object
+        delaySlotFiller() {};
+        /* Fills the delay slots of one block */
+        void fillBlock(SgAsmBlock*);
+        /*  Searches backwards from the branch for an instruction that can be
+            moved into its delay slot. Returns -1 if none was found. */
+        int findCandidate(SgAsmStatementPtrList&, int);
+        /* Checks the candidate against the branch operands */
+        bool compatibleWithBranch(SgAsmMipsInstruction*, SgAsmMipsInstruction*);
+        /* Checks if the instruction can not be moved or passed */
+        bool isFillBarrier(SgAsmStatement*);
+        /* Checks if the instruction reads or writes memory */
+        bool isMemoryInstruction(SgAsmMipsInstruction*);
+};
+
+#endif
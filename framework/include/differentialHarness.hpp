@@ -0,0 +1,75 @@
+#ifndef DIFFERENTIALHARNESS_H
+#define DIFFERENTIALHARNESS_H
+/*
+* Differential execution of a function before and after it is transformed.
+* Every input vector is run in the interpreter on the original statement
+* lists and again on the transformed ones. The architectural results must
+* match: how the run ended, the return or exit value, the registers the
+* caller relies on, the written output and the memory outside the frames.
+* Runs that stop the same way without finishing are inconclusive and are
+* counted apart. The report gives the mismatches, the inconclusive runs and
+* the ratio of dynamic instructions and cycles, so the cost of a
+* transformation is measured with its correctness.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/* Framework includes */
+#include "mipsInterpreter.hpp"
+
+/* Input vector of a run */
+struct harnessInput {
+    /* argv of a main function, argc and argv are passed when it is not empty */
+    std::vector<std::string> argv;
+    /* Register arguments otherwise */
+    std::vector<uint32_t> arguments;
+};
+
+/* Object class for the differential harness. */
+class differentialHarness {
+    public:
+        /* Constructor, takes the program cfg and the inputs to run */
+        differentialHarness(CFG*, std::vector<harnessInput>);
+        /* Loads the binary the function is in, false on failure */
+        bool loadELF(std::string);
+        /* Runs the inputs on the function before it is transformed */
+        void recordOriginal(rose_addr_t);
+        /* Runs the inputs on the function after it is transformed */
+        void recordTransformed(rose_addr_t);
+        /* Prints the mismatches and the overhead, returns the mismatching inputs */
+        unsigned printReport();
+        /*  Generates argv inputs of up to four short strings of digits and
+            other characters, the same seed gives the same inputs. */
+        static std::vector<harnessInput> generateArgv(unsigned, unsigned);
+
+    private:
+        /* Results of a run the transformation must not change */
+        struct architecturalState {
+            interpreterResult result;
+            std::vector<uint32_t> registers;
+            std::string output;
+            uint64_t memory;
+        };
+
+        /* Interpreter of the runs */
+        mipsInterpreter interpreter;
+        /* Inputs and their results before and after */
+        std::vector<harnessInput> inputs;
+        std::vector<architecturalState> original;
+        std::vector<architecturalState> transformed;
+
+        /* Hides default constructor */
+        differentialHarness();
+        /* Runs every input on the function */
+        void runInputs(rose_addr_t, std::vector<architecturalState>*);
+        /* A run that returned or exited */
+        static bool finishedRun(architecturalState&);
+        /* Describes the first difference, empty when the states match */
+        static std::string compareStates(architecturalState&, architecturalState&);
+};
+
+#endif
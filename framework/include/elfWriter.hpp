@@ -0,0 +1,123 @@
+#ifndef ELFWRITER_H
+#define ELFWRITER_H
+/*
+* Writes the rewritten program as a new static MIPS ELF. The input file is
+* mapped and copied, the transformed functions are appended after the end of
+* the executable segment, which grows over them in memory. The space between
+* the end of the segment and the next loaded segment has to hold them. Every
+* existing address stays the same, so data, jump tables and GOT entries are
+* still valid. The only words changed in the existing code are the jumps at
+* the original function entries. The contents after the executable segment
+* move in the file only.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <elf.h>
+#include <string>
+#include <vector>
+#include <set>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "relocationHandler.hpp"
+
+/* Object class for writing the output binary. */
+class elfWriter {
+    public:
+        /* Constructor, nothing read yet */
+        elfWriter();
+        /* Releases the input */
+        ~elfWriter();
+        /*  Maps the input file, reads the headers and finds the executable
+            segment. Returns false when the file can not be rewritten. */
+        bool readInput(std::string inputFile);
+        /* Address where the transformed functions are appended */
+        rose_addr_t getAppendAddress();
+        /*  Adds a relocated function. The functions are placed one after the
+            other from the append address on. */
+        void addFunction(CFGhandler* cfg, relocationHandler* relocation);
+        /*  Writes the output file from the input file. Returns false and
+            writes nothing when the functions do not fit or a write fails. */
+        bool writeFile(std::string outputFile);
+        /* Reason the last read or write failed */
+        std::string getError();
+        /* Prints the encoded instructions and the size of the appended code */
+        void printStatistics();
+
+    private:
+        /* A transformed function and where it is written */
+        struct writtenFunction {
+            CFGhandler* cfgContainer;
+            relocationHandler* relocationInfo;
+            /* Original address range */
+            rose_addr_t start;
+            rose_addr_t end;
+            /* Input file offset of the original range */
+            Elf32_Off offset;
+            /* Appended address range */
+            rose_addr_t placement;
+            rose_addr_t placementEnd;
+        };
+
+        /* Private variables */
+        std::vector<writtenFunction> functions;
+        /* Mapped input file */
+        unsigned char* inputData;
+        size_t inputSize;
+        /* File byte order differs from the host */
+        bool swapBytes;
+        /* File is big endian */
+        bool bigEndian;
+        /* Headers of the input in host byte order */
+        Elf32_Ehdr fileHeader;
+        std::vector<Elf32_Phdr> programHeaders;
+        std::vector<Elf32_Shdr> sectionHeaders;
+        /* Index of the executable segment */
+        int textSegment;
+        /* End of the executable segment in the file and in memory */
+        Elf32_Off segmentEndOffset;
+        Elf32_Addr segmentEnd;
+        /* Start and end of the appended code */
+        Elf32_Addr appendAddress;
+        Elf32_Addr appendEnd;
+        /* Move in the file of everything after the executable segment */
+        uint32_t fileShift;
+        /* Reason of the last failure */
+        std::string errorMessage;
+        /* Statistics */
+        int encodedInstructions;
+        int entryJumps;
+
+        /* Functions */
+        /* Checks the space for the appended code and computes the file shift */
+        bool computeLayout();
+        /* Streams the output file */
+        bool writeOutput(std::string);
+        /* Copies the input with the functions appended to the executable segment */
+        bool writeContents(int);
+        /* Encodes a transformed function into a buffer */
+        bool encodeFunction(writtenFunction&, std::vector<unsigned char>*);
+        /* Writes the jumps at the original function entries */
+        bool writeEntryJumps(int);
+        /* Updates and writes the headers */
+        bool writeHeaders(int);
+        /* Records the reason of a failure, returns false */
+        bool fail(std::string);
+        /* New file offset of an input file offset */
+        Elf32_Off newOffset(Elf32_Off);
+        /* Byte order conversion between file and host */
+        uint16_t fileOrder16(uint16_t);
+        uint32_t fileOrder32(uint32_t);
+        void convertHeader(Elf32_Ehdr*);
+        void convertProgramHeader(Elf32_Phdr*);
+        void convertSectionHeader(Elf32_Shdr*);
+        /* Stores an instruction word in file byte order */
+        void storeWord(unsigned char*, uint32_t);
+        /* Write helpers that fail on short writes */
+        bool writeAt(int, Elf32_Off, const void*, size_t);
+        bool writeSequential(int, const void*, size_t);
+};
+
+#endif
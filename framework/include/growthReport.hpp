@@ -0,0 +1,94 @@
+#ifndef GROWTHREPORT_H
+#define GROWTHREPORT_H
+/*
+* Code growth of a transformed function. The blocks are recorded before the
+* user traversal, after it and after the framework transformations. The
+* final instructions of each block are split into original, inserted by
+* the user, spill and reload, hi/lo save and stack adjustment, and the
+* static cycle estimate of the 4Kc latency model is given before and after.
+* The reports of a run are written as CSV or JSON.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "instructionScheduler.hpp"
+
+/* Object class for the growth report of a function. */
+class growthReport {
+    public:
+        /* Constructor, takes the handler of the function and its name */
+        growthReport(CFGhandler*, std::string);
+        /* Records the blocks before the user traversal */
+        void recordOriginal();
+        /*  Records the instructions the user inserted, after the traversal
+            and the pattern rules */
+        void recordInserted(const std::set<SgAsmStatement*>&);
+        /*  Finds the instructions the user inserted, the instructions without
+            an address after the traversal and the pattern rules */
+        static void findUserInstructions(CFGhandler*, std::set<SgAsmStatement*>*);
+        /* Splits the final instructions, after the framework transformations */
+        void recordFinal();
+        /* Prints the totals of the function */
+        void printStatistics();
+        /* Lowest address of the function, reports are written in address order */
+        rose_addr_t getAddress();
+
+        /* Writes the header and the rows of reports as CSV */
+        static void writeCSV(std::vector<growthReport*>&, std::ostream&);
+        /* Writes reports as a JSON object */
+        static void writeJSON(std::vector<growthReport*>&, std::ostream&);
+        /*  Writes reports to a file, JSON when the name ends in .json and CSV
+            otherwise. False if it can not be written. */
+        static bool writeFile(std::vector<growthReport*>&, std::string);
+
+    private:
+        /* Instruction counts and cycles of a block or a whole function */
+        struct growthCounts {
+            growthCounts(): address(0), originalInstructions(0), finalInstructions(0),
+                keptOriginal(0), userInserted(0), spillReload(0), hiLoSave(0),
+                stackAdjustment(0), otherInserted(0), originalCycles(0), finalCycles(0) {};
+            rose_addr_t address;
+            unsigned originalInstructions;
+            unsigned finalInstructions;
+            /* Split of the final instructions */
+            unsigned keptOriginal;
+            unsigned userInserted;
+            unsigned spillReload;
+            unsigned hiLoSave;
+            unsigned stackAdjustment;
+            unsigned otherInserted;
+            /* Static estimate with the 4Kc latencies */
+            int originalCycles;
+            int finalCycles;
+        };
+
+        /* Function the report is about */
+        CFGhandler* cfgContainer;
+        std::string functionName;
+        /* Counts by block number and for the function */
+        std::vector<growthCounts> blocks;
+        growthCounts total;
+        /* Stack bytes added to the activation record */
+        int64_t frameGrowth;
+        uint64_t originalFrameConstant;
+        /* Instructions inserted by the user */
+        std::set<SgAsmStatement*> userInstructions;
+
+        /* Hides default constructor */
+        growthReport();
+        /* Constant of the deallocation record, zero without one */
+        uint64_t frameConstant();
+        /* Writes one row of counts */
+        static void writeCSVRow(std::ostream&, std::string, std::string, growthCounts&);
+        static void writeJSONCounts(std::ostream&, growthCounts&);
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef INSTRUCTIONSCHEDULER_H
+#define INSTRUCTIONSCHEDULER_H
+/*
+* List scheduling of the instructions in the function cfg blocks.
+* Uses the MIPS 4Kc latencies so inserted and original instructions are
+* interleaved to hide load-use and hi/lo stalls. Runs after register
+* allocation so the spill code dependencies are on physical registers.
+*/
+
+/* Includes */
+#include "rose.h"
+/* Boost includes. Adjacency list with propertymaps*/
+#include <boost/graph/adjacency_list.hpp>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "registerLiveness.hpp"
+
+/* Cycles until the result of an instruction can be used, MIPS 4Kc. */
+int instructionLatency(MipsInstructionKind);
+/*  Static estimate of the cycles a statement list takes on a single issue
+    in order pipeline, counting stalls on register results. */
+int estimateStatementCycles(SgAsmStatementPtrList&);
+
+/* Object class for list scheduling. */
+class listScheduler {
+    public:
+        /* Constructor */
+        listScheduler(CFGhandler* cfg);
+        /* Schedules all blocks in the function cfg */
+        void applyScheduling();
+        /* Prints the estimated cycles before and after scheduling */
+        void printStatistics();
+
+    private:
+        /* Node in the dependency graph of a scheduling region */
+        struct scheduleNode {
+            SgAsmStatement* statement;
+            /* Physical registers written and read */
+            registerMask def;
+            registerMask use;
+            /* Memory access information */
+            bool isLoad;
+            bool isStore;
+            mipsRegisterName memoryBase;
+            /* Index of the last instruction writing the base register */
+            int baseVersion;
+            int64_t memoryOffset;
+            int memorySize;
+            /* Result latency */
+            int latency;
+            /* Successor index and edge latency */
+            std::vector<std::pair<int, int> > successors;
+            int predecessorCount;
+            /* Longest latency path to the end of the region */
+            int priority;
+            /* Earliest cycle the node can issue */
+            int earliest;
+            bool scheduled;
+        };
+
+        /* Private variables */
+        CFGhandler* cfgContainer;
+        /* Estimated cycles of the function before and after scheduling */
+        int cyclesBefore;
+        int cyclesAfter;
+
+        /* Functions */
+        //Hidding default constructor. I want a cfghandler for this object
+        listScheduler() {};
+        /* Schedules one block */
+        void scheduleBlock(SgAsmBlock*);
+        /* Schedules a region without barriers and appends it to the output */
+        void scheduleRegion(std::vector<scheduleNode>*, SgAsmStatementPtrList*);
+        /* Creates the node for an instruction */
+        scheduleNode createNode(SgAsmMipsInstruction*, std::vector<int>*, int);
+        /* Checks if two memory accesses can be in any order */
+        bool independentMemory(scheduleNode&, scheduleNode&);
+        /* Instructions that nothing is moved across */
+        bool isSchedulingBarrier(SgAsmStatement*);
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef LINEARSCANTRANSFORM_H
+#define LINEARSCANTRANSFORM_H
+/*
+* Linear scan register allocation of the symbolic registers. Uses register
+* liveness over the function cfg so symbolic registers are given physical
+* registers that are free at that point. Registers are only saved to the
+* stack when no free register is available. A symbolic register used in
+* several blocks without a register free in the whole function gets a
+* stack slot of the function, it is loaded where its block interval starts
+* and stored where it ends. An interval that gets no register at all stays
+* in its slot and borrows a register around each instruction.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <set>
+#include <string>
+/* Boost includes. Adjacency list with propertymaps*/
+#include <boost/graph/adjacency_list.hpp>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "symbolicRegisters.hpp"
+#include "registerLiveness.hpp"
+#include "rewriterStatistics.hpp"
+
+/* Object class for linear scan allocation. */
+class linearScanHandler {
+    public:
+        /* Constructor */
+        linearScanHandler(CFGhandler* cfg);
+        /*  Function for applying the allocation to the function cfg. Returns
+            false when the grown frame can not be built, the function is
+            then not usable. */
+        bool applyTransformation();
+        /* Reason of the last failure */
+        std::string getError();
+        /* Prints the intervals, spills and accumulator saves */
+        void printStatistics();
+
+    private:
+        /*  Live interval of a symbolic register within a block. Start and end
+            are instruction indexes in the blocks statement list. */
+        struct liveInterval {
+            unsigned symbolicNumber;
+            int start;
+            int end;
+            /* Physical register given to the interval */
+            mipsRegisterName hardRegister;
+            /*  The physical register holds a live value and is saved to
+                the stack around the interval. */
+            bool saved;
+            /* Stack slot used when the register is saved */
+            int stackSlot;
+            /* The value is kept in a stack slot outside the interval */
+            bool home;
+            /*  No register for the interval, the value stays in the slot and
+                a register is borrowed around each instruction. */
+            bool resident;
+            /* Slot of the value when it is at home or resident */
+            int homeSlot;
+        };
+
+        /* Private variables */
+        CFGhandler* cfgContainer;
+        /* Liveness of the physical registers */
+        registerLiveness* liveness;
+        /*  Size of the original stack frame, stack slots are placed above it
+            and below the incoming argument area. */
+        int frameSize;
+        /* Is fp set to sp, then it addresses the frame as well */
+        bool framePointer;
+        /* Built stack slot instructions, they already address the grown frame */
+        std::set<SgAsmMipsInstruction*> slotInstructions;
+        /* Registers of the symbolic registers used in several blocks */
+        std::map<unsigned, mipsRegisterName> globalRegisters;
+        registerMask globalMask;
+        /*  Stack slots of the symbolic registers used in several blocks that
+            got no register, the first slots of the function. */
+        std::map<unsigned, int> homeSlots;
+        int functionSlots;
+        /* Stack slots used in the current block, they follow the function slots */
+        int blockSlots;
+        /* Maximum stack slots used in a block, the stack is increased with this */
+        int maximumSlotsUsed;
+        /* Statistics */
+        int intervalCount;
+        int spillCount;
+        int residentCount;
+        int accumulatorSaves;
+        /* Reason of the last failure */
+        std::string error;
+        /* Caller saved registers, preferred when they are free */
+        registerMask temporaryPool;
+        /*  All registers that can be given to an interval, temporary and
+            callee saved. Saved around the interval if they are not free. */
+        registerMask allocatablePool;
+
+        /* Functions */
+        //Hidding default constructor. I want a cfghandler for this object
+        linearScanHandler() {};
+        /* Allocates the symbolic registers in one block */
+        void allocateBlock(unsigned);
+        /*  Gives the symbolic registers used in several blocks a register
+            that no instruction of the function references and that is not
+            live anywhere in it, or a stack slot when there is none. */
+        void allocateGlobalRegisters();
+        /*  Loads the resident symbolic registers of an instruction into
+            borrowed registers, the borrowed registers are saved in the
+            scratch slots. Fills in the slot and register of each. */
+        void loadResidents(SgAsmMipsInstruction*, std::map<unsigned, int>&, registerMask, int,
+            std::map<unsigned, mipsRegisterName>*, SgAsmStatementPtrList*,
+            std::vector<std::pair<int, mipsRegisterName> >*);
+        /* Stores the resident values back and restores the borrowed registers */
+        void storeResidents(std::vector<std::pair<int, mipsRegisterName> >&, int, SgAsmStatementPtrList*);
+        /* Creates the live intervals of the symbolic registers in a block */
+        void buildIntervals(SgAsmStatementPtrList&, std::vector<liveInterval>*);
+        /* Orders intervals by their start */
+        static bool intervalStartsBefore(const liveInterval&, const liveInterval&);
+        /* Returns the lowest register in a mask */
+        mipsRegisterName lowestRegister(registerMask);
+        /* Replaces symbolic registers in an instruction with the physical ones */
+        void replaceSymbolicRegisters(SgAsmMipsInstruction*, std::map<unsigned, mipsRegisterName>*);
+        /* Replaces a single register expression if it is symbolic */
+        SgAsmExpression* replaceRegisterExpression(SgAsmExpression*, std::map<unsigned, mipsRegisterName>*);
+        /* Inserts instructions saving the accumulator before a region */
+        void saveAccumulator(SgAsmStatementPtrList*, registerMask, int);
+        /* Inserts instructions restoring the accumulator after a region */
+        void restoreAccumulator(SgAsmStatementPtrList*, registerMask, int);
+        /* Builds a load or store relative to the stack pointer */
+        SgAsmMipsInstruction* buildStackInstruction(MipsInstructionKind, mipsRegisterName, int);
+        /* Builds mfhi, mflo, mthi or mtlo */
+        SgAsmMipsInstruction* buildAccumulatorMove(MipsInstructionKind, mipsRegisterName);
+        /* Reads the original stack frame size from the activation record */
+        void findFrameSize();
+        /* Increases the stack frame with the used slots, false on failure */
+        bool modifyStack();
+        /* Moves original references to the incoming argument area by the increase */
+        bool shiftIncomingOffsets(int);
+        /* Records the reason of a failure, returns false */
+        bool fail(std::string);
+        /* Sets the 16 bit offset of a load, store or addiu */
+        void setInstructionOffset(SgAsmMipsInstruction*, int);
+};
+
+#endif
@@ -7,6 +7,9 @@
 #include "rose.h"
 #include "symbolicRegisters.hpp"
 #include "boost/bimap.hpp"
+#include <iterator>
+#include <cstring>
+#include <ostream>
 
 /* forward declarations */
 struct instructionStruct;
@@ -16,7 +19,7 @@ struct instructionStruct;
 //RS,RT = Source operand registers
 enum instructionType {
     //decode R 
-    R_RD_RS_RT,     //add, addu, and, mul, nor, or, slt, sltu, sub, subu, xor, sllv, srav, srlv
+    R_RD_RS_RT,     //add, addu, and, mul, nor, or, slt, sltu, sub, subu, xor, sllv, srav, srlv, movn, movz
     R_RD_RS_C,      //sll, sra, srl,
     R_RD,           //mflo, mfhi,
     R_RS_RT,        //div, divu, madd, maddu, msub, msubu, mult, multu, 
@@ -27,9 +30,9 @@ enum instructionType {
     I_RD_RS_C,      //addi, addiu, andi, ori, xori, slti, sltiu, 
     I_RD_MEM_RS_C,  //lb, lbu, lh, lhu, lw, lwl, lwr, (instruction with a combined operand of register and constant)
     I_RD_C,         //lui, 
-    I_RS_RT_C,      //beq, bne, 
+    I_RS_RT_C,      //beq, bne, beql, bnel,
     I_RS_MEM_RT_C,  //sb, sh, sw, swl, swr,(instruction with a combined operand of register and constant)
-    I_RS_C,         //bgez, bgezal, bgtz, blez, bltz, 
+    I_RS_C,         //bgez, bgezal, bgtz, blez, bltz, bltzal and the likely forms
 
     //decode J 
     J_C,            //j(jump), jal,
@@ -39,35 +42,205 @@ enum instructionType {
     MIPS_UNKNOWN    //The instruction is not included and format is therefore unknown. 
 };
 
+//Operand roles of a format, the operands appear in this order.
+enum operandRole {
+    OPERAND_RD  = 1,    //destination register
+    OPERAND_RS  = 2,    //first source register
+    OPERAND_RT  = 4,    //second source register
+    OPERAND_C   = 8,    //constant
+    OPERAND_MEM = 16    //memory reference, base register and offset
+};
+
+//Use of the hi and lo registers.
+enum accumulatorUse {
+    ACCUMULATOR_READ_HI  = 1,
+    ACCUMULATOR_READ_LO  = 2,
+    ACCUMULATOR_WRITE_HI = 4,
+    ACCUMULATOR_WRITE_LO = 8
+};
+
+//Properties of an instruction kind.
+enum instructionFlag {
+    INSTRUCTION_BRANCH              = 1,    //branch or jump with a constant target
+    INSTRUCTION_DELAY_SLOT          = 2,    //followed by a delay slot
+    INSTRUCTION_CALL                = 4,    //writes the return address
+    INSTRUCTION_LIKELY              = 8,    //delay slot only executes when taken
+    INSTRUCTION_MERGES_DESTINATION  = 16    //partial load or conditional move, reads the destination
+};
+
+//Latency class, the cycles are decided by the scheduler.
+enum latencyClass {
+    LATENCY_SINGLE,     //result available to the next instruction
+    LATENCY_LOAD,       //load delay
+    LATENCY_MULTIPLY,   //multiply unit
+    LATENCY_DIVIDE      //iterative divide
+};
+
+// -------- instruction descriptor --------
+// Everything the framework knows about an instruction kind. Read from a
+// static table, see getInstructionDescriptor.
+struct instructionDescriptor {
+    //instruction format
+    instructionType format;
+    //operandRole bits, the operands of the instruction in operand order
+    unsigned char operands;
+    //accumulatorUse bits
+    unsigned char accumulator;
+    //bytes accessed by loads and stores, zero for other instructions
+    unsigned char memoryBytes;
+    //loads that sign extend
+    bool memorySigned;
+    //instructionFlag bits
+    unsigned char flags;
+    //latency class
+    latencyClass latency;
+};
+
 //function declarations.
-/* Decode the instruction, calls on the specific decode instructions. */
+/* Returns the descriptor of an instruction kind */
+const instructionDescriptor& getInstructionDescriptor(MipsInstructionKind);
+/* Decode the instruction, uses the active decode cache if there is one. */
 instructionStruct decodeInstruction(SgAsmMipsInstruction*);
+/* Decode the operands of the instruction without the cache. */
+instructionStruct decodeInstructionOperands(SgAsmMipsInstruction*);
 /* Builds an instruction from an instructionStruct */
 SgAsmMipsInstruction* buildInstruction(instructionStruct*);
+/*  Builds the operand list of the operand roles, used to give an existing
+    instruction new operands. */
+SgAsmOperandList* buildOperandList(instructionStruct*, unsigned);
 /* Return the format of an instruction defined by the framework */
 instructionType getInstructionFormat(MipsInstructionKind);
 /* decode a register operand */
 registerStruct decodeRegister(SgAsmExpression* expr);
-/* Creates a register expression */
+/*  Creates a register expression. The expression of a register is shared by
+    the operands of the function, it must not be changed in place and its
+    parent pointer is not trusted. */
 SgAsmDirectRegisterExpression* buildRegister(registerStruct regStruct);
+/* Checks if an instruction is a branch or jump, followed by a delay slot */
+bool hasDelaySlot(MipsInstructionKind);
+/* Encodes an instruction into its machine word, false if it is unknown or out of range */
+bool encodeInstruction(SgAsmMipsInstruction*, uint32_t*);
+
+/* Returns the mnemonic of an instruction kind, a static string */
+const char* instructionMnemonic(MipsInstructionKind);
+
+// -------- register list --------
+// Fixed capacity list of register operands kept inside the instruction
+// struct. MIPS instructions have at most three register operands so the
+// list never allocates. Has the parts of the vector interface the
+// framework uses, so code that built instructions with vectors still works.
+const unsigned maxRegisterOperands = 3;
+
+struct registerList {
+    //types
+    typedef registerStruct* iterator;
+    typedef const registerStruct* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    //Constructor
+    registerList():count(0){};
+    //Add a register, the list is full after three.
+    void push_back(const registerStruct& reg) {
+        if (count == maxRegisterOperands) {
+            ASSERT_not_reachable("Register list: More than three register operands.");
+        }
+        slots[count++] = reg;
+    }
+    void pop_back() {
+        checkIndex(0);
+        count--;
+    }
+    //Access, an index past the registers in the list is an error.
+    registerStruct& back() {
+        checkIndex(0);
+        return slots[count - 1];
+    }
+    registerStruct& front() {
+        checkIndex(0);
+        return slots[0];
+    }
+    registerStruct& operator[](size_t index) {
+        checkIndex(index);
+        return slots[index];
+    }
+    const registerStruct& operator[](size_t index) const {
+        checkIndex(index);
+        return slots[index];
+    }
+    void checkIndex(size_t index) const {
+        if (index >= count) {
+            ASSERT_not_reachable("Register list: Register operand out of range.");
+        }
+    }
+    //Iteration
+    iterator begin() { return slots; }
+    iterator end() { return slots + count; }
+    const_iterator begin() const { return slots; }
+    const_iterator end() const { return slots + count; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    //Size
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+    //Replace the content with a range of registers
+    template<class InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+        clear();
+        for(; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+    //members
+    registerStruct slots[maxRegisterOperands];
+    unsigned count;
+};
+
+// -------- mnemonic --------
+// Mnemonic of an instruction struct. Holds a pointer to a static string,
+// like the ones of instructionMnemonic and string literals, so decoding does
+// not allocate. Compares by content with strings and literals, and converts
+// to std::string. A std::string can not be assigned since the pointer would
+// outlive it, assign instructionMnemonic(kind) or a literal instead.
+struct mnemonicString {
+    mnemonicString():text(""){};
+    mnemonicString(const char* value):text(value){};
+    bool operator==(const char* other) const { return strcmp(text, other) == 0; }
+    bool operator!=(const char* other) const { return strcmp(text, other) != 0; }
+    bool operator==(const std::string& other) const { return other == text; }
+    bool operator!=(const std::string& other) const { return other != text; }
+    bool operator==(const mnemonicString& other) const { return strcmp(text, other.text) == 0; }
+    bool operator!=(const mnemonicString& other) const { return strcmp(text, other.text) != 0; }
+    const char* c_str() const { return text; }
+    operator std::string() const { return std::string(text); }
+    const char* text;
+};
+inline bool operator==(const char* first, const mnemonicString& second) { return second == first; }
+inline bool operator!=(const char* first, const mnemonicString& second) { return second != first; }
+inline bool operator==(const std::string& first, const mnemonicString& second) { return second == first; }
+inline bool operator!=(const std::string& first, const mnemonicString& second) { return second != first; }
+inline std::ostream& operator<<(std::ostream& stream, const mnemonicString& mnemonic) {
+    return stream << mnemonic.text;
+}
 
 // -------- instruction struct --------
 // Contains information that is useful for the framework about
-// the current instruction.
+// the current instruction. Fixed size and copied by value, decoding does
+// not allocate.
 struct instructionStruct {
     //Constructor
     instructionStruct():kind(mips_unknown_instruction), mnemonic(""), format(MIPS_UNKNOWN),
-    instructionConstant(0), significantBits(0), memoryReferenceSize(0), isSignedMemory(false), address(0){};
+    instructionConstant(0), significantBits(0), isSignedConstant(false), memoryReferenceSize(0),
+    isSignedMemory(false), address(0){};
     //nmemonic enum.
     MipsInstructionKind kind;
     //mnemonic string
-    std::string mnemonic;
+    mnemonicString mnemonic;
     //instruction format.
     instructionType format;
     //input register(s)
-    std::vector<registerStruct> destinationRegisters;
+    registerList destinationRegisters;
     //output registers
-    std::vector<registerStruct> sourceRegisters;
+    registerList sourceRegisters;
 
     //if the instruction uses a constant then save it and significant bits.
     //The constant value
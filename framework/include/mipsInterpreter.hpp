@@ -0,0 +1,138 @@
+#ifndef MIPSINTERPRETER_H
+#define MIPSINTERPRETER_H
+/*
+* MIPS32 user mode interpreter of the statement lists in the program cfg.
+* The loadable segments of a static ELF are the memory, the instructions are
+* the ones in the blocks, so the same function can be run before and after
+* it is transformed. Execution follows the statement lists, a control
+* transfer enters the block starting at the target address. Counts the
+* executed instructions and the cycles of the 4Kc latency model with its
+* hi/lo and load-use stalls. The exit and write system calls are handled.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+/* Boost includes */
+#include <boost/unordered_map.hpp>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "registerLiveness.hpp"
+#include "instructionScheduler.hpp"
+
+/* How a run ended */
+enum interpreterStatus {
+    INTERPRETER_RETURNED,       //The function returned to its caller.
+    INTERPRETER_EXITED,         //The program called exit.
+    INTERPRETER_LIMIT,          //The instruction limit was reached.
+    INTERPRETER_NO_CODE,        //Control reached an address without a block.
+    INTERPRETER_UNKNOWN,        //An instruction the interpreter can not execute.
+    INTERPRETER_BREAK           //A break instruction or a failed trap.
+};
+
+/* Result and counters of a run */
+struct interpreterResult {
+    interpreterResult(): status(INTERPRETER_NO_CODE), returnValue(0), instructions(0),
+        cycles(0), hiLoStalls(0), loadUseStalls(0), stopAddress(0) {};
+    interpreterStatus status;
+    /* v0 on return, the exit code on exit */
+    uint32_t returnValue;
+    /* Executed instructions and the cycles they took */
+    uint64_t instructions;
+    uint64_t cycles;
+    /* Stall cycles waiting for hi/lo and for loaded values */
+    uint64_t hiLoStalls;
+    uint64_t loadUseStalls;
+    /* Address where the run stopped */
+    rose_addr_t stopAddress;
+};
+
+/* Object class for the interpreter. */
+class mipsInterpreter {
+    public:
+        /* Constructor, takes the program cfg whose blocks are executed */
+        mipsInterpreter(CFG*);
+        /* Loads the segments and symbols of a static ELF, false on failure */
+        bool loadELF(std::string);
+        /* Calls the function at the address with up to four arguments */
+        interpreterResult runFunction(rose_addr_t, std::vector<uint32_t>);
+        /* Calls a main function with argc, argv from the strings and no environment */
+        interpreterResult runMain(rose_addr_t, std::vector<std::string>);
+        /* Runs the program from the ELF entry point */
+        interpreterResult runProgram();
+        /* Highest number of instructions a run executes */
+        void setInstructionLimit(uint64_t);
+        /* Bytes the program wrote with the write system call */
+        std::string getOutput();
+        /* Register after a run */
+        uint32_t getRegister(mipsRegisterName);
+        /*  Digest of the memory after a run. The stack below the stack
+            pointer of the caller is left out, it holds the frames. */
+        uint64_t memoryDigest();
+        /* Prints the result of a run */
+        static void printResult(std::string, interpreterResult&);
+
+    private:
+        /* Position in a statement list */
+        struct codePosition {
+            SgAsmBlock* block;
+            size_t index;
+        };
+        /* Pages of memory */
+        typedef std::vector<unsigned char> memoryPage;
+
+        /* Blocks that are executed */
+        CFG* programCFG;
+        /* Loaded segments, copied into the memory at the start of a run */
+        boost::unordered_map<uint32_t, memoryPage> image;
+        /* ELF information */
+        bool bigEndian;
+        uint32_t entryPoint;
+        uint32_t globalPointer;
+        /* State of a run */
+        boost::unordered_map<uint32_t, memoryPage> memory;
+        uint32_t registers[32];
+        /* Stack pointer at the start of the run */
+        uint32_t entryStack;
+        uint32_t hi;
+        uint32_t lo;
+        std::string output;
+        uint64_t instructionLimit;
+        /* Block starts and original instructions by address */
+        boost::unordered_map<rose_addr_t, codePosition> blockStarts;
+        boost::unordered_map<rose_addr_t, codePosition> instructions;
+        /* Address after the last original instruction of each block */
+        boost::unordered_map<SgAsmBlock*, rose_addr_t> fallThrough;
+
+        /* Hides default constructor */
+        mipsInterpreter();
+        /* Fresh memory and registers for a run */
+        void resetState();
+        /* Stores argv and an empty environment on the stack, returns argv */
+        uint32_t storeArguments(std::vector<std::string>&);
+        /* Calls a function with the stack pointer and arguments set */
+        interpreterResult call(rose_addr_t);
+        /* Indexes the statement lists as they are now */
+        void indexCode();
+        /* Position of an address, false if there is no code */
+        bool findPosition(rose_addr_t, codePosition*);
+        /* Position after the statement, false if there is no code */
+        bool nextPosition(codePosition, codePosition*);
+        /* Runs from a position until the run stops */
+        interpreterResult run(rose_addr_t);
+        /* Executes a system call, returns true when the program exits */
+        bool systemCall(interpreterResult*);
+        /* Memory access */
+        unsigned char* memoryByte(uint32_t);
+        uint32_t loadMemory(uint32_t, int);
+        void storeMemory(uint32_t, int, uint32_t);
+        /* Register access, writes to zero are dropped */
+        uint32_t readRegister(const registerStruct&);
+        void writeRegister(const registerStruct&, uint32_t);
+};
+
+#endif
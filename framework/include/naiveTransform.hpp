@@ -8,6 +8,7 @@
 
 /* Includes */
 #include <queue>
+#include <string>
 #include "rose.h"
 /* Boost includes. Adjacency list with propertymaps*/
 #include <boost/graph/adjacency_list.hpp>
@@ -17,14 +18,18 @@
 #include "cfgHandler.hpp"
 #include "symbolicRegisters.hpp"
 #include "binaryDebug.hpp"
+#include "rewriterStatistics.hpp"
 
 /* Object class for naive transformations. */
 class naiveHandler{
     public:
         /* Constructor */
         naiveHandler(CFGhandler* cfg);
-        /* Function for applying the naive transformation  */
-        void applyTransformation();
+        /*  Function for applying the naive transformation. Returns false
+            when the stack can not be grown, the function is then not usable. */
+        bool applyTransformation();
+        /* Reason of the last failure */
+        std::string getError();
     private:
         /* Private variables */
         CFGhandler* cfgContainer;
@@ -39,6 +44,8 @@ class naiveHandler{
         std::set<mipsRegisterName> hardRegisters;
         /* number of used hard registers in a region */
         int usedHardRegs;
+        /* Reason of the last failure */
+        std::string error;
 
         /* Functions */
         //Hidding default constructor. I want a cfghandler for this object
@@ -46,8 +53,8 @@ class naiveHandler{
         /*  Checks the amount of stack space needed by finding the maximum
             amount of symbolic register used. */
         void determineStackModification();
-        /*  Adjusts the stack size */
-        void modifyStack();
+        /*  Adjusts the stack size, false without an activation record */
+        bool modifyStack();
         /*  Help function that increments register use for special registers. */
         void specialInstructionUse(MipsInstructionKind, int*);
         /*  Transforms a basic block. Inserts SW/LW instructions and replaces
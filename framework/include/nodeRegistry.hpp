@@ -0,0 +1,65 @@
+#ifndef NODEREGISTRY_H
+#define NODEREGISTRY_H
+/*
+* Registry of the ROSE nodes the framework creates for a function. Every
+* instruction, operand list, expression and type built while the function
+* is transformed is recorded here. Nodes are allocated by ROSE from its own
+* pools, the registry only remembers them in creation order. A node built
+* for a function is only placed in the blocks of that function, register
+* expressions and symbolic registers are per function as well. When the
+* function is done the recorded nodes that are not reachable from its own
+* cfg are deleted, no other function is walked. Nodes recorded by other
+* registries or created by ROSE are never touched.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <vector>
+#include <algorithm>
+#include <boost/thread/recursive_mutex.hpp>
+/* Boost includes. Adjacency list with propertymaps*/
+#include <boost/graph/adjacency_list.hpp>
+
+/* Framework includes */
+#include "cfgHandler.hpp"
+
+/* Object class for the node registry. */
+class nodeRegistry {
+    public:
+        /* Constructor */
+        nodeRegistry();
+        /* Records a node created by the framework */
+        void track(SgNode*, size_t);
+        /*  Deletes the recorded nodes that are not reachable from the blocks
+            of the function cfg. The registry is empty afterwards. */
+        void releaseUnused(CFG*);
+        /* Bytes of the recorded nodes, current and the highest */
+        size_t getLiveBytes();
+        size_t getPeakBytes();
+        /* Prints the counters */
+        void printStatistics();
+
+    private:
+        /* Recorded nodes, each is recorded once when it is built */
+        std::vector<SgNode*> ownedNodes;
+        /* Statistics */
+        size_t liveBytes;
+        size_t peakBytes;
+        unsigned long nodesCreated;
+        unsigned long nodesFreed;
+
+        /* Collects every node reachable from the blocks of a cfg */
+        static void markReachable(CFG*, std::vector<SgNode*>*);
+        /* Adds an expression and everything below it to the list */
+        static void markExpression(SgAsmExpression*, std::vector<SgNode*>*);
+};
+
+/* Sets the registry framework nodes are recorded in, NULL disables it */
+void setActiveNodeRegistry(nodeRegistry*);
+/* Records a node in the active registry, if there is one */
+void trackFrameworkNode(SgNode*, size_t);
+/*  Held while the framework creates or deletes ROSE nodes. The ROSE node
+    pools are not thread safe, functions transformed in parallel share them. */
+boost::recursive_mutex& frameworkNodeMutex();
+
+#endif
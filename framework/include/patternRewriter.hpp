@@ -0,0 +1,99 @@
+#ifndef PATTERNREWRITER_H
+#define PATTERNREWRITER_H
+/*
+* Rewriting of instruction sequences inside a block by declarative rules. A
+* rule is a sequence of instruction kinds with register constraints and an
+* action that builds the replacement. The rules are compiled into one
+* automaton over the kinds, a statement list is scanned once and the
+* automaton step costs the same however many rules are loaded. When a state
+* ends the pattern of a rule the registers of the matched instructions are
+* checked against the constraints, the action can still decline the match.
+* Matches do not overlap, scanning restarts after a replacement.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <string>
+#include <vector>
+/* Boost includes */
+#include <boost/thread/mutex.hpp>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+
+/*  Register constraint of an operand. A variable number binds the register,
+    every operand with the same variable must be the same register. */
+const int PATTERN_ANY = -1;
+/* Operand that must be a given physical register */
+int patternFixed(mipsRegisterName);
+
+/* An instruction of a pattern */
+struct patternElement {
+    MipsInstructionKind kind;
+    /* Constraint of the destination register */
+    int destination;
+    /* Constraints of the source registers, in the order of the decoded instruction */
+    int sources[2];
+};
+
+/* Builds a pattern element from the kind and the operand constraints */
+patternElement patternInstruction(MipsInstructionKind, int = PATTERN_ANY, int = PATTERN_ANY, int = PATTERN_ANY);
+
+/*  Action of a rule. Gets the matched instructions decoded and the bound
+    registers by variable, fills in the replacement. Returns false to keep
+    the matched instructions. */
+typedef bool (*rewriteAction)(std::vector<instructionStruct>&, std::vector<registerStruct>&,
+    std::vector<SgAsmMipsInstruction*>*);
+
+/* Object class for the rule engine. */
+class patternRewriter {
+    public:
+        /* Constructor, no rules */
+        patternRewriter();
+        /* Adds a rule, the automaton has to be compiled again */
+        void addRule(std::string, std::vector<patternElement>, rewriteAction);
+        /* Builds the automaton of all rules */
+        void compile();
+        /*  Rewrites a statement list, returns the number of replacements.
+            Forbidden instructions of the handler are not rewritten, the
+            handler may be NULL. Can be called from several threads. */
+        unsigned rewriteBlock(SgAsmStatementPtrList&, CFGhandler*);
+        /* Rewrites all blocks of the function cfg */
+        unsigned rewriteFunction(CFGhandler*);
+        /*  Rules in order with the kinds and constraints of their patterns,
+            part of the cached fingerprints. The actions are not in it, a
+            changed action needs a new rule name. */
+        std::string describe();
+        /* Prints the replacements made by each rule */
+        void printStatistics();
+
+    private:
+        /* A rule and the replacements it made */
+        struct rewriteRule {
+            std::string name;
+            std::vector<patternElement> pattern;
+            rewriteAction action;
+            unsigned variables;
+            unsigned long replacements;
+        };
+
+        /* Rules by number */
+        std::vector<rewriteRule> rules;
+        /* Symbol of every instruction kind, zero for kinds in no pattern */
+        std::vector<unsigned> kindSymbols;
+        unsigned symbolCount;
+        /* Transitions, states times symbols, and the rules ending in a state */
+        std::vector<unsigned> transitions;
+        std::vector<std::vector<unsigned> > stateRules;
+        bool compiled;
+        /* Guards the replacement counts */
+        boost::mutex statisticsMutex;
+
+        /* Checks the constraints of a rule on the decoded window */
+        bool bindRegisters(rewriteRule&, std::vector<instructionStruct>&, std::vector<registerStruct>*);
+        /* Checks that the window can be replaced */
+        bool replaceableWindow(SgAsmStatementPtrList&, size_t, size_t, CFGhandler*);
+};
+
+#endif
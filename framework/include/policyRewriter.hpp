@@ -0,0 +1,71 @@
+#ifndef POLICYREWRITER_H
+#define POLICYREWRITER_H
+/*
+* Template front end of the rewriter. Instead of subclassing BinaryRewriter
+* and overriding the virtual transformDecision, the user writes a policy
+* type and instantiates policyRewriter with it. The traversal of a block is
+* compiled for the policy, its handler is called statically and can be
+* inlined into the loop. The policy declares which instruction kinds it
+* handles with a static filter that is inlined into the loop as well, the
+* instructions of other kinds are copied to the shadow list in runs without
+* calling anything.
+*
+* A policy provides:
+*   static bool handles(MipsInstructionKind);
+*       true for the kinds the policy handles. A policy that handles every
+*       kind returns true and the test folds away.
+*   void transform(BinaryRewriter&, SgAsmMipsInstruction*);
+*       the decision for a handled instruction, it uses saveInstruction and
+*       insertInstruction of the rewriter like transformDecision does.
+*/
+
+/* Framework includes */
+#include "binaryRewriter.hpp"
+
+/* Object class for a rewriter with its decisions in a policy. */
+template<class Policy>
+class policyRewriter : public BinaryRewriter {
+    public:
+        /* Constructor, initializes the framework with the binary */
+        policyRewriter(int argc, char** argv): BinaryRewriter(argc, argv) {};
+        /* The policy, for its settings */
+        Policy& getPolicy() { return policy; }
+
+    protected:
+        /* Traversal of a block compiled for the policy */
+        void traverseBlock(functionTransform* function, SgAsmStatementPtrList* stmtList) {
+            SgAsmStatementPtrList* shadowList = function->shadowStatementListPtr;
+            SgAsmStatementPtrList::iterator runStart = stmtList->begin();
+            for(SgAsmStatementPtrList::iterator stmtIter = stmtList->begin();
+                stmtIter != stmtList->end(); ++stmtIter) {
+                SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*stmtIter);
+                if (mips != NULL && Policy::handles(mips->get_kind()) == false) {
+                    continue;
+                }
+                /* End of a run, copy it. Statements that are not instructions are dropped. */
+                shadowList->insert(shadowList->end(), runStart, stmtIter);
+                runStart = stmtIter + 1;
+                if (mips == NULL) {
+                    continue;
+                }
+                function->inspectedInstruction = mips;
+                if (function->cfgContainer->isForbiddenInstruction(mips)) {
+                    countStatistic(COUNT_FORBIDDEN, 1);
+                    saveInstruction();
+                } else {
+                    countStatistic(COUNT_INSPECTED, 1);
+                    function->decisionsMade++;
+                    policy.transform(*this, mips);
+                }
+            }
+            shadowList->insert(shadowList->end(), runStart, stmtList->end());
+        }
+
+    private:
+        /* The user decisions */
+        Policy policy;
+        /* Hides default constructor */
+        policyRewriter();
+};
+
+#endif
@@ -0,0 +1,86 @@
+/* Register liveness analysis over the function cfg. */
+#ifndef REGISTERLIVENESS_H
+#define REGISTERLIVENESS_H
+
+/* Includes */
+#include "rose.h"
+/* Boost includes. Adjacency list with propertymaps*/
+#include <boost/graph/adjacency_list.hpp>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "symbolicRegisters.hpp"
+
+/**********************************************************************
+* Typedefs and register masks.
+**********************************************************************/
+/*  A set of physical registers. Bit 0-31 are the general purpose registers
+    indexed by mipsRegisterName, bit 32 and 33 are the special registers
+    hi and lo. Symbolic registers are never part of a mask. */
+typedef uint64_t registerMask;
+
+/* Bits for the special registers, hi and lo */
+const registerMask hiRegisterBit = (registerMask)1 << 32;
+const registerMask loRegisterBit = (registerMask)1 << 33;
+/* Both accumulator registers */
+const registerMask accumulatorMask = hiRegisterBit | loRegisterBit;
+/* All registers that can be tracked. zero is never live. */
+const registerMask allRegistersMask = (((registerMask)1 << 34) - 1) & ~(registerMask)1;
+
+/* Returns the mask bit of a physical register */
+registerMask registerBit(mipsRegisterName);
+/*  Fills in the physical registers that an instruction defines and uses.
+    Calls clobber the caller saved registers, unknown instructions are
+    assumed to use every register. Without the call effects only the
+    operands of a call are given, the callee runs after the delay slot. */
+void instructionDefUse(SgAsmMipsInstruction*, registerMask* def, registerMask* use, bool callEffects = true);
+/* Checks if the instruction is a call, jal, jalr, bgezal or bltzal */
+bool isCallInstruction(MipsInstructionKind);
+
+/*******************************************************************************
+* Iterative backwards liveness of the physical registers in the function cfg.
+* Runs over the compact cfg, blocks are identified by their number in it.
+* Works on the statement lists as they are when analyze is called, so
+* instructions inserted by the user are included. Blocks without successors
+* in the function cfg get a conservative live out set. A call and its delay
+* slot are one unit, the callee reads and clobbers after the slot.
+*******************************************************************************/
+class registerLiveness {
+    public:
+        /* Constructor, takes the compact function cfg */
+        registerLiveness(compactCFG*);
+        /* Computes live in and live out for all blocks */
+        void analyze();
+        /* Registers live at the start of a block */
+        registerMask getLiveIn(unsigned);
+        /* Registers live at the end of a block */
+        registerMask getLiveOut(unsigned);
+        /*  Fills the vector with the registers live before each instruction
+            in the block, the last entry is the live out of the block. */
+        void getInstructionLiveness(unsigned, std::vector<registerMask>*);
+
+    private:
+        /* Hide default constructor */
+        registerLiveness() {};
+        /* The function cfg that is analyzed */
+        compactCFG* functionCFG;
+        /* Per block sets, indexed by the block number */
+        std::vector<registerMask> blockUse;
+        std::vector<registerMask> blockDef;
+        std::vector<registerMask> liveIn;
+        std::vector<registerMask> liveOut;
+        /*  Live out used for blocks without successors in the function cfg
+            or with successors that could not be found. */
+        std::vector<registerMask> exitLiveOut;
+        /*  Extra successors not present as edges, the block after a call
+            which the callee returns to. */
+        std::vector<std::vector<unsigned> > returnSuccessors;
+
+        /* Calculates use and def of a block */
+        void blockDefUse(SgAsmBlock*, registerMask*, registerMask*);
+        /* Determines the exit live out and the return successors of the blocks */
+        void findExitBehaviour();
+};
+
+#endif
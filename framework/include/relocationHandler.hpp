@@ -0,0 +1,130 @@
+#ifndef RELOCATIONHANDLER_H
+#define RELOCATIONHANDLER_H
+/*
+* Gives the instructions of the transformed function their final addresses
+* and corrects the branches and jumps in it. The function is placed at a new
+* address after the program code and a jump to it is written at its original
+* entry, so calls, GOT entries, function pointers and constructor tables that
+* hold the entry reach the new code. Nothing else in the program moves, the
+* rest of the original function stays in place. Jump tables hold addresses
+* in the old body, functions that jump through one are not relocated. The
+* jump keeps t9 at the original entry, so PIC prologues that build gp from
+* t9 still compute the right value.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <set>
+#include <string>
+#include <algorithm>
+/* Boost includes. Adjacency list with propertymaps*/
+#include <boost/graph/adjacency_list.hpp>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "relocationMap.hpp"
+#include "registerLiveness.hpp"
+
+/* Alignment of the relocated functions in bytes */
+const int64_t codeAlignment = 16;
+
+/* Object class for address relocation. */
+class relocationHandler {
+    public:
+        /* Constructor, the function is placed at the address */
+        relocationHandler(CFGhandler* cfg, rose_addr_t placement);
+        /*  Assigns addresses, corrects all branches and builds the entry jump.
+            Returns false when the function can not be relocated, it has to
+            keep its original code then. */
+        bool applyRelocation();
+        /* Reason the relocation was refused */
+        std::string getError();
+        /* Prints the intervals, branches and expansions */
+        void printStatistics();
+        /* Number of bytes the function grew */
+        int64_t getGrowth();
+        /* Start address of the function */
+        rose_addr_t getFunctionStart();
+        /* First address after the original function */
+        rose_addr_t getFunctionEnd();
+        /* Original entry of the function, where the jump is written */
+        rose_addr_t getFunctionEntry();
+        /* New start of the function and the first address after it, aligned */
+        rose_addr_t getPlacement();
+        rose_addr_t getPlacementEnd();
+        /*  Jump to the new entry and its delay slot, at the original entry.
+            Empty when the entry has no room for it. */
+        std::vector<SgAsmMipsInstruction*>* getEntryJump();
+
+    private:
+        /* Private variables */
+        CFGhandler* cfgContainer;
+        /* The mapping that is filled in, owned by the cfghandler */
+        relocationMap* addressMap;
+        /* Function blocks in original address order */
+        std::vector<SgAsmBlock*> functionBlocks;
+        /* Address range and entry of the original function */
+        rose_addr_t functionStart;
+        rose_addr_t functionEnd;
+        rose_addr_t functionEntry;
+        /* Address range of the relocated function */
+        rose_addr_t placement;
+        rose_addr_t placementEnd;
+        /* Growth of the function in bytes */
+        int64_t growth;
+        /*  Branches created when expanding, their target is the instruction
+            after the second value. */
+        std::map<SgAsmMipsInstruction*, SgAsmMipsInstruction*> localBranches;
+        /*  lui and ori loading the return address of an expanded linking
+            branch, the address is the instruction after the second value. */
+        std::map<SgAsmMipsInstruction*, SgAsmMipsInstruction*> returnAddressParts;
+        /* lui and ori loading the target of an expanded jump, by the old target */
+        std::map<SgAsmMipsInstruction*, rose_addr_t> targetAddressParts;
+        /* Original start addresses of all program blocks, sorted */
+        std::vector<rose_addr_t> programBlockStarts;
+        /* Does an instruction of the function read at, then it can not be clobbered */
+        bool readsAt;
+        /* Jump at the original entry and its nop */
+        std::vector<SgAsmMipsInstruction*> entryJump;
+        /* Statistics */
+        int expandedBranches;
+        int patchedBranches;
+        /* Reason of the last failure */
+        std::string error;
+
+        /* Functions */
+        //Hidding default constructor. I want a cfghandler for this object
+        relocationHandler() {};
+        /* Collects the function blocks and the program block starts */
+        void collectBlocks();
+        /* Single linear pass assigning new addresses, fills the map */
+        void layoutFunction(std::vector<std::vector<rose_addr_t> >*);
+        /* Checks if the function jumps through a table of old addresses */
+        bool hasJumpTable();
+        /* Checks the branch ranges and expands the ones out of range, false on failure */
+        bool expandOutOfRange(std::vector<std::vector<rose_addr_t> >&, bool*);
+        /* Returns the new target of a branch in the function */
+        rose_addr_t newBranchTarget(SgAsmMipsInstruction*, rose_addr_t);
+        /* Checks if the target can be reached by the instruction at the address */
+        bool targetInRange(MipsInstructionKind, rose_addr_t, rose_addr_t);
+        /* Replaces the branch at the index and its delay slot with a long form */
+        bool expandBranch(SgAsmStatementPtrList*, size_t);
+        /* Sets the new addresses and branch targets in the function */
+        void patchFunction(std::vector<std::vector<rose_addr_t> >&);
+        /* Builds the jump at the original entry */
+        void buildEntryJump();
+        /* Returns the constant operand of an instruction */
+        SgAsmIntegerValueExpression* findConstant(SgAsmMipsInstruction*);
+        /* Checks if the instruction has a constant branch target */
+        bool hasBranchTarget(MipsInstructionKind);
+        /* Help functions to build the long form instructions */
+        SgAsmMipsInstruction* buildJump(MipsInstructionKind, rose_addr_t);
+        SgAsmMipsInstruction* buildNop();
+        SgAsmMipsInstruction* buildInvertedBranch(SgAsmMipsInstruction*);
+        SgAsmMipsInstruction* buildAddressInstruction(MipsInstructionKind, mipsRegisterName, uint64_t);
+        /* Records the reason of a failure, returns false */
+        bool fail(std::string);
+};
+
+#endif
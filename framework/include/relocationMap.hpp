@@ -0,0 +1,61 @@
+/* Mapping between old and new addresses after a function is rewritten. */
+#ifndef RELOCATIONMAP_H
+#define RELOCATIONMAP_H
+
+/* Headers */
+#include "rose.h"
+#include <vector>
+
+/*******************************************************************************
+* Sorted table of address intervals. Each interval covers a run of original
+* instructions that have the same displacement in the new layout, so a
+* block that only had instructions appended uses one entry instead of one
+* map node per instruction. Lookups are binary searches.
+*
+* translate returns the address that control reaching the old address
+* should reach. For the first instruction of a run that is the start of the
+* inserted instructions in front of it, insertedBefore is their size.
+* Old addresses inside the table but not covered by any interval were
+* removed and translate to the start of the next interval. Addresses below
+* the table are not moved.
+*******************************************************************************/
+class relocationMap {
+    public:
+        /* Interval of old addresses, [oldStart, oldEnd) */
+        struct relocationInterval {
+            rose_addr_t oldStart;
+            rose_addr_t oldEnd;
+            rose_addr_t newStart;
+            /* Bytes of inserted instructions before the first instruction */
+            rose_addr_t insertedBefore;
+        };
+
+        /* Remove all intervals */
+        void clear();
+        /*  Add the new location of one old instruction. entryAddress is
+            where control should go, instructionAddress where the instruction
+            itself ended up. Call finalize when all are added. */
+        void addInstruction(rose_addr_t oldAddress, rose_addr_t entryAddress, rose_addr_t instructionAddress);
+        /* Add a range that is moved as a whole */
+        void addRange(rose_addr_t oldStart, rose_addr_t oldEnd, rose_addr_t newStart);
+        /* Sorts and merges the added instructions into intervals */
+        void finalize();
+        /* Check if the address is moved */
+        bool isMoved(rose_addr_t);
+        /* Return the new address */
+        rose_addr_t translate(rose_addr_t);
+        /* Number of intervals in the table */
+        size_t size();
+        /* Access to the intervals, sorted on old address */
+        const std::vector<relocationInterval>& getIntervals();
+
+    private:
+        /* Sorts intervals on old start */
+        static bool intervalBefore(const relocationInterval&, const relocationInterval&);
+        /* Finalized intervals */
+        std::vector<relocationInterval> intervals;
+        /* Single instruction intervals not yet merged */
+        std::vector<relocationInterval> pending;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef REWRITERSTATISTICS_H
+#define REWRITERSTATISTICS_H
+/*
+* Timers and counters of a rewriter run. Every phase has a monotonic timer
+* that adds up all its runs, the counters give the instructions inspected,
+* inserted, forbidden and spilled. A function transformed by a worker has
+* its own statistics that are merged into the ones of the run afterwards.
+* The statistics can be printed or written as JSON.
+*/
+
+/* Includes */
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+/* Timed phases of a run. Stack modification and region allocation are
+    parts of the register allocation and counted in it as well, the debug
+    output is also counted in the phase that prints. */
+enum rewriterPhase {
+    PHASE_FRONTEND,             //ROSE frontend, parsing and disassembly.
+    PHASE_PROGRAM_CFG,          //Program cfg and function index, or reading them from the cache.
+    PHASE_FUNCTION_CFG,         //Extracting the function cfgs.
+    PHASE_USER_TRAVERSAL,       //transformDecision on every instruction.
+    PHASE_PATTERN_REWRITE,      //Rules of the pattern rewriter on every block.
+    PHASE_REGISTER_ALLOCATION,  //Naive or linear scan allocation.
+    PHASE_STACK_MODIFICATION,   //determineStackModification of the naive allocation.
+    PHASE_REGION_ALLOCATION,    //regionAllocation of the naive allocation.
+    PHASE_SCHEDULING,           //List scheduling.
+    PHASE_DELAY_SLOTS,          //Delay slot filling.
+    PHASE_RELOCATION,           //New addresses and branch correction.
+    PHASE_WRITE,                //Writing the output binary.
+    PHASE_DEBUG_OUTPUT,         //Printing of blocks when debugging.
+    PHASE_COUNT
+};
+
+/* Counters of a run */
+enum rewriterCounter {
+    COUNT_FUNCTIONS,            //Functions transformed.
+    COUNT_INSPECTED,            //Instructions given to transformDecision.
+    COUNT_INSERTED,             //Instructions inserted by the user.
+    COUNT_FORBIDDEN,            //Instructions not allowed to be transformed.
+    COUNT_SPILLED,              //Registers saved to the stack by the allocation.
+    COUNTER_COUNT
+};
+
+/* Object class for the statistics of a run. */
+class rewriterStatistics {
+    public:
+        /* Constructor, everything zero */
+        rewriterStatistics();
+        /* Adds a run of a phase */
+        void addTime(rewriterPhase, uint64_t);
+        /* Adds to a counter */
+        void count(rewriterCounter, unsigned long);
+        /* Keeps the highest number of symbolic registers of a function */
+        void recordSymbolicRegisters(unsigned);
+        /* Adds the statistics of a function */
+        void merge(const rewriterStatistics&);
+        /* Prints the phases and counters */
+        void printStatistics();
+        /* Writes the statistics as a JSON object */
+        void writeJSON(std::ostream&);
+        /* Writes the JSON object to a file, false if it can not be written */
+        bool writeJSON(std::string);
+
+    private:
+        /* Nanoseconds and runs of every phase */
+        uint64_t phaseTime[PHASE_COUNT];
+        unsigned long phaseRuns[PHASE_COUNT];
+        /* Counters */
+        unsigned long counters[COUNTER_COUNT];
+        /* Most symbolic registers used by one function */
+        unsigned peakSymbolicRegisters;
+};
+
+/*  Times a phase from construction to destruction and adds it to the
+    statistics that were active when it started. */
+class phaseTimer {
+    public:
+        /* Starts the timer */
+        phaseTimer(rewriterPhase);
+        /* Adds the time to the statistics */
+        ~phaseTimer();
+
+    private:
+        rewriterPhase phase;
+        rewriterStatistics* statistics;
+        uint64_t start;
+        /* Hides default constructor */
+        phaseTimer();
+};
+
+/* Monotonic clock in nanoseconds */
+uint64_t monotonicNanoseconds();
+/* Statistics the timers and counters of this thread add to, NULL for none */
+void setActiveStatistics(rewriterStatistics*);
+rewriterStatistics* getActiveStatistics();
+/* Adds to a counter of the active statistics */
+void countStatistic(rewriterCounter, unsigned long);
+
+#endif
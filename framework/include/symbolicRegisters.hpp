@@ -4,21 +4,60 @@
 
 /* header files */
 #include "rose.h"
-#include "boost/bimap.hpp"
+#include <vector>
 
 /* forward declarations */
 struct registerStruct;
 
+/*  Symbolic registers of one function. The expressions are kept in a
+    vector indexed by their number. Each expression is tagged through its
+    register descriptor, zero bits and the number as offset, so checking
+    and numbering an operand needs no lookup.
+    The context also holds one shared expression per physical register for
+    the operands the framework builds in the function. A shared expression
+    has many parents, its parent pointer is only the last one ROSE set and
+    is never trusted. Code goes from the instruction down to its operands,
+    and an operand is replaced instead of changed in place. */
+class symbolicRegisterContext {
+    public:
+        /* Constructor */
+        symbolicRegisterContext();
+        /* Creates a new symbolic register */
+        registerStruct generate();
+        /* Returns the expression of a symbolic register */
+        SgAsmDirectRegisterExpression* getExpression(unsigned);
+        /* Returns the shared expression of a physical register, by number */
+        SgAsmDirectRegisterExpression* getPhysicalExpression(unsigned);
+        /* Removes an expression that is about to be deleted */
+        void forget(SgAsmDirectRegisterExpression*);
+        /* Removes all registers and restarts the numbering */
+        void clear();
+        /* Number of registers generated */
+        unsigned size();
+
+    private:
+        /* Expressions indexed by number, slot 0 is never used */
+        std::vector<SgAsmDirectRegisterExpression*> registers;
+        /* Shared physical register expressions, created on first use */
+        SgAsmDirectRegisterExpression* physicalRegisters[32];
+};
+
+/* Sets the context of the function being transformed */
+void setActiveSymbolicContext(symbolicRegisterContext*);
 /* returns a register expression mapped to a symbolic register. */
 registerStruct generateSymbolicRegister();
 /* Returns the directregisterexpression connected to a specific symbolic register */
 SgAsmDirectRegisterExpression* getDirectRegisterExpression(unsigned); 
+/* Returns the shared expression of a physical register in the active context */
+SgAsmDirectRegisterExpression* getPhysicalRegisterExpression(unsigned);
 /* returns the symbolic register name mapped to the register expression */
 unsigned findSymbolicRegister(SgAsmDirectRegisterExpression*);
 /* Check if a register is symbolic */
 bool isSymbolicRegister(SgAsmDirectRegisterExpression*);
-/* initialize and clear the symbolic register map and reset the counter */
+/* clear the symbolic registers of the active context and reset the counter */
 void clearSymbolicRegister();
+/* removes a register expression that is about to be deleted from the context */
+void forgetSymbolicRegister(SgAsmDirectRegisterExpression*);
 
 //name of the registers.
 enum mipsRegisterName {
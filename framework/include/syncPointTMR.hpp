@@ -0,0 +1,60 @@
+#ifndef SYNCPOINTTMR_H
+#define SYNCPOINTTMR_H
+/*
+* Software TMR that votes only at synchronization points. Every original
+* arithmetic instruction of a block is computed three times, the two copies
+* write shadow symbolic registers and read the shadows of their sources, so
+* the triplicated values flow through straight-line code without votes.
+* A value is voted back into its register where it leaves the register
+* file: before it is used by a store, load, branch, jump, call or any other
+* instruction that is not triplicated, and at the end of the block when it
+* is live out. The shadows are kept within a block, the delay slot of the
+* terminating branch is voted with the branch.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <map>
+#include <utility>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "cfgHandler.hpp"
+#include "registerLiveness.hpp"
+#include "voterLibrary.hpp"
+
+/* Object class for the synchronization point TMR. */
+class syncPointTMR {
+    public:
+        /* Constructor, takes the function and the voter to insert */
+        syncPointTMR(CFGhandler*, voterKind);
+        /* Triplicates and votes in all blocks of the function cfg */
+        void applyTransformation();
+        /* Prints the triplicated instructions and the inserted votes */
+        void printStatistics();
+
+    private:
+        /* Shadow copies of a physical register */
+        typedef std::map<mipsRegisterName, std::pair<registerStruct, registerStruct> > shadowMap;
+
+        /* Function that is hardened */
+        CFGhandler* cfgContainer;
+        /* Voter inserted at the synchronization points */
+        voterKind voter;
+        /* Statistics, triplicated instructions and inserted votes */
+        unsigned triplicated;
+        unsigned votes;
+
+        /* Hides default constructor */
+        syncPointTMR();
+        /* Hardens one block, takes the registers live out of it */
+        void hardenBlock(SgAsmBlock*, registerMask);
+        /* Checks if the instruction is computed three times */
+        bool isTriplicable(SgAsmMipsInstruction*, instructionStruct&);
+        /* Builds a copy of the instruction on the shadows of one side */
+        SgAsmMipsInstruction* buildCopy(instructionStruct, shadowMap&, bool, registerStruct);
+        /* Votes the shadowed registers in the mask and drops their shadows */
+        void voteRegisters(registerMask, shadowMap&, SgAsmStatementPtrList*);
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef TRANSFORMCACHE_H
+#define TRANSFORMCACHE_H
+/*
+* Cache of transformed functions between runs. A function is identified by
+* a fingerprint of its blocks, instructions and edges together with a key
+* of the transformation policy. When the fingerprint of a function is
+* unchanged its blocks are rebuilt from the cached instructions, the user
+* decisions, register allocation, scheduling and delay slot filling are
+* skipped. The original instructions stay the same nodes, only their
+* operands are rebuilt. The relocation and writing are done as for any
+* function.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdint.h>
+/* Boost includes */
+#include <boost/thread/mutex.hpp>
+
+/* Framework includes */
+#include "cfgHandler.hpp"
+#include "mipsISA.hpp"
+
+/* Object class for the transform cache. */
+class transformCache {
+    public:
+        /* Constructor */
+        transformCache();
+        /* Reads the cached functions of a file, false if it is missing or invalid */
+        bool load(std::string);
+        /* Writes all cached functions to a file */
+        bool save(std::string);
+        /*  Fingerprint of the function cfg of a handler and a policy key.
+            The original statements are added to the vector, sorted. */
+        uint64_t fingerprint(CFGhandler*, std::string, std::vector<SgAsmStatement*>*);
+        /*  Rebuilds the blocks of the function from the cache when the
+            fingerprint matches. Returns false and changes nothing otherwise,
+            on success the decisions made when it was cached and the
+            instructions the user inserted are returned. */
+        bool restore(std::string, CFGhandler*, uint64_t, int*, std::set<SgAsmStatement*>*);
+        /*  Caches the transformed blocks of a function, takes its original
+            statements and the instructions the user inserted */
+        void store(std::string, CFGhandler*, uint64_t, int, const std::vector<SgAsmStatement*>&,
+            const std::set<SgAsmStatement*>&);
+        /* Prints the counters */
+        void printStatistics();
+
+    private:
+        /* A cached function, its blocks as a list of words */
+        struct cachedFunction {
+            uint64_t fingerprint;
+            int decisionsMade;
+            std::vector<uint64_t> words;
+        };
+        /* Cached functions by name */
+        std::map<std::string, cachedFunction> functions;
+        /* Workers look up and store functions at the same time */
+        boost::mutex cacheMutex;
+        /* Statistics */
+        unsigned long hits;
+        unsigned long misses;
+        unsigned long stored;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef VOTERLIBRARY_H
+#define VOTERLIBRARY_H
+/*
+* Majority voters for hardening transformations. A voter is a sequence of
+* inserted instructions that writes the majority of three copies of a value
+* to a destination, under the assumption that at most one copy is wrong.
+* The voters use only single cycle instructions, there is no divide and the
+* accumulator is not used, so the naive allocation does not have to save
+* hi/lo around the region. The temporaries are symbolic registers of the
+* active function, the destination may be one of the copies.
+*/
+
+/* Includes */
+#include "rose.h"
+#include <vector>
+
+/* Framework includes */
+#include "mipsISA.hpp"
+#include "symbolicRegisters.hpp"
+
+/*  Voters of the library. The cycles are those of the 4Kc latency model
+    without the allocation around them, for comparison summing the copies
+    and dividing by three costs 35 cycles for divu alone. */
+enum voterKind {
+    VOTER_BITWISE_MAJORITY,     //(a & b) | (c & (a | b)), 4 instructions, 4 cycles, 2 temporaries.
+    VOTER_COMPARE_SELECT,       //a if a equals b, c otherwise, through a mask. 6 instructions, 6 cycles, 2 temporaries.
+    VOTER_CONDITIONAL_MOVE,     //a, replaced by c with movn when a and b differ. 2 instructions and 2 cycles
+                                //when the destination is a copy, 3 otherwise, 1 temporary.
+    VOTER_COUNT
+};
+
+/* Cost of a voter, the most it takes */
+struct voterDescriptor {
+    //name used in reports
+    const char* name;
+    //inserted instructions
+    unsigned instructions;
+    //cycles of the 4Kc latency model
+    unsigned cycles;
+    //symbolic registers used as temporaries
+    unsigned temporaries;
+};
+
+/* Returns the descriptor of a voter */
+const voterDescriptor& getVoterDescriptor(voterKind);
+/*  Builds the instructions of a voter, destination then the three copies.
+    The instructions are inserted in order after the copies are computed. */
+std::vector<SgAsmMipsInstruction*> buildVoter(voterKind, registerStruct, registerStruct, registerStruct, registerStruct);
+
+#endif
@@ -2,18 +2,21 @@
 
 /* header file */
 #include "binaryDebug.hpp"
+/* clock for the traversal benchmark */
+#include <ctime>
 
 /* Forward declaration */
 void printInstruction(instructionStruct*);
 /* initfunction for register enum to string map.  */
 std::map<mipsRegisterName, std::string> initRegStringMap();
 /* adds registers to the stringstream object */
-void printRegisters(std::stringstream* regStream, std::vector<registerStruct>* registers); 
+void printRegisters(std::stringstream* regStream, registerList* registers); 
 /* Print instruction constants */
 void printConstant(std::stringstream* conStream, instructionStruct* instStruct);
 
 /* print the instructions contained in a basicblock */
 void printBasicBlockInstructions(SgAsmBlock* block) {
+    phaseTimer timer(PHASE_DEBUG_OUTPUT);
     //get the list of instructions in the block.
     SgAsmStatementPtrList* stmtlistPtr = &block->get_statementList();
     /* print the block number */
@@ -87,11 +90,11 @@ void printConstant(std::stringstream* conStream, instructionStruct* instStruct)
 }
 
 /* adds registers to the stringstream object */
-void printRegisters(std::stringstream* regStream, std::vector<registerStruct>* registers) {
+void printRegisters(std::stringstream* regStream, registerList* registers) {
     /* Map that is mapping enum to corresponding string */
     static std::map<mipsRegisterName, std::string> registerMap = initRegStringMap();
     /* add the registers to the register stream, iterate over the vector and add them. */
-    for(std::vector<registerStruct>::iterator iter = registers->begin();
+    for(registerList::iterator iter = registers->begin();
         iter != registers->end(); iter++) {
         /* take out the register struct, check if it is symbolic or physical */
         registerStruct regS = *iter;
@@ -156,3 +159,48 @@ std::map<mipsRegisterName, std::string> initRegStringMap() {
     /* return the filled map */
     return regMap;
 }
+
+
+/*  Times repeated traversals of a function cfg. Every round visits all
+    blocks and reads the statement count of the block and its successors,
+    the same access pattern as the dataflow analyses. */
+void benchmarkCFGTraversal(CFG* graph, compactCFG* compact, unsigned rounds) {
+    /* Sums are printed so the traversals are not optimized away */
+    size_t graphSum = 0;
+    size_t compactSum = 0;
+
+    /* Traverse the boost graph through the property map */
+    std::clock_t graphStart = std::clock();
+    for(unsigned round = 0; round < rounds; ++round) {
+        for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*graph);
+            vPair.first != vPair.second; ++vPair.first) {
+            graphSum += get(boost::vertex_name, *graph, *vPair.first)->get_statementList().size();
+            for(std::pair<CFG::out_edge_iterator, CFG::out_edge_iterator> ePair = out_edges(*vPair.first, *graph);
+                ePair.first != ePair.second; ++ePair.first) {
+                CFG::vertex_descriptor successor = target(*ePair.first, *graph);
+                graphSum += get(boost::vertex_name, *graph, successor)->get_statementList().size();
+            }
+        }
+    }
+    std::clock_t graphTime = std::clock() - graphStart;
+
+    /* Traverse the compact snapshot */
+    std::clock_t compactStart = std::clock();
+    for(unsigned round = 0; round < rounds; ++round) {
+        for(unsigned number = 0; number < compact->size(); ++number) {
+            compactSum += compact->getBlock(number)->get_statementList().size();
+            for(const unsigned* successor = compact->successorsBegin(number);
+                successor != compact->successorsEnd(number); ++successor) {
+                compactSum += compact->getBlock(*successor)->get_statementList().size();
+            }
+        }
+    }
+    std::clock_t compactTime = std::clock() - compactStart;
+
+    std::cout << "cfg traversal rounds:" << std::dec << rounds
+              << " blocks:" << compact->size() << std::endl;
+    std::cout << "boost cfg ms:" << std::dec << (graphTime * 1000 / CLOCKS_PER_SEC)
+              << " sum:" << graphSum << std::endl;
+    std::cout << "compact cfg ms:" << std::dec << (compactTime * 1000 / CLOCKS_PER_SEC)
+              << " sum:" << compactSum << std::endl;
+}
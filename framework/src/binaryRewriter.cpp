@@ -1,6 +1,14 @@
 
 /* Framework header */
 #include "binaryRewriter.hpp"
+/* Policy key of the transform cache */
+#include <fstream>
+#include <cstring>
+#include <typeinfo>
+#include <stdint.h>
+
+/* The function being traversed by this thread, the instruction functions work on it */
+static __thread functionTransform* activeTransform = NULL;
 
 
 // Constructor which takes the path to the file as input.
@@ -10,6 +18,17 @@ BinaryRewriter::BinaryRewriter(int argc, char **binaryFile) {
     /* Set default values on some of the variables  */
     debugging = false;
     decisionsMade = 0;
+    allocationMode = NAIVE_ALLOCATION;
+    schedulingMode = NO_SCHEDULING;
+    hardening = NO_HARDENING;
+    hardeningVoter = VOTER_BITWISE_MAJORITY;
+    patterns = NULL;
+    /* transformDecision is called until a handler is registered */
+    instructionHandlers.assign(mips_last_instruction + 1, NULL);
+    dispatching = false;
+    fillDelaySlots = false;
+    workerThreads = 1;
+    nextFunction = 0;
 }
 
 
@@ -18,108 +37,596 @@ void BinaryRewriter::initialize(int argc, char **binaryFile) {
     
     //variables.
     decisionsMade = 0;
-
-    // Call frontend to parse the file, save it in the private variable.
-    binaryProjectPtr = frontend(argc, binaryFile);
+    debugging = false;
+    allocationMode = NAIVE_ALLOCATION;
+    schedulingMode = NO_SCHEDULING;
+    hardening = NO_HARDENING;
+    hardeningVoter = VOTER_BITWISE_MAJORITY;
+    patterns = NULL;
+    /* transformDecision is called until a handler is registered */
+    instructionHandlers.assign(mips_last_instruction + 1, NULL);
+    dispatching = false;
+    fillDelaySlots = false;
+    workerThreads = 1;
+    nextFunction = 0;
+    /* The binary is the last argument, the output is not written unless set */
+    inputFile = binaryFile[argc - 1];
+    outputFile = "";
+    growthReportFile = "";
+    measurementInputs.clear();
+    /* No transformed functions are reused unless a cache file is set */
+    transformCacheFile = "";
+    transformVersion = "";
+    policyKey = "";
+
+    /* Timers of this thread are added to the run */
+    setActiveStatistics(&statistics);
 
     /* initialize the cfghandler */
     cfgContainer = new CFGhandler;
+    binaryProjectPtr = NULL;
+    /*  The program is read from the cache of the binary when it matches,
+        the frontend is then not run. */
+    cfgCache programCache(argc, binaryFile);
+    {
+        phaseTimer timer(PHASE_PROGRAM_CFG);
+        CFG* cachedCFG = new CFG;
+        if (programCache.load(cachedCFG)) {
+            cfgContainer->initialize(cachedCFG);
+            return;
+        }
+        delete cachedCFG;
+    }
+
+    // Call frontend to parse the file, save it in the private variable.
+    {
+        phaseTimer timer(PHASE_FRONTEND);
+        binaryProjectPtr = frontend(argc, binaryFile);
+    }
+
     /* pass the project to build the programcfg */
+    phaseTimer timer(PHASE_PROGRAM_CFG);
     cfgContainer->initialize(binaryProjectPtr);
+    /* A binary the cache can not hold is parsed every time */
+    programCache.save(cfgContainer->getProgramCFG());
 }
 
 /* Used to select the function to be transformed and builds the functioncfg */
 void BinaryRewriter::functionSelect(std::string fName) {
+    phaseTimer timer(PHASE_FUNCTION_CFG);
     /* call on cfghandler to build the functioncfg */
     cfgContainer->createFunctionCFG(fName);
 }
 
 void BinaryRewriter::printInformation() {
     std::cout << "Decisions made " << decisionsMade << std::endl;
+    statistics.printStatistics();
 }
 
+/* Writes the phase timers and counters of the run as JSON */
+bool BinaryRewriter::writeStatistics(std::string file) {
+    return statistics.writeJSON(file);
+}
+
+/* Times traversals of the selected function cfg */
+void BinaryRewriter::benchmarkTraversal(unsigned rounds) {
+    benchmarkCFGTraversal(cfgContainer->getFunctionCFG(), cfgContainer->getCompactCFG(), rounds);
+}
+
+
+/*  Times the decision traversal of the selected function. The blocks are
+    traversed into a shadow list that is thrown away, so the decisions may
+    not insert instructions. Nothing is counted in the statistics. */
+void BinaryRewriter::benchmarkDecisions(unsigned rounds) {
+    functionTransform function;
+    function.name = cfgContainer->getFunctionName();
+    function.cfgContainer = cfgContainer;
+    activeTransform = &function;
+    cfgContainer->activate();
+    setActiveStatistics(NULL);
+    compactCFG* functionGraph = cfgContainer->getCompactCFG();
+    uint64_t virtualTime = 0;
+    uint64_t extensionTime = 0;
+    size_t kept = 0;
+    for(unsigned round = 0; round < rounds; ++round) {
+        for(int path = 0; path < 2; ++path) {
+            uint64_t start = monotonicNanoseconds();
+            for(unsigned number = 0; number < functionGraph->size(); ++number) {
+                SgAsmStatementPtrList shadowList;
+                function.shadowStatementListPtr = &shadowList;
+                if (path == 0) {
+                    /* Qualified, the per instruction virtual decisions */
+                    BinaryRewriter::traverseBlock(&function, &functionGraph->getBlock(number)->get_statementList());
+                } else {
+                    traverseBlock(&function, &functionGraph->getBlock(number)->get_statementList());
+                }
+                kept += shadowList.size();
+            }
+            (path == 0 ? virtualTime : extensionTime) += monotonicNanoseconds() - start;
+        }
+    }
+    function.shadowStatementListPtr = NULL;
+    activeTransform = NULL;
+    setActiveStatistics(&statistics);
+    std::cout << "decision traversal of " << std::dec << rounds << " rounds, virtual:"
+              << virtualTime / 1000 << "us extension:" << extensionTime / 1000
+              << "us instructions kept:" << kept << std::endl;
+}
 
 // Does the actual traversal and applies transformations to the binary.
 //This function will traverse the block cfg.
 void BinaryRewriter::transformBinary() {
+    /* The function selected with functionSelect */
+    functionTransform function;
+    function.name = cfgContainer->getFunctionName();
+    function.cfgContainer = cfgContainer;
+    if (transformCacheFile.empty() == false) {
+        functionCache.load(transformCacheFile);
+        policyKey = transformPolicy();
+    }
 
-    /* Traverse the function cfg and apply the user transformations.
-        Get the function CFG and traverse its blocks. */
-    CFG* functionGraph = cfgContainer->getFunctionCFG();
-
-    /* Iterater through all the blocks and apply transformations */
-    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*functionGraph);
-        vPair.first != vPair.second; ++vPair.first) {
-        /* get the basic block from the property map */
-        SgAsmBlock* currentBB = get(boost::vertex_name, *functionGraph, *vPair.first);
-        /* If debugging is active then print the block before transformation */
+    /* Run the original function in the interpreter with every input */
+    compactCFG* functionGraph = cfgContainer->getCompactCFG();
+    differentialHarness harness(cfgContainer->getProgramCFG(), measurementInputs);
+    bool measured = measurementInputs.empty() == false && functionGraph->size() != 0;
+    if (measured && harness.loadELF(inputFile) == false) {
+        std::cout << "function could not be run in the interpreter" << std::endl;
+        measured = false;
+    }
+    /* Calls go to the entry of the function, not always its first block */
+    rose_addr_t entry = measured ? cfgContainer->getFunctionEntry() : 0;
+    if (measured) {
+        harness.recordOriginal(entry);
+    }
+
+    transformFunction(&function);
+    decisionsMade += function.decisionsMade;
+    statistics.merge(function.statistics);
+    setActiveStatistics(&statistics);
+    /* A function that failed is neither compared nor written */
+    bool transformed = function.error.empty();
+
+    /*  Run the transformed function and compare. The statement lists are run
+        before the relocation, the inserted instructions are reached through
+        the lists. */
+    if (measured && transformed) {
+        harness.recordTransformed(entry);
+        harness.printReport();
+    }
+
+    /*  Give the function its new addresses when an output is written. It is
+        appended after the executable segment of the input, its original
+        entry jumps there. Without an output, or with an input that can not
+        be rewritten, the function keeps the input addresses. */
+    setActiveNodeRegistry(&function.nodes);
+    elfWriter writerObject;
+    bool writable = outputFile.empty() == false && transformed;
+    if (writable && writerObject.readInput(inputFile) == false) {
+        std::cout << writerObject.getError() << std::endl;
+        writable = false;
+    }
+    relocationHandler relocationObject(cfgContainer, writerObject.getAppendAddress());
+    if (writable) {
+        phaseTimer timer(PHASE_RELOCATION);
+        if (relocationObject.applyRelocation() == false) {
+            function.error = relocationObject.getError();
+            std::cout << "function " << function.name << " not relocated: " << function.error << std::endl;
+            writable = false;
+        }
+    }
+
+    /* Debug print */
+    if (debugging && writable) {
+        std::cout << "post relocation, function moved to 0x" << std::hex
+                  << relocationObject.getPlacement() << " and grew " << std::dec
+                  << relocationObject.getGrowth() << " bytes." << std::endl;
+        relocationObject.printStatistics();
+        printFunction(functionGraph);
+    }
+
+    /* Write the output binary */
+    if (writable) {
+        phaseTimer timer(PHASE_WRITE);
+        writerObject.addFunction(cfgContainer, &relocationObject);
+        if (writerObject.writeFile(outputFile) == false) {
+            std::cout << writerObject.getError() << ", " << outputFile << " not written" << std::endl;
+        } else if (debugging) {
+            writerObject.printStatistics();
+        }
+    } else if (outputFile.empty() == false && function.error.empty() == false) {
+        std::cout << outputFile << " not written" << std::endl;
+    }
+
+    /* Free the built nodes that did not end up in the function */
+    function.nodes.releaseUnused(cfgContainer->getFunctionCFG());
+    if (debugging) {
+        cfgContainer->getDecodeCache()->printStatistics();
+        function.nodes.printStatistics();
+    }
+    setActiveNodeRegistry(NULL);
+
+    /* Keep the transformed function for the next run */
+    if (transformCacheFile.empty() == false) {
+        functionCache.printStatistics();
+        functionCache.save(transformCacheFile);
+    }
+
+    /* Code growth of the function */
+    std::vector<functionTransform*> transformedFunctions(1, &function);
+    writeGrowthReports(transformedFunctions);
+}
+
+/*  STEPS of transformProgram
+        1. Give every selected function its own cfghandler sharing the
+        program cfg.
+
+        2. Workers take the functions in address order and transform them,
+        one worker on this thread unless setWorkerThreads asks for more.
+        A function only uses its own cfghandler, decode cache, symbolic
+        registers and node registry, node creation in ROSE is serialized.
+
+        3. Relocate the functions in address order on this thread. They
+        are appended one after the other after the executable segment, the
+        original code only gets the jumps at the entries.
+
+        4. Write all functions to the output and free the unused nodes.
+    The result does not depend on which worker transformed which function.
+*/
+void BinaryRewriter::transformProgram() {
+    std::vector<std::string> names = selectedFunctions;
+    if (names.empty()) {
+        names = cfgContainer->getFunctionNames();
+    }
+    std::vector<functionTransform*> functions;
+    for(std::vector<std::string>::iterator iter = names.begin();
+        iter != names.end(); ++iter) {
+        functionTransform* function = new functionTransform;
+        function->name = *iter;
+        function->cfgContainer = new CFGhandler;
+        function->cfgContainer->initialize(cfgContainer);
+        functions.push_back(function);
+    }
+    if (transformCacheFile.empty() == false) {
+        functionCache.load(transformCacheFile);
+        policyKey = transformPolicy();
+    }
+
+    /* Transform the functions, in parallel only when more workers are set */
+    nextFunction = 0;
+    unsigned threads = std::min(workerThreads, (unsigned)std::max((size_t)1, functions.size()));
+    if (threads == 1) {
+        transformWorker(&functions);
+    } else {
+        boost::thread_group workers;
+        for(unsigned index = 0; index < threads; ++index) {
+            workers.create_thread(boost::bind(&BinaryRewriter::transformWorker, this, &functions));
+        }
+        workers.join_all();
+    }
+    /* The statistics of the functions are added in the order they were selected */
+    setActiveStatistics(&statistics);
+    for(size_t index = 0; index < functions.size(); ++index) {
+        statistics.merge(functions[index]->statistics);
+    }
+
+    /* Merge in address order, a user selection can be in any order */
+    std::vector<std::pair<rose_addr_t, size_t> > order;
+    for(size_t index = 0; index < functions.size(); ++index) {
+        order.push_back(std::pair<rose_addr_t, size_t>(
+            functions[index]->cfgContainer->getAddressRange().second, index));
+    }
+    std::sort(order.begin(), order.end());
+
+    /*  Relocate in address order, every function is placed after the
+        previous one. Nothing outside a function is patched. */
+    elfWriter writerObject;
+    bool writable = outputFile.empty() == false && functions.empty() == false;
+    if (writable && writerObject.readInput(inputFile) == false) {
+        std::cout << writerObject.getError() << std::endl;
+        writable = false;
+    }
+    rose_addr_t placement = writerObject.getAppendAddress();
+    std::vector<relocationHandler*> relocations(functions.size(), NULL);
+    for(size_t index = 0; index < order.size() && writable; ++index) {
+        functionTransform* function = functions[order[index].second];
+        /* A function that failed keeps its original code */
+        if (function->error.empty() == false) {
+            continue;
+        }
+        function->cfgContainer->activate();
+        setActiveNodeRegistry(&function->nodes);
+        relocationHandler* relocation = new relocationHandler(function->cfgContainer, placement);
+        phaseTimer timer(PHASE_RELOCATION);
+        /* A refused function keeps its original code, the next one takes its place */
+        if (relocation->applyRelocation() == false) {
+            function->error = relocation->getError();
+            std::cout << "function " << function->name << " not relocated: " << function->error << std::endl;
+            delete relocation;
+            continue;
+        }
+        relocations[order[index].second] = relocation;
+        placement = relocation->getPlacementEnd();
+    }
+
+    /* Statistics in address order */
+    for(size_t index = 0; index < order.size(); ++index) {
+        functionTransform* function = functions[order[index].second];
+        decisionsMade += function->decisionsMade;
+        if (debugging && relocations[order[index].second] != NULL) {
+            std::cout << "post relocation, function " << function->name << " moved to 0x" << std::hex
+                      << relocations[order[index].second]->getPlacement() << " and grew " << std::dec
+                      << relocations[order[index].second]->getGrowth() << " bytes." << std::endl;
+            relocations[order[index].second]->printStatistics();
+            printFunction(function->cfgContainer->getCompactCFG());
+        }
+    }
+
+    /* Write every function into the output binary, in placement order */
+    if (writable) {
+        phaseTimer timer(PHASE_WRITE);
+        for(size_t index = 0; index < order.size(); ++index) {
+            if (relocations[order[index].second] != NULL) {
+                writerObject.addFunction(functions[order[index].second]->cfgContainer, relocations[order[index].second]);
+            }
+        }
+        if (writerObject.writeFile(outputFile) == false) {
+            std::cout << writerObject.getError() << ", " << outputFile << " not written" << std::endl;
+        } else if (debugging) {
+            writerObject.printStatistics();
+        }
+    }
+
+    /*  Free the nodes each function built and did not use, only its own
+        blocks are walked. The symbolic registers are the function's own. */
+    for(size_t index = 0; index < order.size(); ++index) {
+        functionTransform* function = functions[order[index].second];
+        function->cfgContainer->activate();
+        function->nodes.releaseUnused(function->cfgContainer->getFunctionCFG());
         if (debugging) {
-            std::cout << std::endl;
-            printBasicBlockInstructions(currentBB);
-        }
-        /* get the statement list of the block, which is the instructions */
-        SgAsmStatementPtrList* orgStmtPtrList = &currentBB->get_statementList();
-        /* Initialize the shadowstatement list */
-        shadowStatementListPtr = new SgAsmStatementPtrList;
-        /* Iterate through the statment list and check each instruction */
-        for(SgAsmStatementPtrList::iterator stmtIter = orgStmtPtrList->begin();
-            stmtIter != orgStmtPtrList->end(); ++stmtIter) {
-            /* Check that the statement is a mipsinstruction and if it is
-                forbidden or not. */
-            if ((*stmtIter)->variantT() == V_SgAsmMipsInstruction) {
-                /* cast the instruction to mips */
-                inspectedInstruction = isSgAsmMipsInstruction(*stmtIter);
-                /* check if the instruction is allowed to be transformed or not */ 
-                if(cfgContainer->isForbiddenInstruction(inspectedInstruction) == false) {
-                    /* The instruction is allowed to be transformed.
-                        Call the user decision function. */
-                    transformDecision(inspectedInstruction);
-                } else {
-                    /* Instruction is not allowed to be transformed save it and move on */
-                    saveInstruction();
-                    if (debugging) {
-                        std::cout << "Forbidden instruction, skip transform" << std::endl;
-                    }
-                }
+            std::cout << function->name << " ";
+            function->cfgContainer->getDecodeCache()->printStatistics();
+            std::cout << function->name << " ";
+            function->nodes.printStatistics();
+        }
+    }
+    setActiveNodeRegistry(NULL);
+    setActiveDecodeCache(NULL);
+    setActiveSymbolicContext(NULL);
+    if (transformCacheFile.empty() == false) {
+        functionCache.printStatistics();
+        functionCache.save(transformCacheFile);
+    }
+    writeGrowthReports(functions);
+    for(size_t index = 0; index < functions.size(); ++index) {
+        delete relocations[index];
+        delete functions[index]->cfgContainer;
+        delete functions[index];
+    }
+}
+
+/* Worker loop of transformProgram, takes functions until none are left */
+void BinaryRewriter::transformWorker(std::vector<functionTransform*>* functions) {
+    while (true) {
+        functionTransform* function;
+        {
+            boost::mutex::scoped_lock lock(functionMutex);
+            if (nextFunction >= functions->size()) {
+                return;
+            }
+            function = (*functions)[nextFunction++];
+        }
+        /* Extracting the function cfg activates its tables on this thread */
+        setActiveStatistics(&function->statistics);
+        {
+            phaseTimer timer(PHASE_FUNCTION_CFG);
+            function->cfgContainer->createFunctionCFG(function->name);
+        }
+        transformFunction(function);
+    }
+}
+
+//  Traverses the blocks of the function and applies the user transformations,
+//  then the register allocation, scheduling and delay slot filling.
+void BinaryRewriter::transformFunction(functionTransform* function) {
+    CFGhandler* functionContainer = function->cfgContainer;
+    /* The tables of the function are used by this thread */
+    activeTransform = function;
+    functionContainer->activate();
+    /* Record every node built during the transformation */
+    setActiveNodeRegistry(&function->nodes);
+    /* Time and count the function on its own statistics */
+    setActiveStatistics(&function->statistics);
+    countStatistic(COUNT_FUNCTIONS, 1);
+
+    /* The report counts the blocks before they are changed */
+    if (growthReportFile.empty() == false) {
+        function->growth = new growthReport(functionContainer, function->name);
+        function->growth->recordOriginal();
+    }
+
+    /*  A function that is unchanged since it was cached is rebuilt from the
+        cache, the fingerprint is taken before the blocks are changed. */
+    uint64_t functionPrint = 0;
+    std::vector<SgAsmStatement*> originalStatements;
+    std::set<SgAsmStatement*> userInstructions;
+    if (transformCacheFile.empty() == false) {
+        functionPrint = functionCache.fingerprint(functionContainer, policyKey, &originalStatements);
+        if (functionCache.restore(function->name, functionContainer, functionPrint, &function->decisionsMade,
+            &userInstructions)) {
+            if (debugging) {
+                std::cout << "function " << function->name << " restored from the transform cache" << std::endl;
+            }
+            if (function->growth != NULL) {
+                function->growth->recordInserted(userInstructions);
+                function->growth->recordFinal();
+            }
+            activeTransform = NULL;
+            return;
+        }
+    }
+
+    /* Traverse the function CFG and apply the user transformations.
+        Get the function CFG and traverse its blocks. */
+    compactCFG* functionGraph = functionContainer->getCompactCFG();
+    {
+        phaseTimer timer(PHASE_USER_TRAVERSAL);
+        /* Iterater through all the blocks and apply transformations */
+        for(unsigned number = 0; number < functionGraph->size(); ++number) {
+            /* get the basic block from the compact cfg */
+            SgAsmBlock* currentBB = functionGraph->getBlock(number);
+            /* If debugging is active then print the block before transformation */
+            if (debugging) {
+                std::cout << std::endl;
+                printBasicBlockInstructions(currentBB);
+            }
+            /* get the statement list of the block, which is the instructions */
+            SgAsmStatementPtrList* orgStmtPtrList = &currentBB->get_statementList();
+            /* Initialize the shadowstatement list */
+            function->shadowStatementListPtr = new SgAsmStatementPtrList;
+            /* Call the decisions on the instructions of the block */
+            traverseBlock(function, orgStmtPtrList);
+            /* The blocks statement list has been traversed. swap the list with
+                the shadow list and continue with the next block */
+            orgStmtPtrList->swap(*function->shadowStatementListPtr);
+            delete function->shadowStatementListPtr;
+            function->shadowStatementListPtr = NULL;
+            if (debugging) {
+                std::cout << "Block transformed" << std::endl;
+                printBasicBlockInstructions(currentBB);
             }
         }
-        /* The blocks statement list has been traversed. swap the list with
-            the shadow list and continue with the next block */
-        orgStmtPtrList->swap(*shadowStatementListPtr);
+    }
+    /* Sequences of the user and original instructions matched by the rules */
+    if (patterns != NULL) {
+        phaseTimer patternTimer(PHASE_PATTERN_REWRITE);
+        patterns->rewriteFunction(functionContainer);
+    }
+    /* The instructions without an address were inserted by the user */
+    if (function->growth != NULL || transformCacheFile.empty() == false) {
+        growthReport::findUserInstructions(functionContainer, &userInstructions);
+    }
+    if (function->growth != NULL) {
+        function->growth->recordInserted(userInstructions);
+    }
+    /* Framework hardening of the original instructions */
+    if (hardening == SYNC_POINT_TMR) {
+        syncPointTMR hardeningObject(functionContainer, hardeningVoter);
+        hardeningObject.applyTransformation();
         if (debugging) {
-            std::cout << "Block transformed" << std::endl;
-            printBasicBlockInstructions(currentBB);
+            hardeningObject.printStatistics();
         }
     }
+    /* The symbolic registers made for the function */
+    function->statistics.recordSymbolicRegisters(functionContainer->getSymbolicContext()->size());
     
-    /* Apply naive or optimized transformation. Currently just naive. */
-    naiveHandler naiveObject(cfgContainer);
-    /* Start naive framework transformation */
-    naiveObject.applyTransformation();
-
-    /* Debug print */
-    if (debugging) {
-        std::cout << "post framework transformation." << std::endl;
-        for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*functionGraph);
-            vPair.first != vPair.second; ++vPair.first) {
-            /* get the basic block from the property map */
-            SgAsmBlock* currentBB = get(boost::vertex_name, *functionGraph, *vPair.first);
-            /* Print the block */
-            std::cout << std::endl;
-            printBasicBlockInstructions(currentBB);
+    /* Apply the selected register allocation. */
+    {
+        phaseTimer timer(PHASE_REGISTER_ALLOCATION);
+        /* Hardening shadows live across original instructions */
+        registerAllocationMode functionAllocation = hardening == NO_HARDENING ? allocationMode : LINEAR_SCAN_ALLOCATION;
+        switch (functionAllocation) {
+            case LINEAR_SCAN_ALLOCATION: {
+                /* Liveness based allocation */
+                linearScanHandler linearScanObject(functionContainer);
+                if (linearScanObject.applyTransformation() == false) {
+                    function->error = linearScanObject.getError();
+                }
+                if (debugging) {
+                    linearScanObject.printStatistics();
+                }
+                break;
+            }
+            default: {
+                /* Start naive framework transformation */
+                naiveHandler naiveObject(functionContainer);
+                if (naiveObject.applyTransformation() == false) {
+                    function->error = naiveObject.getError();
+                }
+            }
         }
     }
+    /* A function that could not be allocated is left out of the output */
+    if (function->error.empty() == false) {
+        std::cout << "function " << function->name << " not transformed: " << function->error << std::endl;
+        delete function->growth;
+        function->growth = NULL;
+        activeTransform = NULL;
+        return;
+    }
 
-    /* Correct addresses */
+    /* Schedule the allocated instructions if selected. */
+    if (schedulingMode == LIST_SCHEDULING) {
+        phaseTimer timer(PHASE_SCHEDULING);
+        listScheduler schedulerObject(functionContainer);
+        schedulerObject.applyScheduling();
+        if (debugging) {
+            schedulerObject.printStatistics();
+        }
+    }
 
-    /* Debug print */
+    /* Move instructions into nop delay slots if enabled. */
+    if (fillDelaySlots) {
+        phaseTimer timer(PHASE_DELAY_SLOTS);
+        delaySlotFiller fillerObject(functionContainer);
+        fillerObject.applyFilling();
+        if (debugging) {
+            fillerObject.printStatistics();
+        }
+    }
 
-    /* Correct branch instructions */
+    /* Split the growth of the function */
+    if (function->growth != NULL) {
+        function->growth->recordFinal();
+    }
 
     /* Debug print */
+    if (debugging) {
+        std::cout << "post framework transformation." << std::endl;
+        printFunction(functionGraph);
+    }
+    /* Cache the transformed function for later runs */
+    if (transformCacheFile.empty() == false) {
+        functionCache.store(function->name, functionContainer, functionPrint, function->decisionsMade,
+            originalStatements, userInstructions);
+    }
+    activeTransform = NULL;
+}
 
-    /* Adjust segment sizes */
+/* Writes the growth reports in address order and frees them */
+void BinaryRewriter::writeGrowthReports(std::vector<functionTransform*>& functions) {
+    std::vector<std::pair<rose_addr_t, growthReport*> > ordered;
+    for(size_t index = 0; index < functions.size(); ++index) {
+        if (functions[index]->growth != NULL) {
+            ordered.push_back(std::make_pair(functions[index]->growth->getAddress(), functions[index]->growth));
+            functions[index]->growth = NULL;
+        }
+    }
+    if (ordered.empty()) {
+        return;
+    }
+    std::sort(ordered.begin(), ordered.end());
+    std::vector<growthReport*> reports;
+    for(size_t index = 0; index < ordered.size(); ++index) {
+        ordered[index].second->printStatistics();
+        reports.push_back(ordered[index].second);
+    }
+    if (growthReport::writeFile(reports, growthReportFile) == false) {
+        std::cout << "growth report " << growthReportFile << " could not be written" << std::endl;
+    }
+    for(size_t index = 0; index < reports.size(); ++index) {
+        delete reports[index];
+    }
+}
 
+/* Prints the blocks of a function cfg */
+void BinaryRewriter::printFunction(compactCFG* functionGraph) {
+    for(unsigned number = 0; number < functionGraph->size(); ++number) {
+        /* get the basic block from the compact cfg */
+        SgAsmBlock* currentBB = functionGraph->getBlock(number);
+        /* Print the block */
+        std::cout << std::endl;
+        printBasicBlockInstructions(currentBB);
+    }
 }
 
 
@@ -131,7 +638,7 @@ void BinaryRewriter::transformBinary() {
 //Here it will just be an empty function.
 void BinaryRewriter::transformDecision(SgAsmMipsInstruction* instPtr) {
     //std::cout << "Framework decision function" << std::endl;
-    decisionsMade++;
+    activeTransform->decisionsMade++;
     //printout of the instruction and the number of operands.
     saveInstruction();
 }
@@ -144,7 +651,10 @@ void BinaryRewriter::transformDecision(SgAsmMipsInstruction* instPtr) {
 //a user defined descision function.
 void BinaryRewriter::insertInstruction(SgAsmStatement* addedInstruction) {
     //The passed instruction from the user, inserted into the shadow list.
-    shadowStatementListPtr->push_back(addedInstruction);
+    activeTransform->shadowStatementListPtr->push_back(addedInstruction);
+    countStatistic(COUNT_INSERTED, 1);
+    /* The user may have changed the node after building it */
+    invalidateDecodedInstruction(isSgAsmMipsInstruction(addedInstruction));
 }
 
 //Removes an instruction during the transformation. Basically it will just
@@ -157,7 +667,42 @@ void BinaryRewriter::removeInstruction() {
 //This function will copy over the current instruction to the shadow statementlist.
 void BinaryRewriter::saveInstruction() {
     //insert the instruction at the end of the statement list.
-    shadowStatementListPtr->push_back(inspectedInstruction);
+    activeTransform->shadowStatementListPtr->push_back(activeTransform->inspectedInstruction);
+}
+
+/*  Calls the decision function or the registered handlers on the
+    instructions of a block, the kept and inserted instructions are put in
+    the shadow list of the function. */
+void BinaryRewriter::traverseBlock(functionTransform* function, SgAsmStatementPtrList* stmtList) {
+    /* Registered handlers replace the decision function */
+    if (dispatching) {
+        dispatchBlock(function, stmtList);
+        return;
+    }
+    /* Iterate through the statment list and check each instruction */
+    for(SgAsmStatementPtrList::iterator stmtIter = stmtList->begin();
+        stmtIter != stmtList->end(); ++stmtIter) {
+        /* Check that the statement is a mipsinstruction and if it is
+            forbidden or not. */
+        if ((*stmtIter)->variantT() == V_SgAsmMipsInstruction) {
+            /* cast the instruction to mips */
+            function->inspectedInstruction = isSgAsmMipsInstruction(*stmtIter);
+            /* check if the instruction is allowed to be transformed or not */ 
+            if(function->cfgContainer->isForbiddenInstruction(function->inspectedInstruction) == false) {
+                /* The instruction is allowed to be transformed.
+                    Call the user decision function. */
+                countStatistic(COUNT_INSPECTED, 1);
+                transformDecision(function->inspectedInstruction);
+            } else {
+                /* Instruction is not allowed to be transformed save it and move on */
+                countStatistic(COUNT_FORBIDDEN, 1);
+                saveInstruction();
+                if (debugging) {
+                    std::cout << "Forbidden instruction, skip transform" << std::endl;
+                }
+            }
+        }
+    }
 }
 
 
@@ -165,21 +710,189 @@ void BinaryRewriter::saveInstruction() {
 * Private functions for the framework
 ******************************************************************************/
 
+/*  Calls the registered handlers of a block. Runs of instructions without
+    a handler are copied to the shadow list in one go, they are neither
+    decoded nor checked against the forbidden instructions. */
+void BinaryRewriter::dispatchBlock(functionTransform* function, SgAsmStatementPtrList* stmtList) {
+    CFGhandler* functionContainer = function->cfgContainer;
+    SgAsmStatementPtrList::iterator runStart = stmtList->begin();
+    for(SgAsmStatementPtrList::iterator stmtIter = stmtList->begin();
+        stmtIter != stmtList->end(); ++stmtIter) {
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*stmtIter);
+        instructionHandler handler = mips == NULL ? NULL : instructionHandlers[mips->get_kind()];
+        if (mips != NULL && handler == NULL) {
+            continue;
+        }
+        /* End of a run, copy it */
+        function->shadowStatementListPtr->insert(function->shadowStatementListPtr->end(), runStart, stmtIter);
+        runStart = stmtIter + 1;
+        /* Statements that are not instructions are dropped like in the traversal */
+        if (mips == NULL) {
+            continue;
+        }
+        function->inspectedInstruction = mips;
+        if (functionContainer->isForbiddenInstruction(mips)) {
+            countStatistic(COUNT_FORBIDDEN, 1);
+            saveInstruction();
+        } else {
+            countStatistic(COUNT_INSPECTED, 1);
+            function->decisionsMade++;
+            (this->*handler)(mips);
+        }
+    }
+    function->shadowStatementListPtr->insert(function->shadowStatementListPtr->end(), runStart, stmtList->end());
+}
+
 
 /******************************************************************************
 * Configuration functions.
 ******************************************************************************/
 
 //Select method allocation method
-void BinaryRewriter::selectRegisterAllocation() {
-
+void BinaryRewriter::selectRegisterAllocation(registerAllocationMode mode) {
+    allocationMode = mode;
+}
+//  Registers the handler of an instruction kind, the instructions of kinds
+//  without a handler are kept as they are.
+void BinaryRewriter::registerHandler(MipsInstructionKind kind, instructionHandler handler) {
+    if (kind < 0 || (size_t)kind >= instructionHandlers.size()) {
+        ASSERT_not_reachable("BinaryRewriter: handler for an unknown instruction kind.");
+    }
+    instructionHandlers[kind] = handler;
+    dispatching = true;
 }
+
 //Select scheduling method.
-void BinaryRewriter::selectInstructionScheduling() {
+void BinaryRewriter::selectInstructionScheduling(instructionSchedulingMode mode) {
+    schedulingMode = mode;
+}
+
+//Select hardening and its voter.
+void BinaryRewriter::selectHardening(hardeningMode mode, voterKind kind) {
+    hardening = mode;
+    hardeningVoter = kind;
+}
+
+//Set the rules applied after the user traversal.
+void BinaryRewriter::setPatternRewriter(patternRewriter* rewriter) {
+    patterns = rewriter;
+    if (patterns != NULL) {
+        patterns->compile();
+    }
+}
+
+/* enable disable delay slot filling */
+void BinaryRewriter::setDelaySlotFilling(bool setting) {
+    fillDelaySlots = setting;
+}
+
+/* set the file the rewritten binary is written to */
+void BinaryRewriter::setOutputFile(std::string fileName) {
+    outputFile = fileName;
+}
+
+/* Set the file the growth report is written to */
+void BinaryRewriter::setGrowthReport(std::string file) {
+    growthReportFile = file;
+}
+
+/* Run the selected function in the interpreter with the arguments */
+void BinaryRewriter::setMeasurement(std::vector<uint32_t> arguments) {
+    harnessInput input;
+    input.arguments = arguments;
+    measurementInputs.push_back(input);
+}
+
+/* Run the selected function as main with the argv */
+void BinaryRewriter::addMeasurementArgv(std::vector<std::string> argv) {
+    harnessInput input;
+    input.argv = argv;
+    measurementInputs.push_back(input);
+}
+
+/* Run the selected function as main with generated argv */
+void BinaryRewriter::generateMeasurementArgv(unsigned count, unsigned seed) {
+    std::vector<harnessInput> generated = differentialHarness::generateArgv(count, seed);
+    measurementInputs.insert(measurementInputs.end(), generated.begin(), generated.end());
+}
+
+/* functions transformProgram transforms, all of them if empty */
+void BinaryRewriter::selectFunctions(std::vector<std::string> names) {
+    selectedFunctions = names;
+}
+
+/* number of worker threads of transformProgram */
+void BinaryRewriter::setWorkerThreads(unsigned threads) {
+    workerThreads = std::max(1u, threads);
+}
+
+/* File with the transformed functions of earlier runs */
+void BinaryRewriter::setTransformCache(std::string file) {
+    transformCacheFile = file;
+}
+
+/* Extra key of the user decisions, part of the cached fingerprints */
+void BinaryRewriter::setTransformVersion(std::string version) {
+    transformVersion = version;
+}
 
+/* Reference point of the handler addresses, in the same program image */
+static void handlerAnchor() {
+}
+
+/* FNV-1a hash of the running program, it holds the user decisions */
+static uint64_t hashProgramImage() {
+    std::ifstream image("/proc/self/exe", std::ios::in | std::ios::binary);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    char buffer[65536];
+    while (image) {
+        image.read(buffer, sizeof(buffer));
+        std::streamsize count = image.gcount();
+        for(std::streamsize index = 0; index < count; ++index) {
+            hash ^= (unsigned char)buffer[index];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+/*  STEPS of the policy key
+        1. The program image and the type of the rewriter, a rebuilt
+        extension with changed decisions or handlers gets a new key.
+        2. The kind of every registered handler and the handler. A member
+        pointer holds the address of the member, taken relative to a
+        function of the same image so it is the same in every run, or its
+        virtual table offset, and the adjustment of this.
+        3. The framework settings, the hardening and the pattern rules, and
+        the version set by the user. */
+std::string BinaryRewriter::transformPolicy() {
+    std::stringstream policy;
+    policy << std::hex << hashProgramImage() << "/" << typeid(*this).name();
+    for(size_t kind = 0; kind < instructionHandlers.size(); ++kind) {
+        if (instructionHandlers[kind] == NULL) {
+            continue;
+        }
+        uintptr_t handlerWords[sizeof(instructionHandler) / sizeof(uintptr_t)];
+        std::memcpy(handlerWords, &instructionHandlers[kind], sizeof(handlerWords));
+        /* Even words are member addresses, odd ones virtual table offsets */
+        if ((handlerWords[0] & 1) == 0) {
+            handlerWords[0] -= reinterpret_cast<uintptr_t>(&handlerAnchor);
+        }
+        policy << "/" << kind;
+        for(size_t word = 0; word < sizeof(handlerWords) / sizeof(uintptr_t); ++word) {
+            policy << ":" << handlerWords[word];
+        }
+    }
+    policy << std::dec << "/" << transformVersion << "/" << allocationMode << "/" << schedulingMode
+           << "/" << fillDelaySlots << "/" << hardening << "/" << hardeningVoter;
+    if (patterns != NULL) {
+        policy << "/" << patterns->describe();
+    }
+    return policy.str();
 }
 
 /* enable disable debugging */
 void BinaryRewriter::setDebug(bool setting) {
     debugging = setting;
+    cfgContainer->setDebug(setting);
 }
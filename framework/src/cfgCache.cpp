@@ -0,0 +1,435 @@
+/* Program cfg cache implementation */
+
+/* header file */
+#include "cfgCache.hpp"
+/* Operands of the rebuilt instructions */
+#include "symbolicRegisters.hpp"
+#include "nodeRegistry.hpp"
+/* File reading, writing and mapping */
+#include <fstream>
+#include <cstdio>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*  STEPS of the cache file
+        1. A header with a magic word, the format version, the hash and size
+        of the binary, the hash of the frontend arguments and the length of
+        every array.
+        2. The functions, their entry address and name.
+        3. The basic blocks, their address, function and instructions.
+        4. The block of every vertex of the program cfg and the edges as
+        vertex pairs, in the order of the cfg.
+        5. The instructions, the decoded operands of the known formats and
+        the raw bytes and mnemonic of every instruction.
+        6. The names, raw bytes and mnemonics packed into whole words. */
+
+/* Cache file format */
+static const uint64_t cacheMagic = 0x4746434350494d32ULL;
+static const uint64_t cacheVersion = 2;
+/* Block without a function */
+static const uint64_t noFunction = ~0ULL;
+/* Header words */
+enum cacheHeaderWord {
+    HEADER_MAGIC,
+    HEADER_VERSION,
+    HEADER_HASH,
+    HEADER_SIZE,
+    HEADER_ARGUMENTS,
+    HEADER_FUNCTIONS,
+    HEADER_BLOCKS,
+    HEADER_VERTICES,
+    HEADER_EDGES,
+    HEADER_INSTRUCTIONS,
+    HEADER_POOL_WORDS,
+    HEADER_WORDS
+};
+/* Words of a function */
+enum cacheFunctionWord {
+    FUNCTION_ENTRY,
+    FUNCTION_NAME,
+    FUNCTION_NAME_LENGTH,
+    FUNCTION_WORDS
+};
+/* Words of a block */
+enum cacheBlockWord {
+    BLOCK_ADDRESS,
+    BLOCK_FUNCTION,
+    BLOCK_FIRST,
+    BLOCK_COUNT,
+    BLOCK_WORDS
+};
+/*  Words of an instruction. The registers are one byte each, three
+    destinations then three sources in the order buildOperandList takes
+    them, and the two counts in the top bytes. */
+enum cacheInstructionWord {
+    INSTRUCTION_ADDRESS,
+    INSTRUCTION_KIND,
+    INSTRUCTION_FORMAT,
+    INSTRUCTION_REGISTERS,
+    INSTRUCTION_CONSTANT,
+    INSTRUCTION_CONSTANT_BITS,
+    INSTRUCTION_MEMORY,
+    INSTRUCTION_BYTES,
+    INSTRUCTION_BYTES_LENGTH,
+    INSTRUCTION_MNEMONIC_LENGTH,
+    INSTRUCTION_WORDS
+};
+
+/* FNV-1a of a byte */
+static void hashByte(uint64_t* hash, unsigned char byte) {
+    *hash ^= byte;
+    *hash *= 0x100000001b3ULL;
+}
+
+/* Appends bytes to the pool, returns their offset */
+static uint64_t poolBytes(std::string* pool, const std::string& bytes) {
+    uint64_t offset = pool->size();
+    pool->append(bytes);
+    return offset;
+}
+
+
+/* Constructor */
+cfgCache::cfgCache(int argc, char** arguments) {
+    binaryFile = arguments[argc - 1];
+    cacheFile = binaryFile + ".cfgcache";
+    binaryHash = 0;
+    binarySize = 0;
+    /* The frontend options between the program and the binary */
+    argumentHash = 0xcbf29ce484222325ULL;
+    for(int index = 1; index < argc - 1; ++index) {
+        for(const char* character = arguments[index]; *character != '\0'; ++character) {
+            hashByte(&argumentHash, *character);
+        }
+        hashByte(&argumentHash, 0);
+    }
+    hashBinary();
+}
+
+/* Name of the cache file */
+std::string cfgCache::getCacheFile() {
+    return cacheFile;
+}
+
+/* FNV-1a hash of the input binary */
+void cfgCache::hashBinary() {
+    std::ifstream input(binaryFile.c_str(), std::ios::in | std::ios::binary);
+    if (!input) {
+        return;
+    }
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint64_t size = 0;
+    char buffer[65536];
+    while (input) {
+        input.read(buffer, sizeof(buffer));
+        std::streamsize count = input.gcount();
+        for(std::streamsize index = 0; index < count; ++index) {
+            hashByte(&hash, buffer[index]);
+        }
+        size += count;
+    }
+    binaryHash = hash;
+    binarySize = size;
+}
+
+/* Writes the functions, blocks, instructions and edges of the program cfg */
+bool cfgCache::save(CFG* programCFG) {
+    if (binarySize == 0) {
+        return false;
+    }
+    std::vector<uint64_t> functionWords;
+    std::vector<uint64_t> blockWords;
+    std::vector<uint64_t> vertexWords;
+    std::vector<uint64_t> edgeWords;
+    std::vector<uint64_t> instructionWords;
+    std::string pool;
+    std::map<SgAsmFunction*, uint64_t> functionNumbers;
+    std::map<SgAsmBlock*, uint64_t> blockNumbers;
+    /* Blocks in vertex order, a block in the cfg twice is stored once */
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*programCFG);
+        vPair.first != vPair.second; ++vPair.first) {
+        SgAsmBlock* block = get(boost::vertex_name, *programCFG, *vPair.first);
+        std::pair<std::map<SgAsmBlock*, uint64_t>::iterator, bool> inserted =
+            blockNumbers.insert(std::make_pair(block, blockNumbers.size()));
+        vertexWords.push_back(inserted.first->second);
+        if (inserted.second == false) {
+            continue;
+        }
+        /* The function of the block */
+        uint64_t functionNumber = noFunction;
+        SgAsmFunction* function = block->get_enclosing_function();
+        if (function != NULL) {
+            std::pair<std::map<SgAsmFunction*, uint64_t>::iterator, bool> added =
+                functionNumbers.insert(std::make_pair(function, functionNumbers.size()));
+            if (added.second) {
+                functionWords.push_back(function->get_entry_va());
+                functionWords.push_back(poolBytes(&pool, function->get_name()));
+                functionWords.push_back(function->get_name().size());
+            }
+            functionNumber = added.first->second;
+        }
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        blockWords.push_back(block->get_address());
+        blockWords.push_back(functionNumber);
+        blockWords.push_back(instructionWords.size() / INSTRUCTION_WORDS);
+        blockWords.push_back(stmtList.size());
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            /* Only mips instructions can be rebuilt */
+            if (mips == NULL) {
+                return false;
+            }
+            instructionStruct decoded;
+            instructionType format = getInstructionFormat(mips->get_kind());
+            if (format != MIPS_UNKNOWN) {
+                decoded = decodeInstructionOperands(mips);
+            }
+            /*  decodeOpList gives the sources in operand order and
+                buildOperandList takes them from the back, store them reversed */
+            uint64_t registers = (uint64_t)decoded.destinationRegisters.size() << 48 |
+                (uint64_t)decoded.sourceRegisters.size() << 56;
+            for(unsigned index = 0; index < decoded.destinationRegisters.size(); ++index) {
+                if (decoded.destinationRegisters[index].regName == symbolic_reg) {
+                    return false;
+                }
+                registers |= (uint64_t)decoded.destinationRegisters[index].regName << (8 * index);
+            }
+            for(unsigned index = 0; index < decoded.sourceRegisters.size(); ++index) {
+                unsigned reversed = decoded.sourceRegisters.size() - 1 - index;
+                if (decoded.sourceRegisters[index].regName == symbolic_reg) {
+                    return false;
+                }
+                registers |= (uint64_t)decoded.sourceRegisters[index].regName << (8 * (3 + reversed));
+            }
+            SgUnsignedCharList raw = mips->get_raw_bytes();
+            std::string rawBytes(raw.begin(), raw.end());
+            instructionWords.push_back(mips->get_address());
+            instructionWords.push_back(mips->get_kind());
+            instructionWords.push_back(format);
+            instructionWords.push_back(registers);
+            instructionWords.push_back(decoded.instructionConstant);
+            instructionWords.push_back(decoded.significantBits | (uint64_t)decoded.isSignedConstant << 8);
+            instructionWords.push_back(decoded.memoryReferenceSize | (uint64_t)decoded.isSignedMemory << 8);
+            instructionWords.push_back(poolBytes(&pool, rawBytes));
+            instructionWords.push_back(rawBytes.size());
+            /* The mnemonic follows the raw bytes */
+            poolBytes(&pool, mips->get_mnemonic());
+            instructionWords.push_back(mips->get_mnemonic().size());
+        }
+    }
+    for(std::pair<CFGEIter, CFGEIter> edgePair = edges(*programCFG);
+        edgePair.first != edgePair.second; ++edgePair.first) {
+        edgeWords.push_back(source(*edgePair.first, *programCFG));
+        edgeWords.push_back(target(*edgePair.first, *programCFG));
+    }
+    size_t poolWords = (pool.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    pool.resize(poolWords * sizeof(uint64_t), '\0');
+
+    /* Header */
+    std::vector<uint64_t> words(HEADER_WORDS, 0);
+    words[HEADER_MAGIC] = cacheMagic;
+    words[HEADER_VERSION] = cacheVersion;
+    words[HEADER_HASH] = binaryHash;
+    words[HEADER_SIZE] = binarySize;
+    words[HEADER_ARGUMENTS] = argumentHash;
+    words[HEADER_FUNCTIONS] = functionWords.size() / FUNCTION_WORDS;
+    words[HEADER_BLOCKS] = blockWords.size() / BLOCK_WORDS;
+    words[HEADER_VERTICES] = vertexWords.size();
+    words[HEADER_EDGES] = edgeWords.size() / 2;
+    words[HEADER_INSTRUCTIONS] = instructionWords.size() / INSTRUCTION_WORDS;
+    words[HEADER_POOL_WORDS] = poolWords;
+    /* Arrays */
+    words.insert(words.end(), functionWords.begin(), functionWords.end());
+    words.insert(words.end(), blockWords.begin(), blockWords.end());
+    words.insert(words.end(), vertexWords.begin(), vertexWords.end());
+    words.insert(words.end(), edgeWords.begin(), edgeWords.end());
+    words.insert(words.end(), instructionWords.begin(), instructionWords.end());
+
+    /* Write to a temporary file and rename it, a reader never sees half a file */
+    std::string temporaryFile = cacheFile + ".tmp";
+    std::ofstream output(temporaryFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output) {
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(&words[0]), words.size() * sizeof(uint64_t));
+    output.write(pool.data(), pool.size());
+    output.close();
+    if (!output || std::rename(temporaryFile.c_str(), cacheFile.c_str()) != 0) {
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+/*  STEPS of load
+        1. Map the cache file and check the header against the binary, the
+        arguments and the file length.
+        2. Check every index and length in the arrays before a node is built.
+        3. Build the functions and the blocks, a block is a child of its
+        function so get_enclosing_function finds it.
+        4. Build the instructions with buildInstruction, they get their raw
+        bytes and mnemonic from the pool.
+        5. Add the vertices and edges in the cached order, the vertex
+        descriptors are then the same as when the cache was written. */
+bool cfgCache::load(CFG* programCFG) {
+    if (binarySize == 0) {
+        return false;
+    }
+    int descriptor = open(cacheFile.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat fileStatus;
+    if (fstat(descriptor, &fileStatus) != 0 || (size_t)fileStatus.st_size < HEADER_WORDS * sizeof(uint64_t)) {
+        close(descriptor);
+        return false;
+    }
+    size_t fileLength = fileStatus.st_size;
+    void* mapping = mmap(NULL, fileLength, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    const uint64_t* words = static_cast<const uint64_t*>(mapping);
+
+    /* Header */
+    bool valid = words[HEADER_MAGIC] == cacheMagic && words[HEADER_VERSION] == cacheVersion &&
+        words[HEADER_HASH] == binaryHash && words[HEADER_SIZE] == binarySize &&
+        words[HEADER_ARGUMENTS] == argumentHash;
+    uint64_t functionCount = words[HEADER_FUNCTIONS];
+    uint64_t blockCount = words[HEADER_BLOCKS];
+    uint64_t vertexCount = words[HEADER_VERTICES];
+    uint64_t edgeCount = words[HEADER_EDGES];
+    uint64_t instructionCount = words[HEADER_INSTRUCTIONS];
+    uint64_t poolWords = words[HEADER_POOL_WORDS];
+    uint64_t wordCount = HEADER_WORDS + FUNCTION_WORDS * functionCount + BLOCK_WORDS * blockCount +
+        vertexCount + 2 * edgeCount + INSTRUCTION_WORDS * instructionCount + poolWords;
+    if (valid == false || wordCount * sizeof(uint64_t) != fileLength) {
+        munmap(mapping, fileLength);
+        return false;
+    }
+    const uint64_t* functionWords = words + HEADER_WORDS;
+    const uint64_t* blockWords = functionWords + FUNCTION_WORDS * functionCount;
+    const uint64_t* vertexWords = blockWords + BLOCK_WORDS * blockCount;
+    const uint64_t* edgeWords = vertexWords + vertexCount;
+    const uint64_t* instructionWords = edgeWords + 2 * edgeCount;
+    const char* pool = reinterpret_cast<const char*>(instructionWords + INSTRUCTION_WORDS * instructionCount);
+    uint64_t poolLength = poolWords * sizeof(uint64_t);
+
+    /* Every index and byte range has to fit */
+    for(uint64_t number = 0; number < functionCount && valid; ++number) {
+        const uint64_t* function = functionWords + FUNCTION_WORDS * number;
+        valid = function[FUNCTION_NAME] <= poolLength &&
+            function[FUNCTION_NAME_LENGTH] <= poolLength - function[FUNCTION_NAME];
+    }
+    for(uint64_t number = 0; number < blockCount && valid; ++number) {
+        const uint64_t* block = blockWords + BLOCK_WORDS * number;
+        valid = (block[BLOCK_FUNCTION] == noFunction || block[BLOCK_FUNCTION] < functionCount) &&
+            block[BLOCK_FIRST] <= instructionCount && block[BLOCK_COUNT] <= instructionCount - block[BLOCK_FIRST];
+    }
+    for(uint64_t vertex = 0; vertex < vertexCount && valid; ++vertex) {
+        valid = vertexWords[vertex] < blockCount;
+    }
+    for(uint64_t edge = 0; edge < 2 * edgeCount && valid; ++edge) {
+        valid = edgeWords[edge] < vertexCount;
+    }
+    for(uint64_t number = 0; number < instructionCount && valid; ++number) {
+        const uint64_t* instruction = instructionWords + INSTRUCTION_WORDS * number;
+        uint64_t registers = instruction[INSTRUCTION_REGISTERS];
+        uint64_t bytesLength = instruction[INSTRUCTION_BYTES_LENGTH];
+        valid = instruction[INSTRUCTION_KIND] <= mips_last_instruction &&
+            instruction[INSTRUCTION_FORMAT] == (uint64_t)getInstructionFormat((MipsInstructionKind)instruction[INSTRUCTION_KIND]) &&
+            (registers >> 48 & 0xff) <= maxRegisterOperands && (registers >> 56) <= maxRegisterOperands &&
+            instruction[INSTRUCTION_BYTES] <= poolLength && bytesLength <= poolLength - instruction[INSTRUCTION_BYTES] &&
+            instruction[INSTRUCTION_MNEMONIC_LENGTH] <= poolLength - instruction[INSTRUCTION_BYTES] - bytesLength;
+        for(unsigned index = 0; index < 6 && valid; ++index) {
+            valid = (registers >> (8 * index) & 0xff) < symbolic_reg;
+        }
+    }
+    if (valid == false) {
+        munmap(mapping, fileLength);
+        return false;
+    }
+
+    /* Functions */
+    std::vector<SgAsmFunction*> functions(functionCount, NULL);
+    for(uint64_t number = 0; number < functionCount; ++number) {
+        const uint64_t* cached = functionWords + FUNCTION_WORDS * number;
+        SgAsmFunction* function = new SgAsmFunction;
+        function->set_name(std::string(pool + cached[FUNCTION_NAME], cached[FUNCTION_NAME_LENGTH]));
+        function->set_entry_va(cached[FUNCTION_ENTRY]);
+        function->set_address(cached[FUNCTION_ENTRY]);
+        functions[number] = function;
+    }
+    /*  The operands are built with the shared physical registers of a
+        context for the loaded program, no function is selected yet. The
+        nodes are not tracked and live as long as the program. */
+    symbolicRegisterContext programContext;
+    setActiveSymbolicContext(&programContext);
+    setActiveNodeRegistry(NULL);
+    std::vector<SgAsmBlock*> blocks(blockCount, NULL);
+    for(uint64_t number = 0; number < blockCount; ++number) {
+        const uint64_t* cached = blockWords + BLOCK_WORDS * number;
+        SgAsmBlock* block = new SgAsmBlock;
+        block->set_address(cached[BLOCK_ADDRESS]);
+        if (cached[BLOCK_FUNCTION] != noFunction) {
+            SgAsmFunction* function = functions[cached[BLOCK_FUNCTION]];
+            function->get_statementList().push_back(block);
+            block->set_parent(function);
+        }
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        for(uint64_t index = 0; index < cached[BLOCK_COUNT]; ++index) {
+            const uint64_t* instruction = instructionWords + INSTRUCTION_WORDS * (cached[BLOCK_FIRST] + index);
+            uint64_t registers = instruction[INSTRUCTION_REGISTERS];
+            instructionStruct instStruct;
+            instStruct.kind = (MipsInstructionKind)instruction[INSTRUCTION_KIND];
+            instStruct.mnemonic = instructionMnemonic(instStruct.kind);
+            instStruct.format = (instructionType)instruction[INSTRUCTION_FORMAT];
+            instStruct.address = instruction[INSTRUCTION_ADDRESS];
+            for(unsigned count = 0; count < (registers >> 48 & 0xff); ++count) {
+                registerStruct reg;
+                reg.regName = (mipsRegisterName)(registers >> (8 * count) & 0xff);
+                instStruct.destinationRegisters.push_back(reg);
+            }
+            for(unsigned count = 0; count < (registers >> 56); ++count) {
+                registerStruct reg;
+                reg.regName = (mipsRegisterName)(registers >> (8 * (3 + count)) & 0xff);
+                instStruct.sourceRegisters.push_back(reg);
+            }
+            instStruct.instructionConstant = instruction[INSTRUCTION_CONSTANT];
+            instStruct.significantBits = instruction[INSTRUCTION_CONSTANT_BITS] & 0xff;
+            instStruct.isSignedConstant = (instruction[INSTRUCTION_CONSTANT_BITS] >> 8) != 0;
+            instStruct.memoryReferenceSize = instruction[INSTRUCTION_MEMORY] & 0xff;
+            instStruct.isSignedMemory = (instruction[INSTRUCTION_MEMORY] >> 8) != 0;
+            SgAsmMipsInstruction* mips = buildInstruction(&instStruct);
+            /* Unknown formats keep an empty operand list like a decoded one */
+            if (mips->get_operandList() == NULL) {
+                SgAsmOperandList* operands = new SgAsmOperandList;
+                mips->set_operandList(operands);
+                operands->set_parent(mips);
+            }
+            const char* bytes = pool + instruction[INSTRUCTION_BYTES];
+            uint64_t bytesLength = instruction[INSTRUCTION_BYTES_LENGTH];
+            mips->set_raw_bytes(SgUnsignedCharList(bytes, bytes + bytesLength));
+            mips->set_mnemonic(std::string(bytes + bytesLength, instruction[INSTRUCTION_MNEMONIC_LENGTH]));
+            mips->set_parent(block);
+            stmtList.push_back(mips);
+        }
+        blocks[number] = block;
+    }
+    setActiveSymbolicContext(NULL);
+
+    /* Vertices and edges in the cached order */
+    for(uint64_t vertex = 0; vertex < vertexCount; ++vertex) {
+        add_vertex(blocks[vertexWords[vertex]], *programCFG);
+    }
+    for(uint64_t edge = 0; edge < edgeCount; ++edge) {
+        add_edge(edgeWords[2 * edge], edgeWords[2 * edge + 1], *programCFG);
+    }
+    munmap(mapping, fileLength);
+    return true;
+}
@@ -2,6 +2,21 @@
 
 #include "cfgHandler.hpp"
 
+/* Constructor */
+CFGhandler::CFGhandler() {
+    programCFG = NULL;
+    functionCFG = NULL;
+    programIndex = NULL;
+    activationPair.first = NULL;
+    activationPair.second = NULL;
+    debugging = false;
+}
+
+/* Print the activation records and address range when set */
+void CFGhandler::setDebug(bool setting) {
+    debugging = setting;
+}
+
 /* setup for this class */
 void CFGhandler::initialize(SgProject* root) {
     /* With the SgProject build the programcfg and save it */
@@ -10,6 +25,93 @@ void CFGhandler::initialize(SgProject* root) {
     rose::BinaryAnalysis::ControlFlow cfganalyzer;
     programCFG = new CFG;
     cfganalyzer.build_block_cfg_from_ast(interpretation.back(), *programCFG);
+    /* Index the blocks of the functions once */
+    programIndex = new functionBlockIndex;
+    buildFunctionIndex();
+}
+
+/* setup with a program cfg read from the cache */
+void CFGhandler::initialize(CFG* cachedCFG) {
+    programCFG = cachedCFG;
+    /* Index the blocks of the functions once */
+    programIndex = new functionBlockIndex;
+    buildFunctionIndex();
+}
+
+/* setup with an already built program cfg, it is shared and not changed */
+void CFGhandler::initialize(CFGhandler* programHandler) {
+    programCFG = programHandler->programCFG;
+    programIndex = programHandler->programIndex;
+    debugging = programHandler->debugging;
+}
+
+/*  Builds the function index. Every vertex is numbered by its function and
+    given its position in the function, the vertices and the edges with both
+    ends in the same function are then placed by function with a counting
+    sort, keeping the program order inside each function. */
+void CFGhandler::buildFunctionIndex() {
+    size_t vertexCount = num_vertices(*programCFG);
+    /* Function number and position of every vertex, blocks that are in the
+        cfg twice or have no function are left out like before. */
+    const size_t notIndexed = std::numeric_limits<size_t>::max();
+    std::vector<size_t> vertexFunction(vertexCount, notIndexed);
+    std::vector<size_t> vertexPosition(vertexCount, 0);
+    std::vector<size_t> functionVertices;
+    boost::unordered_map<SgAsmBlock*, bool> visitedBlock;
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*programCFG);
+        vPair.first != vPair.second; ++vPair.first) {
+        SgAsmBlock* block = get(boost::vertex_name, *programCFG, *vPair.first);
+        SgAsmFunction* function = block->get_enclosing_function();
+        if (function == NULL || visitedBlock.insert(std::make_pair(block, true)).second == false) {
+            continue;
+        }
+        std::pair<boost::unordered_map<std::string, size_t>::iterator, bool> inserted =
+            programIndex->functionNumbers.insert(std::make_pair(function->get_name(), programIndex->names.size()));
+        if (inserted.second) {
+            programIndex->names.push_back(function->get_name());
+            functionVertices.push_back(0);
+        }
+        size_t number = inserted.first->second;
+        vertexFunction[*vPair.first] = number;
+        vertexPosition[*vPair.first] = functionVertices[number]++;
+    }
+    size_t functionCount = programIndex->names.size();
+    /* Vertex ranges */
+    programIndex->vertexStart.assign(functionCount + 1, 0);
+    for(size_t number = 0; number < functionCount; ++number) {
+        programIndex->vertexStart[number + 1] = programIndex->vertexStart[number] + functionVertices[number];
+    }
+    programIndex->vertices.resize(programIndex->vertexStart[functionCount]);
+    for(size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        if (vertexFunction[vertex] != notIndexed) {
+            programIndex->vertices[programIndex->vertexStart[vertexFunction[vertex]] + vertexPosition[vertex]] = vertex;
+        }
+    }
+    /* Edges inside a function, counted first then placed */
+    std::vector<size_t> functionEdges(functionCount, 0);
+    for(std::pair<CFGEIter, CFGEIter> edgePair = edges(*programCFG);
+        edgePair.first != edgePair.second; ++edgePair.first) {
+        size_t sourceFunction = vertexFunction[source(*edgePair.first, *programCFG)];
+        if (sourceFunction != notIndexed && sourceFunction == vertexFunction[target(*edgePair.first, *programCFG)]) {
+            functionEdges[sourceFunction]++;
+        }
+    }
+    programIndex->edgeStart.assign(functionCount + 1, 0);
+    for(size_t number = 0; number < functionCount; ++number) {
+        programIndex->edgeStart[number + 1] = programIndex->edgeStart[number] + functionEdges[number];
+        functionEdges[number] = programIndex->edgeStart[number];
+    }
+    programIndex->edges.resize(programIndex->edgeStart[functionCount]);
+    for(std::pair<CFGEIter, CFGEIter> edgePair = edges(*programCFG);
+        edgePair.first != edgePair.second; ++edgePair.first) {
+        CFG::vertex_descriptor sourceVertex = source(*edgePair.first, *programCFG);
+        CFG::vertex_descriptor targetVertex = target(*edgePair.first, *programCFG);
+        size_t sourceFunction = vertexFunction[sourceVertex];
+        if (sourceFunction != notIndexed && sourceFunction == vertexFunction[targetVertex]) {
+            programIndex->edges[functionEdges[sourceFunction]++] =
+                std::make_pair(vertexPosition[sourceVertex], vertexPosition[targetVertex]);
+        }
+    }
 }
 
 /* returns the function cfg */
@@ -17,28 +119,92 @@ CFG* CFGhandler::getFunctionCFG() {
     return functionCFG;
 }
 
+/* returns the name of the selected function */
+std::string CFGhandler::getFunctionName() {
+    return functionName;
+}
+
+/* returns the compact snapshot of the function cfg */
+compactCFG* CFGhandler::getCompactCFG() {
+    return &functionBlocks;
+}
+
 /* returns the program cfg */
 CFG* CFGhandler::getProgramCFG() {
     return programCFG;
 }
 
+/* returns the relocation map */
+relocationMap* CFGhandler::getRelocationMap() {
+    return &addressMap;
+}
+
+/* return the decode cache of the function */
+decodeCache* CFGhandler::getDecodeCache() {
+    return &functionDecodeCache;
+}
+
+/* return the symbolic registers of the function */
+symbolicRegisterContext* CFGhandler::getSymbolicContext() {
+    return &functionSymbolicRegisters;
+}
+
+/* Makes the tables of the function the active ones of the calling thread */
+void CFGhandler::activate() {
+    setActiveDecodeCache(&functionDecodeCache);
+    setActiveSymbolicContext(&functionSymbolicRegisters);
+}
+
+/* Highest and lowest instruction address of the function cfg */
+std::pair<rose_addr_t, rose_addr_t> CFGhandler::getAddressRange() {
+    return addressRange;
+}
+
+/* Entry address of the function */
+rose_addr_t CFGhandler::getFunctionEntry() {
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*functionCFG);
+        vPair.first != vPair.second; ++vPair.first) {
+        SgAsmBlock* block = get(boost::vertex_name, *functionCFG, *vPair.first);
+        if (block->get_enclosing_function() != NULL) {
+            return block->get_enclosing_function()->get_entry_va();
+        }
+    }
+    /* No function node, the lowest block is the entry */
+    return addressRange.second;
+}
+
+/* Names of all functions in the program, ordered on their lowest block */
+std::vector<std::string> CFGhandler::getFunctionNames() {
+    /* Order on the address, the name decides between equal addresses */
+    std::vector<std::pair<rose_addr_t, std::string> > ordered;
+    for(size_t number = 0; number < programIndex->names.size(); ++number) {
+        rose_addr_t start = std::numeric_limits<rose_addr_t>::max();
+        for(size_t position = programIndex->vertexStart[number];
+            position < programIndex->vertexStart[number + 1]; ++position) {
+            SgAsmBlock* block = get(boost::vertex_name, *programCFG, programIndex->vertices[position]);
+            start = std::min(start, block->get_address());
+        }
+        ordered.push_back(std::pair<rose_addr_t, std::string>(start, programIndex->names[number]));
+    }
+    std::sort(ordered.begin(), ordered.end());
+    std::vector<std::string> names;
+    for(size_t index = 0; index < ordered.size(); ++index) {
+        names.push_back(ordered[index].second);
+    }
+    return names;
+}
+
 /* Get the new address for the instruction */
 rose_addr_t CFGhandler::getNewAddress(rose_addr_t oldAddress) {
-    /* search address map for entry */
-    return instructionMap.find(oldAddress)->second;
+    /* search address map for entry, addresses not moved are returned as is */
+    return addressMap.translate(oldAddress);
 }
 
 
 /* Check if the address has been relocated */
 bool CFGhandler::hasNewAddress(rose_addr_t instructionAddress) {
-    /* search address map for entry */
-    int found = instructionMap.count(instructionAddress);
-    /* address i present then found is 1, otherwise 0 */
-    if (found == 1) {
-        return true;
-    } else {
-        return false;
-    }
+    /* search address map for the interval containing the address */
+    return addressMap.isMoved(instructionAddress);
 }
 
 
@@ -69,45 +235,34 @@ bool CFGhandler::isForbiddenInstruction(SgAsmMipsInstruction* inst) {
     These are saved for later use and also added to the forbidden
     instructions map. */
 void CFGhandler::findActivationRecords() {
-    /* Vector for edges */ 
-    std::set<CFG::vertex_descriptor> targetVertices;
-    std::set<CFG::vertex_descriptor> sourceVertices;
-    /* Block statement lists */
-    SgAsmStatementPtrList* firstStatementList;
-    SgAsmStatementPtrList* lastStatementList;
-    
-    for(std::pair<CFGEIter, CFGEIter> edgeIter = edges(*functionCFG);
-        edgeIter.first != edgeIter.second; ++edgeIter.first) {
-        /* retrieve each edges target and source and save */
-        targetVertices.insert(target(*edgeIter.first, *functionCFG));
-        sourceVertices.insert(source(*edgeIter.first, *functionCFG));
-    }
+    /* Block statement lists, NULL when the function has no such block */
+    SgAsmStatementPtrList* firstStatementList = NULL;
+    SgAsmStatementPtrList* lastStatementList = NULL;
 
-    /* At this point all vertices that are either a target or a source
-        for a edge is saved. The first and last block will only be
-        present as a target or source. */
-    for(std::set<CFG::vertex_descriptor>::iterator iter = sourceVertices.begin();
-        iter != sourceVertices.end(); ++iter) {
-        /* Find the source vertex that is not among the target vertices.
-            That vertex is the entry vertex */
-        if (targetVertices.count(*iter) == 0) {
+    /*  The first block is only the source of edges and the last block only
+        the target. Blocks are checked in vertex order like before, the last
+        match is used. */
+    for(CFG::vertex_descriptor vertex = 0; vertex < functionBlocks.size(); ++vertex) {
+        unsigned number = functionBlocks.getNumber(vertex);
+        if (functionBlocks.successorCount(number) > 0 && functionBlocks.predecessorCount(number) == 0) {
             /* The current vertex is the first block in the instruction,
                 save the vertex block as firstBlock */
-            SgAsmBlock* firstBlock = get(boost::vertex_name, *functionCFG, (*iter));
-            firstStatementList = &firstBlock->get_statementList();
+            firstStatementList = &functionBlocks.getBlock(number)->get_statementList();
         }
     }
-    for(std::set<CFG::vertex_descriptor>::iterator iter = targetVertices.begin();
-        iter != targetVertices.end(); ++iter) {
-        /* Find the target vertex that is not among the source vertices.
-            That vertex is the exit vertex */
-        if (sourceVertices.count(*iter) == 0) {
+    for(CFG::vertex_descriptor vertex = 0; vertex < functionBlocks.size(); ++vertex) {
+        unsigned number = functionBlocks.getNumber(vertex);
+        if (functionBlocks.predecessorCount(number) > 0 && functionBlocks.successorCount(number) == 0) {
             /* The current vertex is the last block in the instruction,
                 save the vertex block as lastBlock */
-            SgAsmBlock* lastBlock = get(boost::vertex_name, *functionCFG, (*iter));
-            lastStatementList = &lastBlock->get_statementList();
+            lastStatementList = &functionBlocks.getBlock(number)->get_statementList();
         }
     }
+    /*  A single block, a loop at the start or a loop at the end leaves one of
+        them out, the function is then treated as having no activation record. */
+    if (firstStatementList == NULL || lastStatementList == NULL) {
+        return;
+    }
 
     /* Go through the blocks and find the activation records.
         The instruction in question is an addiu instruction with
@@ -116,6 +271,9 @@ void CFGhandler::findActivationRecords() {
         iter != firstStatementList->end(); ++iter) {
         /* decode instruction */
         SgAsmMipsInstruction* mipsInst = isSgAsmMipsInstruction(*iter);
+        if (mipsInst == NULL) {
+            continue;
+        }
         instructionStruct currentInst = decodeInstruction(mipsInst);
         /* check instruction */
         if (currentInst.kind == mips_addiu) {
@@ -129,7 +287,9 @@ void CFGhandler::findActivationRecords() {
                 activationPair.first = mipsInst;
                 /* Add the instruction to the activation instruction vector */
                 activationInstruction.push_back(mipsInst);
-                std::cout << "forbidden instruction found: " << std::hex << currentInst.address << std::endl;
+                if (debugging) {
+                    std::cout << "forbidden instruction found: " << std::hex << currentInst.address << std::endl;
+                }
             }
         }
     }
@@ -138,6 +298,9 @@ void CFGhandler::findActivationRecords() {
         iter != lastStatementList->end(); ++iter) {
         /* decode instruction */
         SgAsmMipsInstruction* mipsInst = isSgAsmMipsInstruction(*iter);
+        if (mipsInst == NULL) {
+            continue;
+        }
         instructionStruct currentInst = decodeInstruction(mipsInst);
         /* check instruction */
         if (currentInst.kind == mips_addiu) {
@@ -151,7 +314,9 @@ void CFGhandler::findActivationRecords() {
                 activationPair.second = mipsInst;
                 /* Add the instruction to the activation instruction vector */
                 activationInstruction.push_back(mipsInst);
-                std::cout << "forbidden instruction found: " << std::hex << currentInst.address << std::endl;
+                if (debugging) {
+                    std::cout << "forbidden instruction found: " << std::hex << currentInst.address << std::endl;
+                }
             }
         }
     }
@@ -164,7 +329,9 @@ void CFGhandler::findAddressRange() {
     rose_addr_t lowestAddr = std::numeric_limits<rose_addr_t>::max();
     rose_addr_t highestAddr = std::numeric_limits<rose_addr_t>::min();
 
-    std::cout << "Highest: " << std::hex << highestAddr  << " Lowest: " << lowestAddr << std::endl;
+    if (debugging) {
+        std::cout << "Highest: " << std::hex << highestAddr  << " Lowest: " << lowestAddr << std::endl;
+    }
 
     /* Go through the basic blocks and look at the first
         and last address compare to previous values and save */
@@ -198,7 +365,9 @@ void CFGhandler::findAddressRange() {
     /* The highest and lowest address in the function cfg has been found, save it*/
     addressRange.first = highestAddr;
     addressRange.second = lowestAddr;
-    std::cout << "Highest: " << std::hex << addressRange.first << " Lowest: " << addressRange.second << std::endl;
+    if (debugging) {
+        std::cout << "Highest: " << std::hex << addressRange.first << " Lowest: " << addressRange.second << std::endl;
+    }
 }
 
 /* Makes a cfg for a specific function */
@@ -207,68 +376,34 @@ void CFGhandler::createFunctionCFG(std::string newFunctionName) {
     functionName = newFunctionName;
     /* New cfg variable */
     functionCFG = new CFG;
-    /* track visited blocks */
-    std::map<SgAsmBlock *, bool> visitedBlock;
-    /* track mapping between programcfg and functioncfg vertices */
-    std::map<CFG::vertex_descriptor, CFG::vertex_descriptor> vertexMap;
-    /* keep track of which blocks are included in the functioncfg */
-    std::map<CFG::vertex_descriptor, bool> copiedVertex;
-
-    /*  Get the property map of the function cfg   */
+    /* Nothing has been relocated in this function yet */
+    addressMap.clear();
+    /* Decode the instructions of this function into its own cache */
+    functionDecodeCache.clear();
+    /* Symbolic registers are numbered per function */
+    functionSymbolicRegisters.clear();
+    activate();
+    /* No activation records found yet */
+    activationPair.first = NULL;
+    activationPair.second = NULL;
+    /*  Copy the vertices and edges of the function from the index, the
+        work is proportional to the size of the function. */
     boost::property_map<CFG, boost::vertex_name_t>::type functionPropMap = get(boost::vertex_name, *functionCFG);
-
-    /*  Go through all vertices (blocks) and find blocks belonging to the
-        function that is being extracted.   */
-    for(std::pair<CFGVIter, CFGVIter> verticePair = vertices(*programCFG);
-        verticePair.first != verticePair.second; ++verticePair.first) {
-        /*  Get the SgAsmBlock from the propertymap and check the name*/
-        SgAsmBlock* basicBlock = get(boost::vertex_name, *programCFG, *verticePair.first); 
-        /*  See if a vertex has been visited    */
-        if (visitedBlock.find(basicBlock) == visitedBlock.end()) {
-            /* Set the block as visited */
-            visitedBlock.insert(std::pair<SgAsmBlock*, bool>(basicBlock, true));
-            /*  Retrieve the enclosing function, i.e the function the block
-                belongs to. */
-            SgAsmFunction* blockFunction = basicBlock->get_enclosing_function();
-            /* Check the functions name with the passed name */
-            if (functionName.compare(blockFunction->get_name()) == 0) {
-                /*  The block belongs to the desired function add it to
-                    the function CFG. */
-                CFG::vertex_descriptor newVertex = add_vertex(*functionCFG);
-                /* set the values of the property map in the new CFG */
-                put(functionPropMap, newVertex, basicBlock);
-                /*  Save the vertex descriptor so i know which vertexes
-                    have been copies */
-                copiedVertex.insert(std::pair<CFG::vertex_descriptor, bool>(*verticePair.first , true));
-                /* Add both vertices to the vertexmap */
-                vertexMap.insert(std::pair<CFG::vertex_descriptor, CFG::vertex_descriptor>
-                (*verticePair.first, newVertex));
-            } else {
-                /*  The block does not belong to a desired function, set it
-                    as not copied */
-                copiedVertex.insert(std::pair<CFG::vertex_descriptor, bool>(*verticePair.first, false));
-            }
+    boost::unordered_map<std::string, size_t>::iterator found = programIndex->functionNumbers.find(functionName);
+    if (found != programIndex->functionNumbers.end()) {
+        size_t number = found->second;
+        for(size_t position = programIndex->vertexStart[number]; position < programIndex->vertexStart[number + 1]; ++position) {
+            /* Vertices are added in order, the new descriptor is the position in the function */
+            CFG::vertex_descriptor newVertex = add_vertex(*functionCFG);
+            put(functionPropMap, newVertex, get(boost::vertex_name, *programCFG, programIndex->vertices[position]));
         }
-    }
-    /* All vertices have been created in the new cfg with their properties.
-        Now add all edges within the program */
-    for(std::pair<CFGEIter, CFGEIter> edgePair = edges(*programCFG); edgePair.first != edgePair.second;
-        ++edgePair.first) {
-        /* retrieve source and target vertex descriptors */
-        CFG::vertex_descriptor sourceVertex = source(*edgePair.first, *programCFG);
-        CFG::vertex_descriptor targetVertex = target(*edgePair.first, *programCFG);
-
-        /*  Check if the source and target vertices have been copied.
-            That means that the edge is within the program */
-        if (copiedVertex[sourceVertex] && copiedVertex[targetVertex]) {
-            /* create the edge between the vertices  */
-            CFG::vertex_descriptor newSourceV = vertexMap[sourceVertex];
-            CFG::vertex_descriptor newTargetV = vertexMap[targetVertex];
-            /* Add the edge to the cfg. */
-            add_edge(newSourceV, newTargetV, *functionCFG);
+        for(size_t position = programIndex->edgeStart[number]; position < programIndex->edgeStart[number + 1]; ++position) {
+            add_edge(programIndex->edges[position].first, programIndex->edges[position].second, *functionCFG);
         }
     }
 
+    /* The analyses walk the compact form */
+    functionBlocks.build(functionCFG);
     /* Find activation records */
     findActivationRecords();
     /* Find the address range */
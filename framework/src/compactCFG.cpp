@@ -0,0 +1,148 @@
+/* Compact cfg implementation */
+
+/* header file */
+#include "compactCFG.hpp"
+
+
+/*  STEPS
+        1. Depth first search from the blocks without predecessors, then from
+        any block not reached yet, giving every vertex its post order. The
+        reverse of it numbers the blocks.
+
+        2. Count the successors and predecessors of every block and place
+        the edges in the rows, in edge order of the cfg.
+*/
+
+/* Constructor */
+compactCFG::compactCFG() {
+    successorStart.push_back(0);
+    predecessorStart.push_back(0);
+}
+
+/* Builds the snapshot of a cfg */
+void compactCFG::build(CFG* cfg) {
+    orderBlocks(cfg);
+    unsigned blockCount = blocks.size();
+    /* Count the edges of every block */
+    successorStart.assign(blockCount + 1, 0);
+    predecessorStart.assign(blockCount + 1, 0);
+    for(std::pair<CFG::edge_iterator, CFG::edge_iterator> ePair = edges(*cfg);
+        ePair.first != ePair.second; ++ePair.first) {
+        successorStart[vertexNumbers[source(*ePair.first, *cfg)] + 1]++;
+        predecessorStart[vertexNumbers[target(*ePair.first, *cfg)] + 1]++;
+    }
+    for(unsigned number = 0; number < blockCount; ++number) {
+        successorStart[number + 1] += successorStart[number];
+        predecessorStart[number + 1] += predecessorStart[number];
+    }
+    /* Place the edges */
+    successors.resize(successorStart[blockCount]);
+    predecessors.resize(predecessorStart[blockCount]);
+    std::vector<unsigned> successorNext(successorStart.begin(), successorStart.end() - 1);
+    std::vector<unsigned> predecessorNext(predecessorStart.begin(), predecessorStart.end() - 1);
+    for(std::pair<CFG::edge_iterator, CFG::edge_iterator> ePair = edges(*cfg);
+        ePair.first != ePair.second; ++ePair.first) {
+        unsigned from = vertexNumbers[source(*ePair.first, *cfg)];
+        unsigned to = vertexNumbers[target(*ePair.first, *cfg)];
+        successors[successorNext[from]++] = to;
+        predecessors[predecessorNext[to]++] = from;
+    }
+}
+
+/* Numbers the vertices in reverse post order */
+void compactCFG::orderBlocks(CFG* cfg) {
+    size_t vertexCount = num_vertices(*cfg);
+    std::vector<bool> visited(vertexCount, false);
+    std::vector<CFG::vertex_descriptor> postOrder;
+    postOrder.reserve(vertexCount);
+    /* Roots are the blocks without predecessors, then what is left */
+    std::vector<CFG::vertex_descriptor> roots;
+    for(size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        if (in_degree(vertex, *cfg) == 0) {
+            roots.push_back(vertex);
+        }
+    }
+    for(size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        roots.push_back(vertex);
+    }
+    /* Iterative search, the stack holds the vertex and its next out edge */
+    typedef std::pair<CFG::vertex_descriptor, CFG::out_edge_iterator> searchEntry;
+    std::vector<searchEntry> stack;
+    for(std::vector<CFG::vertex_descriptor>::iterator root = roots.begin();
+        root != roots.end(); ++root) {
+        if (visited[*root]) {
+            continue;
+        }
+        visited[*root] = true;
+        stack.push_back(searchEntry(*root, out_edges(*root, *cfg).first));
+        while (stack.empty() == false) {
+            CFG::vertex_descriptor vertex = stack.back().first;
+            if (stack.back().second == out_edges(vertex, *cfg).second) {
+                postOrder.push_back(vertex);
+                stack.pop_back();
+                continue;
+            }
+            CFG::vertex_descriptor next = target(*stack.back().second, *cfg);
+            ++stack.back().second;
+            if (visited[next] == false) {
+                visited[next] = true;
+                stack.push_back(searchEntry(next, out_edges(next, *cfg).first));
+            }
+        }
+    }
+    /* Reverse post order */
+    blocks.resize(vertexCount);
+    blockVertices.resize(vertexCount);
+    vertexNumbers.resize(vertexCount);
+    for(size_t index = 0; index < vertexCount; ++index) {
+        CFG::vertex_descriptor vertex = postOrder[vertexCount - 1 - index];
+        blocks[index] = get(boost::vertex_name, *cfg, vertex);
+        blockVertices[index] = vertex;
+        vertexNumbers[vertex] = index;
+    }
+}
+
+/* Number of blocks */
+unsigned compactCFG::size() {
+    return blocks.size();
+}
+
+/* Block with the number */
+SgAsmBlock* compactCFG::getBlock(unsigned number) {
+    return blocks[number];
+}
+
+/* Vertex of the block */
+CFG::vertex_descriptor compactCFG::getVertex(unsigned number) {
+    return blockVertices[number];
+}
+
+/* Number of the block of a vertex */
+unsigned compactCFG::getNumber(CFG::vertex_descriptor vertex) {
+    return vertexNumbers[vertex];
+}
+
+/* Successors and predecessors as ranges of block numbers */
+const unsigned* compactCFG::successorsBegin(unsigned number) {
+    return successors.empty() ? NULL : &successors[0] + successorStart[number];
+}
+
+const unsigned* compactCFG::successorsEnd(unsigned number) {
+    return successors.empty() ? NULL : &successors[0] + successorStart[number + 1];
+}
+
+const unsigned* compactCFG::predecessorsBegin(unsigned number) {
+    return predecessors.empty() ? NULL : &predecessors[0] + predecessorStart[number];
+}
+
+const unsigned* compactCFG::predecessorsEnd(unsigned number) {
+    return predecessors.empty() ? NULL : &predecessors[0] + predecessorStart[number + 1];
+}
+
+unsigned compactCFG::successorCount(unsigned number) {
+    return successorStart[number + 1] - successorStart[number];
+}
+
+unsigned compactCFG::predecessorCount(unsigned number) {
+    return predecessorStart[number + 1] - predecessorStart[number];
+}
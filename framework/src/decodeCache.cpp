@@ -0,0 +1,77 @@
+/* Decode cache implementation */
+
+/* header file */
+#include "decodeCache.hpp"
+
+/* The cache used by decodeInstruction */
+static decodeCache* activeDecodeCache = NULL;
+
+
+/* Constructor */
+decodeCache::decodeCache() {
+    hits = 0;
+    misses = 0;
+    invalidations = 0;
+}
+
+/* Returns the decoded instruction, decodes it on a miss */
+const instructionStruct& decodeCache::decode(SgAsmMipsInstruction* inst) {
+    std::map<SgAsmMipsInstruction*, instructionStruct>::iterator found = decodedInstructions.find(inst);
+    if (found != decodedInstructions.end()) {
+        hits++;
+        /* Addresses are set by the relocation without invalidating */
+        found->second.address = inst->get_address();
+        return found->second;
+    }
+    misses++;
+    /* Decode the operands and save the result */
+    return decodedInstructions.insert(std::pair<SgAsmMipsInstruction*, instructionStruct>
+        (inst, decodeInstructionOperands(inst))).first->second;
+}
+
+/* Removes an instruction that was created or changed */
+void decodeCache::invalidate(SgAsmMipsInstruction* inst) {
+    invalidations += decodedInstructions.erase(inst);
+}
+
+/* Removes all instructions and resets the counters */
+void decodeCache::clear() {
+    decodedInstructions.clear();
+    hits = 0;
+    misses = 0;
+    invalidations = 0;
+}
+
+/* Counters */
+unsigned long decodeCache::getHits() {
+    return hits;
+}
+
+unsigned long decodeCache::getMisses() {
+    return misses;
+}
+
+/* Prints the counters */
+void decodeCache::printStatistics() {
+    std::cout << "decode cache hits:" << std::dec << hits
+              << " misses:" << misses
+              << " invalidations:" << invalidations << std::endl;
+}
+
+
+/* Sets the cache decodeInstruction uses, NULL disables caching */
+void setActiveDecodeCache(decodeCache* cache) {
+    activeDecodeCache = cache;
+}
+
+/* Returns the active cache, NULL if there is none */
+decodeCache* getActiveDecodeCache() {
+    return activeDecodeCache;
+}
+
+/* Invalidates an instruction in the active cache, if there is one */
+void invalidateDecodedInstruction(SgAsmMipsInstruction* inst) {
+    if (activeDecodeCache != NULL) {
+        activeDecodeCache->invalidate(inst);
+    }
+}
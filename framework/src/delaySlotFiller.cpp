@@ -0,0 +1,143 @@
+/* Delay slot filling implementation.  */
+
+#include "delaySlotFiller.hpp"
+
+
+/* Constructor */
+delaySlotFiller::delaySlotFiller(CFGhandler* handler) {
+    cfgContainer = handler;
+    slotsFound = 0;
+    slotsFilled = 0;
+}
+
+/* Fills the delay slots in all blocks of the function cfg */
+void delaySlotFiller::applyFilling() {
+    compactCFG* function = cfgContainer->getCompactCFG();
+    for(unsigned number = 0; number < function->size(); ++number) {
+        SgAsmBlock* bb = function->getBlock(number);
+        fillBlock(bb);
+    }
+}
+
+/* Prints the delay slots found and filled */
+void delaySlotFiller::printStatistics() {
+    std::cout << "delay slots filled:" << std::dec << slotsFilled
+              << " of " << slotsFound << std::endl;
+}
+
+/* Fills the delay slots of one block */
+void delaySlotFiller::fillBlock(SgAsmBlock* block) {
+    SgAsmStatementPtrList& instructionVector = block->get_statementList();
+    /*  Look for branches followed by a nop. The vector shrinks by one for
+        every filled slot so the size is checked each iteration. */
+    for(size_t index = 0; index + 1 < instructionVector.size(); ++index) {
+        SgAsmMipsInstruction* branch = isSgAsmMipsInstruction(instructionVector[index]);
+        SgAsmMipsInstruction* slot = isSgAsmMipsInstruction(instructionVector[index + 1]);
+        if (branch == NULL || slot == NULL || hasDelaySlot(branch->get_kind()) == false) {
+            continue;
+        }
+        /* Skip the delay slot itself in the next iteration */
+        if (slot->get_kind() != mips_nop) {
+            index++;
+            continue;
+        }
+        slotsFound++;
+        /* Branch likely annuls the slot when not taken, it can not be filled from above. */
+        if ((getInstructionDescriptor(branch->get_kind()).flags & INSTRUCTION_LIKELY) != 0) {
+            index++;
+            continue;
+        }
+        int candidate = findCandidate(instructionVector, index);
+        if (candidate >= 0) {
+            /* Replace the nop with the candidate and remove it from its old place */
+            instructionVector[index + 1] = instructionVector[candidate];
+            instructionVector.erase(instructionVector.begin() + candidate);
+            slotsFilled++;
+            /* The branch moved up one position */
+            index--;
+        }
+        index++;
+    }
+}
+
+/* Searches backwards from the branch for an instruction to move into its delay slot */
+int delaySlotFiller::findCandidate(SgAsmStatementPtrList& instructionVector, int branchIndex) {
+    SgAsmMipsInstruction* branch = isSgAsmMipsInstruction(instructionVector[branchIndex]);
+    /* Registers and memory touched by the instructions that the candidate passes */
+    registerMask passedDef = 0;
+    registerMask passedUse = 0;
+    bool passedMemory = false;
+    bool passedStore = false;
+    for(int index = branchIndex - 1; index >= 0; --index) {
+        SgAsmStatement* stmt = instructionVector[index];
+        /* Stop at barriers and at the delay slot of an earlier branch */
+        if (isFillBarrier(stmt)) {
+            return -1;
+        }
+        if (index > 0 && isSgAsmMipsInstruction(instructionVector[index - 1]) != NULL &&
+            hasDelaySlot(isSgAsmMipsInstruction(instructionVector[index - 1])->get_kind())) {
+            return -1;
+        }
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmt);
+        registerMask def, use;
+        instructionDefUse(mips, &def, &use);
+        bool memory = isMemoryInstruction(mips);
+        bool store = memory && getInstructionFormat(mips->get_kind()) == I_RS_MEM_RT_C;
+        /*  The candidate must not depend on, or be depended on by, the
+            instructions between it and the branch. Forbidden instructions
+            and nops are never moved. */
+        bool independent = (def & (passedDef | passedUse)) == 0 && (use & passedDef) == 0 &&
+                           (memory == false || (passedStore == false && (store == false || passedMemory == false)));
+        if (independent && mips->get_kind() != mips_nop &&
+            cfgContainer->isForbiddenInstruction(mips) == false &&
+            compatibleWithBranch(mips, branch)) {
+            return index;
+        }
+        /* The instruction stays, later candidates have to pass it */
+        passedDef |= def;
+        passedUse |= use;
+        passedMemory = passedMemory || memory;
+        passedStore = passedStore || store;
+    }
+    return -1;
+}
+
+/*  Checks the candidate against the branch operands. The branch reads its
+    operands before the slot executes, so the candidate can not write them.
+    A link register is written before the slot executes, so the candidate
+    can not touch it. */
+bool delaySlotFiller::compatibleWithBranch(SgAsmMipsInstruction* candidate, SgAsmMipsInstruction* branch) {
+    instructionStruct decodedBranch = decodeInstruction(branch);
+    registerMask branchReads = 0;
+    registerMask branchLinks = 0;
+    for(registerList::iterator iter = decodedBranch.sourceRegisters.begin();
+        iter != decodedBranch.sourceRegisters.end(); ++iter) {
+        branchReads |= registerBit(iter->regName);
+    }
+    for(registerList::iterator iter = decodedBranch.destinationRegisters.begin();
+        iter != decodedBranch.destinationRegisters.end(); ++iter) {
+        branchLinks |= registerBit(iter->regName);
+    }
+    if ((getInstructionDescriptor(decodedBranch.kind).flags & INSTRUCTION_CALL) != 0) {
+        /* jalr has the link register as operand, ra is added for all calls */
+        branchLinks |= registerBit(ra);
+    }
+    registerMask def, use;
+    instructionDefUse(candidate, &def, &use);
+    return (def & branchReads) == 0 && ((def | use) & branchLinks) == 0;
+}
+
+/* Checks if the instruction can not be moved or passed */
+bool delaySlotFiller::isFillBarrier(SgAsmStatement* stmt) {
+    SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmt);
+    if (mips == NULL) {
+        return true;
+    }
+    return hasDelaySlot(mips->get_kind()) || getInstructionFormat(mips->get_kind()) == MIPS_UNKNOWN;
+}
+
+/* Checks if the instruction reads or writes memory */
+bool delaySlotFiller::isMemoryInstruction(SgAsmMipsInstruction* mips) {
+    instructionType format = getInstructionFormat(mips->get_kind());
+    return format == I_RD_MEM_RS_C || format == I_RS_MEM_RT_C;
+}
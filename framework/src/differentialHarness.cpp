@@ -0,0 +1,157 @@
+/* Differential harness implementation */
+
+/* header file */
+#include "differentialHarness.hpp"
+/* Output */
+#include <sstream>
+
+/*  STEPS of a comparison
+        1. Before the transformation run every input on the original
+        function and keep the architectural state after the run.
+        2. After the transformation, before relocation, run the inputs
+        again. The inserted instructions are reached through the lists.
+        3. The runs must end the same way with the same value. A returning
+        function must also leave the registers the caller relies on as they
+        were, the output and the memory outside the frames must be equal.
+        Runs that both stop the same way without finishing, at the limit or
+        at an unknown instruction, show neither a match nor a mismatch. They
+        are counted as inconclusive.
+        4. The overhead is the ratio of the summed instructions and cycles
+        of the conclusive runs. */
+
+/* Registers a returning function leaves for its caller */
+static const mipsRegisterName comparedRegisters[] = {
+    v0, v1, s0, s1, s2, s3, s4, s5, s6, s7, gp, sp, fp, ra
+};
+static const size_t comparedCount = sizeof(comparedRegisters) / sizeof(comparedRegisters[0]);
+/* Characters of generated arguments, digits and some that are not */
+static const char argumentCharacters[] = "0123456789-+ax";
+
+/* Constructor */
+differentialHarness::differentialHarness(CFG* programCFG, std::vector<harnessInput> runInputs):
+    interpreter(programCFG) {
+    inputs = runInputs;
+}
+
+/* Loads the binary the function is in */
+bool differentialHarness::loadELF(std::string file) {
+    return interpreter.loadELF(file);
+}
+
+/* Runs every input on the function */
+void differentialHarness::runInputs(rose_addr_t function, std::vector<architecturalState>* states) {
+    states->assign(inputs.size(), architecturalState());
+    for(size_t index = 0; index < inputs.size(); ++index) {
+        architecturalState& state = (*states)[index];
+        if (inputs[index].argv.empty()) {
+            state.result = interpreter.runFunction(function, inputs[index].arguments);
+        } else {
+            state.result = interpreter.runMain(function, inputs[index].argv);
+        }
+        for(size_t reg = 0; reg < comparedCount; ++reg) {
+            state.registers.push_back(interpreter.getRegister(comparedRegisters[reg]));
+        }
+        state.output = interpreter.getOutput();
+        state.memory = interpreter.memoryDigest();
+    }
+}
+
+/* Runs the inputs before the transformation */
+void differentialHarness::recordOriginal(rose_addr_t function) {
+    runInputs(function, &original);
+}
+
+/* Runs the inputs after the transformation */
+void differentialHarness::recordTransformed(rose_addr_t function) {
+    runInputs(function, &transformed);
+}
+
+/* A run that returned or exited, its results can be compared */
+bool differentialHarness::finishedRun(architecturalState& state) {
+    return state.result.status == INTERPRETER_RETURNED || state.result.status == INTERPRETER_EXITED;
+}
+
+/* Describes the first difference of two states */
+std::string differentialHarness::compareStates(architecturalState& before, architecturalState& after) {
+    std::stringstream difference;
+    if (before.result.status != after.result.status) {
+        difference << "status " << before.result.status << " became " << after.result.status;
+    } else if (before.result.returnValue != after.result.returnValue) {
+        difference << "value " << before.result.returnValue << " became " << after.result.returnValue;
+    } else if (before.output != after.output) {
+        difference << "output differs";
+    } else if (before.memory != after.memory) {
+        difference << "memory differs";
+    } else if (before.result.status == INTERPRETER_RETURNED) {
+        for(size_t reg = 0; reg < comparedCount; ++reg) {
+            if (before.registers[reg] != after.registers[reg]) {
+                difference << "register " << comparedRegisters[reg] << " 0x" << std::hex
+                           << before.registers[reg] << " became 0x" << after.registers[reg];
+                break;
+            }
+        }
+    }
+    return difference.str();
+}
+
+/* Prints the mismatches and the overhead */
+unsigned differentialHarness::printReport() {
+    unsigned mismatches = 0;
+    unsigned inconclusive = 0;
+    uint64_t instructionsBefore = 0, instructionsAfter = 0;
+    uint64_t cyclesBefore = 0, cyclesAfter = 0;
+    uint64_t stallsBefore = 0, stallsAfter = 0;
+    for(size_t index = 0; index < inputs.size() && index < original.size() && index < transformed.size(); ++index) {
+        /* Both runs stopped the same way before they finished */
+        if (original[index].result.status == transformed[index].result.status &&
+            finishedRun(original[index]) == false) {
+            inconclusive++;
+            continue;
+        }
+        std::string difference = compareStates(original[index], transformed[index]);
+        if (difference.empty() == false) {
+            mismatches++;
+            std::cout << "input " << std::dec << index << " mismatch: " << difference << std::endl;
+        }
+        instructionsBefore += original[index].result.instructions;
+        instructionsAfter += transformed[index].result.instructions;
+        cyclesBefore += original[index].result.cycles;
+        cyclesAfter += transformed[index].result.cycles;
+        stallsBefore += original[index].result.hiLoStalls + original[index].result.loadUseStalls;
+        stallsAfter += transformed[index].result.hiLoStalls + transformed[index].result.loadUseStalls;
+    }
+    std::cout << "differential inputs:" << std::dec << inputs.size()
+              << " mismatches:" << mismatches
+              << " inconclusive:" << inconclusive
+              << " instructions:" << instructionsBefore << "->" << instructionsAfter
+              << " cycles:" << cyclesBefore << "->" << cyclesAfter
+              << " stalls:" << stallsBefore << "->" << stallsAfter;
+    if (instructionsBefore != 0 && cyclesBefore != 0) {
+        std::cout << " instruction ratio:" << (double)instructionsAfter / instructionsBefore
+                  << " cycle ratio:" << (double)cyclesAfter / cyclesBefore;
+    }
+    std::cout << std::endl;
+    return mismatches;
+}
+
+/* Generates argv inputs */
+std::vector<harnessInput> differentialHarness::generateArgv(unsigned count, unsigned seed) {
+    std::vector<harnessInput> generated(count);
+    uint32_t state = seed;
+    for(unsigned index = 0; index < count; ++index) {
+        generated[index].argv.push_back("program");
+        state = state * 1103515245 + 12345;
+        unsigned argumentCount = (state >> 16) % 5;
+        for(unsigned argument = 0; argument < argumentCount; ++argument) {
+            state = state * 1103515245 + 12345;
+            unsigned length = 1 + (state >> 16) % 3;
+            std::string text;
+            for(unsigned character = 0; character < length; ++character) {
+                state = state * 1103515245 + 12345;
+                text.push_back(argumentCharacters[(state >> 16) % (sizeof(argumentCharacters) - 1)]);
+            }
+            generated[index].argv.push_back(text);
+        }
+    }
+    return generated;
+}
@@ -0,0 +1,515 @@
+/* Output ELF writer implementation.  */
+
+#include "elfWriter.hpp"
+
+/* System headers for the mapped input and the output file */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+
+
+/*  STEPS
+        1. Map the input file and read the ELF, program and section headers.
+        Find the executable segment, the functions are appended after it.
+
+        2. Check that the grown segment stays below the next loaded segment
+        and off its pages. The contents after the executable segment move in
+        the file by the appended size rounded to their largest alignment, so
+        offsets stay congruent to the addresses.
+
+        3. Stream the output. The executable segment is copied unchanged,
+        followed by the functions encoded from the AST and the padding, then
+        the rest of the file.
+
+        4. Write the jumps at the original entries and the updated headers.
+        The last code section of the segment is grown to the end of the
+        appended code.
+    Failures are reported through the return values and getError, a failed
+    write removes the output file.
+*/
+
+/* Constructor */
+elfWriter::elfWriter() {
+    inputData = NULL;
+    inputSize = 0;
+    swapBytes = false;
+    bigEndian = false;
+    textSegment = -1;
+    segmentEndOffset = 0;
+    segmentEnd = 0;
+    appendAddress = 0;
+    appendEnd = 0;
+    fileShift = 0;
+    encodedInstructions = 0;
+    entryJumps = 0;
+}
+
+/* Releases the input */
+elfWriter::~elfWriter() {
+    if (inputData != NULL) {
+        munmap(inputData, inputSize);
+    }
+}
+
+/* Adds a relocated function */
+void elfWriter::addFunction(CFGhandler* handler, relocationHandler* relocation) {
+    writtenFunction function;
+    function.cfgContainer = handler;
+    function.relocationInfo = relocation;
+    function.start = relocation->getFunctionStart();
+    function.end = relocation->getFunctionEnd();
+    function.offset = 0;
+    function.placement = relocation->getPlacement();
+    function.placementEnd = relocation->getPlacementEnd();
+    functions.push_back(function);
+}
+
+/* Address where the transformed functions are appended */
+rose_addr_t elfWriter::getAppendAddress() {
+    return appendAddress;
+}
+
+/* Writes the output file from the input file */
+bool elfWriter::writeFile(std::string outputFile) {
+    if (computeLayout() == false) {
+        return false;
+    }
+    return writeOutput(outputFile);
+}
+
+/* Reason the last read or write failed */
+std::string elfWriter::getError() {
+    return errorMessage;
+}
+
+/* Records why the input can not be read or the output written */
+bool elfWriter::fail(std::string message) {
+    errorMessage = "Elf writer: " + message;
+    return false;
+}
+
+/* Prints the encoded instructions and the size of the appended code */
+void elfWriter::printStatistics() {
+    std::cout << "elf writer functions:" << std::dec << functions.size()
+              << " encoded:" << encodedInstructions
+              << " entry jumps:" << entryJumps
+              << " appended:" << appendEnd - appendAddress
+              << " file shift:" << fileShift << std::endl;
+}
+
+/* Maps the input file and reads the headers */
+bool elfWriter::readInput(std::string inputFile) {
+    int fd = open(inputFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return fail("Could not open the input file.");
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(Elf32_Ehdr)) {
+        close(fd);
+        return fail("Input file is not an ELF file.");
+    }
+    inputSize = fileStat.st_size;
+    /* The mapping stays valid after the descriptor is closed */
+    void* mapping = mmap(NULL, inputSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return fail("Could not map the input file.");
+    }
+    inputData = static_cast<unsigned char*>(mapping);
+
+    /* Identification, only 32 bit MIPS executables */
+    if (memcmp(inputData, ELFMAG, SELFMAG) != 0 || inputData[EI_CLASS] != ELFCLASS32) {
+        return fail("Input file is not a 32 bit ELF file.");
+    }
+    bigEndian = (inputData[EI_DATA] == ELFDATA2MSB);
+    uint16_t hostTest = 1;
+    bool hostBigEndian = (*reinterpret_cast<unsigned char*>(&hostTest) == 0);
+    swapBytes = (bigEndian != hostBigEndian);
+
+    /* File header */
+    memcpy(&fileHeader, inputData, sizeof(Elf32_Ehdr));
+    convertHeader(&fileHeader);
+    if (fileHeader.e_machine != EM_MIPS || fileHeader.e_type != ET_EXEC) {
+        return fail("Only static MIPS executables can be written.");
+    }
+    /* Program headers */
+    programHeaders.resize(fileHeader.e_phnum);
+    for(int index = 0; index < fileHeader.e_phnum; ++index) {
+        Elf32_Off offset = fileHeader.e_phoff + index * fileHeader.e_phentsize;
+        if (offset + sizeof(Elf32_Phdr) > inputSize) {
+            return fail("Program header outside the file.");
+        }
+        memcpy(&programHeaders[index], inputData + offset, sizeof(Elf32_Phdr));
+        convertProgramHeader(&programHeaders[index]);
+    }
+    /* Section headers */
+    sectionHeaders.resize(fileHeader.e_shnum);
+    for(int index = 0; index < fileHeader.e_shnum; ++index) {
+        Elf32_Off offset = fileHeader.e_shoff + index * fileHeader.e_shentsize;
+        if (offset + sizeof(Elf32_Shdr) > inputSize) {
+            return fail("Section header outside the file.");
+        }
+        memcpy(&sectionHeaders[index], inputData + offset, sizeof(Elf32_Shdr));
+        convertSectionHeader(&sectionHeaders[index]);
+    }
+
+    /* The executable segment, the one the program starts in */
+    textSegment = -1;
+    for(size_t index = 0; index < programHeaders.size(); ++index) {
+        Elf32_Phdr& segment = programHeaders[index];
+        if (segment.p_type == PT_LOAD && (segment.p_flags & PF_X) != 0 &&
+            segment.p_vaddr <= fileHeader.e_entry && fileHeader.e_entry < segment.p_vaddr + segment.p_memsz) {
+            textSegment = index;
+        }
+    }
+    if (textSegment < 0) {
+        return fail("No executable segment holds the entry.");
+    }
+    Elf32_Phdr& segment = programHeaders[textSegment];
+    if (segment.p_filesz != segment.p_memsz) {
+        return fail("The executable segment has bytes that are not in the file.");
+    }
+    segmentEndOffset = segment.p_offset + segment.p_filesz;
+    segmentEnd = segment.p_vaddr + segment.p_memsz;
+    appendAddress = (segmentEnd + codeAlignment - 1) & ~(Elf32_Addr)(codeAlignment - 1);
+    appendEnd = appendAddress;
+    return true;
+}
+
+/* Checks the space for the appended code and computes the file shift */
+bool elfWriter::computeLayout() {
+    if (inputData == NULL || functions.empty()) {
+        return fail("No input or no function to write.");
+    }
+    /* The functions follow each other from the append address on */
+    Elf32_Shdr* codeSection = NULL;
+    appendEnd = appendAddress;
+    for(std::vector<writtenFunction>::iterator iter = functions.begin();
+        iter != functions.end(); ++iter) {
+        if (iter->placement < appendEnd) {
+            return fail("Transformed functions overlap.");
+        }
+        appendEnd = iter->placementEnd;
+        /* The relocation leaves the jump out when the entry has no room for it */
+        if (iter->relocationInfo->getEntryJump()->empty()) {
+            return fail("No room for the jump at the entry of a function.");
+        }
+        /* The input offset of the original function, its entry gets the jump */
+        codeSection = NULL;
+        for(size_t index = 0; index < sectionHeaders.size(); ++index) {
+            Elf32_Shdr& section = sectionHeaders[index];
+            if (section.sh_type == SHT_PROGBITS && (section.sh_flags & SHF_EXECINSTR) != 0 &&
+                section.sh_addr <= iter->start && iter->end <= section.sh_addr + section.sh_size) {
+                codeSection = &section;
+            }
+        }
+        if (codeSection == NULL) {
+            return fail("No section contains the function.");
+        }
+        iter->offset = codeSection->sh_offset + (iter->start - codeSection->sh_addr);
+    }
+    /*  The grown segment can not reach the next loaded segment, not even
+        its first page since the pages are mapped with other permissions. */
+    Elf32_Phdr& segment = programHeaders[textSegment];
+    Elf32_Addr pageSize = std::max((Elf32_Addr)4096, (Elf32_Addr)segment.p_align);
+    for(size_t index = 0; index < programHeaders.size(); ++index) {
+        Elf32_Phdr& other = programHeaders[index];
+        if ((int)index != textSegment && other.p_type == PT_LOAD && other.p_vaddr >= segmentEnd &&
+            appendEnd > (other.p_vaddr & ~(pageSize - 1))) {
+            return fail("No room for the functions before the next segment.");
+        }
+    }
+    /*  Contents after the segment move in the file only, by a multiple of
+        their alignment so offsets stay congruent to the addresses. */
+    uint32_t alignment = 4;
+    for(size_t index = 0; index < programHeaders.size(); ++index) {
+        if (programHeaders[index].p_offset >= segmentEndOffset) {
+            alignment = std::max(alignment, (uint32_t)programHeaders[index].p_align);
+        }
+    }
+    for(size_t index = 0; index < sectionHeaders.size(); ++index) {
+        if (sectionHeaders[index].sh_offset >= segmentEndOffset) {
+            alignment = std::max(alignment, (uint32_t)sectionHeaders[index].sh_addralign);
+        }
+    }
+    uint32_t appended = appendEnd - segmentEnd;
+    fileShift = ((appended + alignment - 1) / alignment) * alignment;
+    return true;
+}
+
+/* Streams the output file */
+bool elfWriter::writeOutput(std::string outputFile) {
+    int fd = open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0755);
+    if (fd < 0) {
+        return fail("Could not create the output file.");
+    }
+    bool written = writeContents(fd) && writeEntryJumps(fd) && writeHeaders(fd);
+    if (close(fd) != 0 && written) {
+        written = fail("Could not close the output file.");
+    }
+    /* No partial output is left behind */
+    if (written == false) {
+        unlink(outputFile.c_str());
+    }
+    return written;
+}
+
+/* Copies the input with the functions appended to the executable segment */
+bool elfWriter::writeContents(int fd) {
+    /* Everything up to the end of the executable segment is unchanged */
+    if (writeSequential(fd, inputData, segmentEndOffset) == false) {
+        return false;
+    }
+    /* Alignment before the first function, nops */
+    std::vector<unsigned char> padding(appendAddress - segmentEnd, 0);
+    if (padding.empty() == false && writeSequential(fd, &padding[0], padding.size()) == false) {
+        return false;
+    }
+    /* The functions, each ends with the padding to the next */
+    for(std::vector<writtenFunction>::iterator iter = functions.begin();
+        iter != functions.end(); ++iter) {
+        std::vector<unsigned char> functionBytes;
+        if (encodeFunction(*iter, &functionBytes) == false) {
+            return false;
+        }
+        if (functionBytes.empty() == false &&
+            writeSequential(fd, &functionBytes[0], functionBytes.size()) == false) {
+            return false;
+        }
+    }
+    /* Padding up to the file shift, then the rest of the file */
+    padding.assign(fileShift - (appendEnd - segmentEnd), 0);
+    if (padding.empty() == false && writeSequential(fd, &padding[0], padding.size()) == false) {
+        return false;
+    }
+    return writeSequential(fd, inputData + segmentEndOffset, inputSize - segmentEndOffset);
+}
+
+/* Encodes a transformed function into a buffer */
+bool elfWriter::encodeFunction(writtenFunction& function, std::vector<unsigned char>* buffer) {
+    /* The padding is nops, which are zero words */
+    buffer->assign(function.placementEnd - function.placement, 0);
+    if (buffer->empty()) {
+        return true;
+    }
+    /*  Bytes between the blocks keep their content. Removed instructions
+        translate to the next kept address and are written first in address
+        order, the gap or instruction there overwrites them. */
+    relocationMap* addressMap = function.cfgContainer->getRelocationMap();
+    for(rose_addr_t oldAddress = function.start; oldAddress < function.end; oldAddress += 4) {
+        rose_addr_t index = addressMap->translate(oldAddress) - function.placement;
+        if (index + 4 <= buffer->size()) {
+            memcpy(&(*buffer)[index], inputData + function.offset + (oldAddress - function.start), 4);
+        }
+    }
+    /* Encode every instruction at its new address */
+    CFG* functionGraph = function.cfgContainer->getFunctionCFG();
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*functionGraph);
+        vPair.first != vPair.second; ++vPair.first) {
+        SgAsmBlock* block = get(boost::vertex_name, *functionGraph, *vPair.first);
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            if (mips == NULL) {
+                continue;
+            }
+            rose_addr_t index = mips->get_address() - function.placement;
+            if (mips->get_address() < function.placement || index + 4 > buffer->size()) {
+                return fail("Instruction outside the function.");
+            }
+            uint32_t word;
+            if (encodeInstruction(mips, &word)) {
+                storeWord(&(*buffer)[index], word);
+            } else if (mips->get_raw_bytes().size() == 4 && hasDelaySlot(mips->get_kind()) == false) {
+                /* Unknown instructions that do not depend on their address keep their bytes */
+                SgUnsignedCharList raw = mips->get_raw_bytes();
+                std::copy(raw.begin(), raw.end(), buffer->begin() + index);
+            } else {
+                return fail("Instruction can not be encoded.");
+            }
+            encodedInstructions++;
+        }
+    }
+    return true;
+}
+
+/* Writes the jumps at the original function entries */
+bool elfWriter::writeEntryJumps(int fd) {
+    for(std::vector<writtenFunction>::iterator iter = functions.begin();
+        iter != functions.end(); ++iter) {
+        std::vector<SgAsmMipsInstruction*>* entryJump = iter->relocationInfo->getEntryJump();
+        for(std::vector<SgAsmMipsInstruction*>::iterator jumpIter = entryJump->begin();
+            jumpIter != entryJump->end(); ++jumpIter) {
+            /* The original code is at its input offset, before the moved contents */
+            Elf32_Off offset = iter->offset + ((*jumpIter)->get_address() - iter->start);
+            uint32_t word;
+            if (encodeInstruction(*jumpIter, &word) == false) {
+                return fail("Entry jump can not be encoded.");
+            }
+            unsigned char bytes[4];
+            storeWord(bytes, word);
+            if (writeAt(fd, offset, bytes, 4) == false) {
+                return false;
+            }
+        }
+        entryJumps++;
+    }
+    return true;
+}
+
+/* Updates and writes the headers */
+bool elfWriter::writeHeaders(int fd) {
+    /*  The last code section of the segment grows over the appended code,
+        sections placed after it in the segment stay inside its range. */
+    Elf32_Phdr& textHeader = programHeaders[textSegment];
+    Elf32_Shdr* codeSection = NULL;
+    for(size_t index = 0; index < sectionHeaders.size(); ++index) {
+        Elf32_Shdr& section = sectionHeaders[index];
+        if (section.sh_type == SHT_PROGBITS && (section.sh_flags & SHF_EXECINSTR) != 0 &&
+            section.sh_addr >= textHeader.p_vaddr && section.sh_addr + section.sh_size <= segmentEnd &&
+            (codeSection == NULL || section.sh_addr > codeSection->sh_addr)) {
+            codeSection = &section;
+        }
+    }
+    if (codeSection != NULL) {
+        codeSection->sh_size = appendEnd - codeSection->sh_addr;
+    }
+    /* Sections keep their addresses, the ones after the segment move in the file */
+    for(size_t index = 0; index < sectionHeaders.size(); ++index) {
+        Elf32_Shdr& section = sectionHeaders[index];
+        if (section.sh_type != SHT_NULL) {
+            section.sh_offset = newOffset(section.sh_offset);
+        }
+    }
+    /* Segments, the executable one grows over the appended code */
+    for(size_t index = 0; index < programHeaders.size(); ++index) {
+        Elf32_Phdr& segment = programHeaders[index];
+        if ((int)index == textSegment) {
+            segment.p_filesz += appendEnd - segmentEnd;
+            segment.p_memsz += appendEnd - segmentEnd;
+        } else {
+            segment.p_offset = newOffset(segment.p_offset);
+        }
+    }
+    fileHeader.e_phoff = newOffset(fileHeader.e_phoff);
+    fileHeader.e_shoff = newOffset(fileHeader.e_shoff);
+
+    /* Write the tables in file byte order */
+    for(size_t index = 0; index < programHeaders.size(); ++index) {
+        Elf32_Phdr segment = programHeaders[index];
+        convertProgramHeader(&segment);
+        if (writeAt(fd, fileHeader.e_phoff + index * fileHeader.e_phentsize, &segment, sizeof(Elf32_Phdr)) == false) {
+            return false;
+        }
+    }
+    for(size_t index = 0; index < sectionHeaders.size(); ++index) {
+        Elf32_Shdr section = sectionHeaders[index];
+        convertSectionHeader(&section);
+        if (writeAt(fd, fileHeader.e_shoff + index * fileHeader.e_shentsize, &section, sizeof(Elf32_Shdr)) == false) {
+            return false;
+        }
+    }
+    Elf32_Ehdr header = fileHeader;
+    convertHeader(&header);
+    return writeAt(fd, 0, &header, sizeof(Elf32_Ehdr));
+}
+
+/* New file offset of an input file offset */
+Elf32_Off elfWriter::newOffset(Elf32_Off offset) {
+    if (offset < segmentEndOffset) {
+        return offset;
+    }
+    return offset + fileShift;
+}
+
+/******************************************************************************
+* Byte order and write helpers.
+******************************************************************************/
+/* Byte order conversion between file and host */
+uint16_t elfWriter::fileOrder16(uint16_t value) {
+    if (swapBytes == false) {
+        return value;
+    }
+    return (value >> 8) | (value << 8);
+}
+
+uint32_t elfWriter::fileOrder32(uint32_t value) {
+    if (swapBytes == false) {
+        return value;
+    }
+    return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+}
+
+/* The conversions swap in both directions */
+void elfWriter::convertHeader(Elf32_Ehdr* header) {
+    header->e_type = fileOrder16(header->e_type);
+    header->e_machine = fileOrder16(header->e_machine);
+    header->e_version = fileOrder32(header->e_version);
+    header->e_entry = fileOrder32(header->e_entry);
+    header->e_phoff = fileOrder32(header->e_phoff);
+    header->e_shoff = fileOrder32(header->e_shoff);
+    header->e_flags = fileOrder32(header->e_flags);
+    header->e_ehsize = fileOrder16(header->e_ehsize);
+    header->e_phentsize = fileOrder16(header->e_phentsize);
+    header->e_phnum = fileOrder16(header->e_phnum);
+    header->e_shentsize = fileOrder16(header->e_shentsize);
+    header->e_shnum = fileOrder16(header->e_shnum);
+    header->e_shstrndx = fileOrder16(header->e_shstrndx);
+}
+
+void elfWriter::convertProgramHeader(Elf32_Phdr* header) {
+    header->p_type = fileOrder32(header->p_type);
+    header->p_offset = fileOrder32(header->p_offset);
+    header->p_vaddr = fileOrder32(header->p_vaddr);
+    header->p_paddr = fileOrder32(header->p_paddr);
+    header->p_filesz = fileOrder32(header->p_filesz);
+    header->p_memsz = fileOrder32(header->p_memsz);
+    header->p_flags = fileOrder32(header->p_flags);
+    header->p_align = fileOrder32(header->p_align);
+}
+
+void elfWriter::convertSectionHeader(Elf32_Shdr* header) {
+    header->sh_name = fileOrder32(header->sh_name);
+    header->sh_type = fileOrder32(header->sh_type);
+    header->sh_flags = fileOrder32(header->sh_flags);
+    header->sh_addr = fileOrder32(header->sh_addr);
+    header->sh_offset = fileOrder32(header->sh_offset);
+    header->sh_size = fileOrder32(header->sh_size);
+    header->sh_link = fileOrder32(header->sh_link);
+    header->sh_info = fileOrder32(header->sh_info);
+    header->sh_addralign = fileOrder32(header->sh_addralign);
+    header->sh_entsize = fileOrder32(header->sh_entsize);
+}
+
+/* Stores an instruction word in file byte order */
+void elfWriter::storeWord(unsigned char* bytes, uint32_t word) {
+    for(int byte = 0; byte < 4; ++byte) {
+        int shift = bigEndian ? (24 - 8 * byte) : (8 * byte);
+        bytes[byte] = (word >> shift) & 0xff;
+    }
+}
+
+/* Writes at an offset in the output */
+bool elfWriter::writeAt(int fd, Elf32_Off offset, const void* data, size_t size) {
+    if (pwrite(fd, data, size, offset) != (ssize_t)size) {
+        return fail("Write to the output file failed.");
+    }
+    return true;
+}
+
+/* Appends to the output */
+bool elfWriter::writeSequential(int fd, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written <= 0) {
+            return fail("Write to the output file failed.");
+        }
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
@@ -0,0 +1,218 @@
+/* Growth report implementation */
+
+/* header file */
+#include "growthReport.hpp"
+/* Output */
+#include <fstream>
+#include <sstream>
+
+/*  STEPS of a report
+        1. Before the user traversal count the instructions of every block
+        and estimate their cycles, remember the deallocation constant.
+        2. After the traversal every instruction without an address was
+        inserted by the user.
+        3. After the framework transformations the other instructions
+        without an address were inserted by the framework. Accumulator moves
+        are hi/lo saves, loads and stores spill and reload, writes to the
+        stack pointer adjust the stack. The activation records are changed
+        in place, the frame growth is the change of their constant. */
+
+/* Constructor */
+growthReport::growthReport(CFGhandler* handler, std::string name) {
+    cfgContainer = handler;
+    functionName = name;
+    frameGrowth = 0;
+    originalFrameConstant = 0;
+}
+
+/* Constant of the deallocation record */
+uint64_t growthReport::frameConstant() {
+    SgAsmMipsInstruction* deallocMips = isSgAsmMipsInstruction(cfgContainer->getActivationRecord().second);
+    if (deallocMips == NULL) {
+        return 0;
+    }
+    return decodeInstruction(deallocMips).instructionConstant;
+}
+
+/* Records the blocks before the user traversal */
+void growthReport::recordOriginal() {
+    compactCFG* function = cfgContainer->getCompactCFG();
+    blocks.assign(function->size(), growthCounts());
+    total = growthCounts();
+    total.address = std::numeric_limits<rose_addr_t>::max();
+    for(unsigned number = 0; number < function->size(); ++number) {
+        SgAsmBlock* block = function->getBlock(number);
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        blocks[number].address = block->get_address();
+        blocks[number].originalInstructions = stmtList.size();
+        blocks[number].originalCycles = estimateStatementCycles(stmtList);
+        total.address = std::min(total.address, block->get_address());
+        total.originalInstructions += blocks[number].originalInstructions;
+        total.originalCycles += blocks[number].originalCycles;
+    }
+    originalFrameConstant = frameConstant();
+}
+
+/* Records the instructions the user inserted */
+void growthReport::recordInserted(const std::set<SgAsmStatement*>& inserted) {
+    userInstructions = inserted;
+}
+
+/* Finds the instructions the user inserted */
+void growthReport::findUserInstructions(CFGhandler* handler, std::set<SgAsmStatement*>* inserted) {
+    compactCFG* function = handler->getCompactCFG();
+    for(unsigned number = 0; number < function->size(); ++number) {
+        SgAsmStatementPtrList& stmtList = function->getBlock(number)->get_statementList();
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            if ((*iter)->get_address() == 0) {
+                inserted->insert(*iter);
+            }
+        }
+    }
+}
+
+/* Splits the final instructions */
+void growthReport::recordFinal() {
+    compactCFG* function = cfgContainer->getCompactCFG();
+    for(unsigned number = 0; number < function->size(); ++number) {
+        growthCounts& counts = blocks[number];
+        SgAsmStatementPtrList& stmtList = function->getBlock(number)->get_statementList();
+        counts.finalInstructions = stmtList.size();
+        counts.finalCycles = estimateStatementCycles(stmtList);
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            if ((*iter)->get_address() != 0) {
+                counts.keptOriginal++;
+            } else if (userInstructions.count(*iter) > 0) {
+                counts.userInserted++;
+            } else if (mips == NULL) {
+                counts.otherInserted++;
+            } else if (mips->get_kind() == mips_mfhi || mips->get_kind() == mips_mflo ||
+                       mips->get_kind() == mips_mthi || mips->get_kind() == mips_mtlo) {
+                counts.hiLoSave++;
+            } else if (getInstructionDescriptor(mips->get_kind()).memoryBytes != 0) {
+                counts.spillReload++;
+            } else {
+                instructionStruct decoded = decodeInstruction(mips);
+                bool writesStack = false;
+                for(registerList::iterator regIter = decoded.destinationRegisters.begin();
+                    regIter != decoded.destinationRegisters.end(); ++regIter) {
+                    writesStack = writesStack || regIter->regName == sp;
+                }
+                if (writesStack) {
+                    counts.stackAdjustment++;
+                } else {
+                    counts.otherInserted++;
+                }
+            }
+        }
+        total.finalInstructions += counts.finalInstructions;
+        total.finalCycles += counts.finalCycles;
+        total.keptOriginal += counts.keptOriginal;
+        total.userInserted += counts.userInserted;
+        total.spillReload += counts.spillReload;
+        total.hiLoSave += counts.hiLoSave;
+        total.stackAdjustment += counts.stackAdjustment;
+        total.otherInserted += counts.otherInserted;
+    }
+    frameGrowth = (int64_t)(frameConstant() - originalFrameConstant);
+}
+
+/* Prints the totals of the function */
+void growthReport::printStatistics() {
+    std::cout << functionName << " instructions before:" << std::dec << total.originalInstructions
+              << " after:" << total.finalInstructions
+              << " user:" << total.userInserted
+              << " spill/reload:" << total.spillReload
+              << " hi/lo:" << total.hiLoSave
+              << " stack:" << total.stackAdjustment
+              << " frame bytes:" << frameGrowth
+              << " cycles before:" << total.originalCycles
+              << " after:" << total.finalCycles << std::endl;
+}
+
+/* Lowest address of the function */
+rose_addr_t growthReport::getAddress() {
+    return total.address;
+}
+
+/* Writes one row of counts */
+void growthReport::writeCSVRow(std::ostream& output, std::string function, std::string block, growthCounts& counts) {
+    output << function << "," << block << ",0x" << std::hex << counts.address << std::dec
+           << "," << counts.originalInstructions << "," << counts.finalInstructions
+           << "," << counts.keptOriginal << "," << counts.userInserted
+           << "," << counts.spillReload << "," << counts.hiLoSave
+           << "," << counts.stackAdjustment << "," << counts.otherInserted
+           << "," << counts.originalCycles << "," << counts.finalCycles;
+}
+
+/* Writes the header and the rows of reports as CSV */
+void growthReport::writeCSV(std::vector<growthReport*>& reports, std::ostream& output) {
+    output << "function,block,address,original_instructions,final_instructions,kept_original,"
+           << "user_inserted,spill_reload,hilo_save,stack_adjustment,other_inserted,"
+           << "original_cycles,final_cycles,frame_growth_bytes" << std::endl;
+    for(std::vector<growthReport*>::iterator iter = reports.begin(); iter != reports.end(); ++iter) {
+        growthReport* report = *iter;
+        for(size_t number = 0; number < report->blocks.size(); ++number) {
+            std::stringstream blockName;
+            blockName << number;
+            writeCSVRow(output, report->functionName, blockName.str(), report->blocks[number]);
+            output << "," << std::endl;
+        }
+        /* The function row has the frame growth */
+        writeCSVRow(output, report->functionName, "total", report->total);
+        output << "," << report->frameGrowth << std::endl;
+    }
+}
+
+/* Writes the counts of a block or function as JSON members */
+void growthReport::writeJSONCounts(std::ostream& output, growthCounts& counts) {
+    output << "\"address\": " << std::dec << counts.address
+           << ", \"original_instructions\": " << counts.originalInstructions
+           << ", \"final_instructions\": " << counts.finalInstructions
+           << ", \"kept_original\": " << counts.keptOriginal
+           << ", \"user_inserted\": " << counts.userInserted
+           << ", \"spill_reload\": " << counts.spillReload
+           << ", \"hilo_save\": " << counts.hiLoSave
+           << ", \"stack_adjustment\": " << counts.stackAdjustment
+           << ", \"other_inserted\": " << counts.otherInserted
+           << ", \"original_cycles\": " << counts.originalCycles
+           << ", \"final_cycles\": " << counts.finalCycles;
+}
+
+/* Writes reports as a JSON object */
+void growthReport::writeJSON(std::vector<growthReport*>& reports, std::ostream& output) {
+    output << "{" << std::endl << "  \"functions\": [" << std::endl;
+    for(size_t index = 0; index < reports.size(); ++index) {
+        growthReport* report = reports[index];
+        output << "    {\"name\": \"" << report->functionName << "\", ";
+        writeJSONCounts(output, report->total);
+        output << ", \"frame_growth_bytes\": " << report->frameGrowth << "," << std::endl;
+        output << "     \"blocks\": [" << std::endl;
+        for(size_t number = 0; number < report->blocks.size(); ++number) {
+            output << "      {\"block\": " << number << ", ";
+            writeJSONCounts(output, report->blocks[number]);
+            output << "}" << (number + 1 < report->blocks.size() ? "," : "") << std::endl;
+        }
+        output << "     ]}" << (index + 1 < reports.size() ? "," : "") << std::endl;
+    }
+    output << "  ]" << std::endl << "}" << std::endl;
+}
+
+/* Writes reports to a file */
+bool growthReport::writeFile(std::vector<growthReport*>& reports, std::string file) {
+    std::ofstream output(file.c_str(), std::ios::out | std::ios::trunc);
+    if (!output) {
+        return false;
+    }
+    std::string extension = ".json";
+    if (file.size() >= extension.size() &&
+        file.compare(file.size() - extension.size(), extension.size(), extension) == 0) {
+        writeJSON(reports, output);
+    } else {
+        writeCSV(reports, output);
+    }
+    return output.good();
+}
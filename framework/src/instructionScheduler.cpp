@@ -0,0 +1,273 @@
+/* List scheduling implementation.  */
+
+#include "instructionScheduler.hpp"
+
+
+/*  STEPS
+        1. Split each block into regions. Branches, their delay slots, calls
+        and unknown instructions are barriers and keep their position.
+
+        2. Build a dependency graph of each region. Register dependencies
+        use the def/use masks from the liveness, hi/lo is included as two
+        registers. Loads and stores are ordered unless they use the same
+        base register value with non overlapping offsets.
+
+        3. Give each node the longest latency path to the end of the region
+        as priority.
+
+        4. Simulate the pipeline cycle by cycle and issue the ready node with
+        the highest priority. The original order breaks ties so nothing is
+        moved unless it removes a stall.
+*/
+
+/* Cycles until the result of an instruction can be used, MIPS 4Kc. */
+int instructionLatency(MipsInstructionKind kind) {
+    switch (getInstructionDescriptor(kind).latency) {
+        /* Loads, one cycle load-use stall */
+        case LATENCY_LOAD: return 2;
+        /* Multiply unit, result in hi/lo or rd */
+        case LATENCY_MULTIPLY: return 3;
+        /* Iterative divide */
+        case LATENCY_DIVIDE: return 35;
+        /* Everything else forwards the result to the next instruction */
+        default: return 1;
+    }
+}
+
+/* Static estimate of the cycles a statement list takes */
+int estimateStatementCycles(SgAsmStatementPtrList& stmtList) {
+    /* Cycle each register result is ready, 32 general purpose and hi/lo */
+    std::vector<int> readyCycle(34, 0);
+    int cycle = 0;
+    for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+        iter != stmtList.end(); ++iter) {
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+        if (mips == NULL) {
+            continue;
+        }
+        registerMask def, use;
+        instructionDefUse(mips, &def, &use);
+        /* Issue when all operands are ready */
+        int issue = cycle;
+        for(int reg = 0; reg < 34; ++reg) {
+            if ((use & ((registerMask)1 << reg)) != 0 && readyCycle[reg] > issue) {
+                issue = readyCycle[reg];
+            }
+        }
+        int latency = instructionLatency(mips->get_kind());
+        for(int reg = 0; reg < 34; ++reg) {
+            if ((def & ((registerMask)1 << reg)) != 0) {
+                readyCycle[reg] = issue + latency;
+            }
+        }
+        cycle = issue + 1;
+    }
+    return cycle;
+}
+
+
+/* Constructor */
+listScheduler::listScheduler(CFGhandler* handler) {
+    cfgContainer = handler;
+    cyclesBefore = 0;
+    cyclesAfter = 0;
+}
+
+/* Schedules all blocks in the function cfg */
+void listScheduler::applyScheduling() {
+    compactCFG* function = cfgContainer->getCompactCFG();
+    for(unsigned number = 0; number < function->size(); ++number) {
+        SgAsmBlock* bb = function->getBlock(number);
+        scheduleBlock(bb);
+    }
+}
+
+/* Prints the estimated cycles before and after scheduling */
+void listScheduler::printStatistics() {
+    std::cout << "list scheduling estimated cycles before:" << std::dec << cyclesBefore
+              << " after:" << cyclesAfter << std::endl;
+}
+
+/* Schedules one block */
+void listScheduler::scheduleBlock(SgAsmBlock* block) {
+    SgAsmStatementPtrList& instructionVector = block->get_statementList();
+    cyclesBefore += estimateStatementCycles(instructionVector);
+
+    SgAsmStatementPtrList scheduledVector;
+    /* Current region and the last writer of each register in it */
+    std::vector<scheduleNode> region;
+    std::vector<int> lastDef(34, -1);
+    /* The instruction after a branch is its delay slot */
+    bool delaySlot = false;
+    for(SgAsmStatementPtrList::iterator iter = instructionVector.begin();
+        iter != instructionVector.end(); ++iter) {
+        if (delaySlot || isSchedulingBarrier(*iter)) {
+            /* Schedule what is before the barrier, then keep the barrier */
+            scheduleRegion(&region, &scheduledVector);
+            region.clear();
+            lastDef.assign(34, -1);
+            scheduledVector.push_back(*iter);
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            delaySlot = (delaySlot == false && mips != NULL && hasDelaySlot(mips->get_kind()));
+        } else {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            region.push_back(createNode(mips, &lastDef, region.size()));
+        }
+    }
+    scheduleRegion(&region, &scheduledVector);
+
+    instructionVector.swap(scheduledVector);
+    cyclesAfter += estimateStatementCycles(instructionVector);
+}
+
+/* Creates the node for an instruction */
+listScheduler::scheduleNode listScheduler::createNode(SgAsmMipsInstruction* mips,
+    std::vector<int>* lastDef, int index) {
+    scheduleNode node;
+    node.statement = mips;
+    instructionDefUse(mips, &node.def, &node.use);
+    node.latency = instructionLatency(mips->get_kind());
+    node.predecessorCount = 0;
+    node.priority = 0;
+    node.earliest = 0;
+    node.scheduled = false;
+    /* Memory information */
+    instructionStruct decoded = decodeInstruction(mips);
+    node.isLoad = (decoded.format == I_RD_MEM_RS_C);
+    node.isStore = (decoded.format == I_RS_MEM_RT_C);
+    node.memoryBase = zero;
+    node.baseVersion = -1;
+    node.memoryOffset = 0;
+    node.memorySize = 0;
+    if (node.isLoad || node.isStore) {
+        /* The base register is the last source register */
+        node.memoryBase = decoded.sourceRegisters.back().regName;
+        if (node.memoryBase != symbolic_reg) {
+            node.baseVersion = (*lastDef)[node.memoryBase];
+        }
+        /* The offset is a signed 16 bit constant */
+        node.memoryOffset = static_cast<int16_t>(decoded.instructionConstant & 0xffff);
+        node.memorySize = decoded.memoryReferenceSize / 8;
+    }
+    /* Remember the writer of each register */
+    for(int reg = 0; reg < 34; ++reg) {
+        if ((node.def & ((registerMask)1 << reg)) != 0) {
+            (*lastDef)[reg] = index;
+        }
+    }
+    return node;
+}
+
+/* Checks if two memory accesses can be in any order */
+bool listScheduler::independentMemory(scheduleNode& first, scheduleNode& second) {
+    /* Loads can always be reordered with each other */
+    if (first.isStore == false && second.isStore == false) {
+        return true;
+    }
+    /* Different base registers or base values might alias */
+    if (first.memoryBase == symbolic_reg || first.memoryBase != second.memoryBase ||
+        first.baseVersion != second.baseVersion) {
+        return false;
+    }
+    /* Same base value, check that the accessed bytes do not overlap */
+    return first.memoryOffset + first.memorySize <= second.memoryOffset ||
+           second.memoryOffset + second.memorySize <= first.memoryOffset;
+}
+
+/* Instructions that nothing is moved across */
+bool listScheduler::isSchedulingBarrier(SgAsmStatement* stmt) {
+    SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmt);
+    if (mips == NULL) {
+        return true;
+    }
+    /* Branches, jumps and calls */
+    if (hasDelaySlot(mips->get_kind())) {
+        return true;
+    }
+    /* Unknown instructions, syscall, break etc. */
+    if (getInstructionFormat(mips->get_kind()) == MIPS_UNKNOWN) {
+        return true;
+    }
+    return false;
+}
+
+/* Schedules a region without barriers and appends it to the output */
+void listScheduler::scheduleRegion(std::vector<scheduleNode>* region, SgAsmStatementPtrList* output) {
+    std::vector<scheduleNode>& nodes = *region;
+    int nodeCount = nodes.size();
+    if (nodeCount == 0) {
+        return;
+    }
+    /* Build the dependency edges, edges always go forward */
+    for(int later = 0; later < nodeCount; ++later) {
+        for(int earlier = 0; earlier < later; ++earlier) {
+            int latency = -1;
+            /* Read after write waits for the result */
+            if ((nodes[earlier].def & nodes[later].use) != 0) {
+                latency = nodes[earlier].latency;
+            }
+            /* Write after read and write after write only keep the order */
+            if (latency < 0 && ((nodes[earlier].use & nodes[later].def) != 0 ||
+                (nodes[earlier].def & nodes[later].def) != 0)) {
+                latency = 0;
+            }
+            /* Memory order */
+            if (latency < 0 && (nodes[earlier].isLoad || nodes[earlier].isStore) &&
+                (nodes[later].isLoad || nodes[later].isStore) &&
+                independentMemory(nodes[earlier], nodes[later]) == false) {
+                /* A load after a store to the same location waits for the store */
+                latency = (nodes[earlier].isStore && nodes[later].isLoad) ? 1 : 0;
+            }
+            if (latency >= 0) {
+                nodes[earlier].successors.push_back(std::pair<int, int>(later, latency));
+                nodes[later].predecessorCount++;
+            }
+        }
+    }
+    /* Priority is the longest latency path to the end of the region */
+    for(int index = nodeCount - 1; index >= 0; --index) {
+        int priority = nodes[index].latency;
+        for(std::vector<std::pair<int, int> >::iterator iter = nodes[index].successors.begin();
+            iter != nodes[index].successors.end(); ++iter) {
+            priority = std::max(priority, iter->second + nodes[iter->first].priority);
+        }
+        nodes[index].priority = priority;
+    }
+    /* Issue one instruction per cycle */
+    int cycle = 0;
+    int scheduledCount = 0;
+    while (scheduledCount < nodeCount) {
+        int best = -1;
+        int nextReady = std::numeric_limits<int>::max();
+        for(int index = 0; index < nodeCount; ++index) {
+            scheduleNode& node = nodes[index];
+            if (node.scheduled || node.predecessorCount > 0) {
+                continue;
+            }
+            if (node.earliest > cycle) {
+                /* Available but waiting for an operand */
+                nextReady = std::min(nextReady, node.earliest);
+                continue;
+            }
+            if (best < 0 || node.priority > nodes[best].priority) {
+                best = index;
+            }
+        }
+        if (best < 0) {
+            /* Nothing can issue, stall until something is ready */
+            cycle = nextReady;
+            continue;
+        }
+        /* Issue the node and release its successors */
+        nodes[best].scheduled = true;
+        scheduledCount++;
+        output->push_back(nodes[best].statement);
+        for(std::vector<std::pair<int, int> >::iterator iter = nodes[best].successors.begin();
+            iter != nodes[best].successors.end(); ++iter) {
+            scheduleNode& successor = nodes[iter->first];
+            successor.earliest = std::max(successor.earliest, cycle + iter->second);
+            successor.predecessorCount--;
+        }
+        cycle++;
+    }
+}
@@ -0,0 +1,765 @@
+/* Linear scan register allocation implementation.  */
+
+#include "linearScanTransform.hpp"
+
+
+/*  STEPS
+        1. Compute liveness of the physical registers over the function cfg.
+        This includes the original and the inserted instructions, symbolic
+        registers are not part of the liveness.
+
+        2. Symbolic registers used in several blocks get a register that is
+        free in the whole function, or a stack slot of the function when no
+        register is free. In each block create a live interval for every
+        other symbolic register, from the first instruction it appears in to
+        the last. A register with a slot gets an interval as well, it is
+        loaded from the slot at the start and stored at the end.
+
+        3. Walk the intervals in start order. Give each interval a register
+        that is not live and not written by another instruction during the
+        interval and is not used by another active interval.
+
+        4. If no such register exists take one that is not referenced by the
+        instructions of the interval and save it on the stack around the
+        interval. If every register is referenced the value stays in a stack
+        slot, each instruction of the interval borrows a register that it
+        does not reference and the borrowed register is saved around it.
+
+        5. Regions of inserted instructions that change hi/lo while the
+        original code has a live value there save and restore hi/lo.
+
+        6. Increase the stack frame with the function slots and the maximum
+        number of stack slots used by a block. The slots are placed above the
+        original locals at sp+frame, the incoming argument area of the caller
+        moves up by the increase. Original sp and fp relative references to
+        it are moved. A function without an activation record can not get
+        slots and the allocation fails.
+*/
+
+/* Constructor */
+linearScanHandler::linearScanHandler(CFGhandler* handler) {
+    /* save the cfg handler pointer */
+    cfgContainer = handler;
+    liveness = NULL;
+    frameSize = -1;
+    framePointer = false;
+    globalMask = 0;
+    functionSlots = 0;
+    blockSlots = 0;
+    maximumSlotsUsed = 0;
+    intervalCount = 0;
+    spillCount = 0;
+    residentCount = 0;
+    accumulatorSaves = 0;
+    /*  Initialize the register pools. Temporaries are preferred, saved
+        registers are only used when they are dead or have to be spilled. */
+    temporaryPool = registerBit(t0) | registerBit(t1) | registerBit(t2) | registerBit(t3) |
+                    registerBit(t4) | registerBit(t5) | registerBit(t6) | registerBit(t7) |
+                    registerBit(t8) | registerBit(t9);
+    allocatablePool = temporaryPool |
+                    registerBit(s0) | registerBit(s1) | registerBit(s2) | registerBit(s3) |
+                    registerBit(s4) | registerBit(s5) | registerBit(s6) | registerBit(s7);
+}
+
+/* Function that applies the allocation to the function */
+bool linearScanHandler::applyTransformation() {
+    /* Variables */
+    compactCFG* function = cfgContainer->getCompactCFG();
+    /* Compute the physical register liveness before any block is changed */
+    liveness = new registerLiveness(function);
+    liveness->analyze();
+    /* Stack slots are placed above the original frame */
+    findFrameSize();
+    /* Values that cross blocks are not covered by the block intervals */
+    allocateGlobalRegisters();
+
+    /* Allocate the symbolic registers block by block */
+    for(unsigned block = 0; block < function->size(); ++block) {
+        allocateBlock(block);
+    }
+    /* Increase the stack with the slots that were used */
+    bool applied = modifyStack();
+
+    /* The liveness is not needed anymore */
+    delete liveness;
+    liveness = NULL;
+    return applied;
+}
+
+/* Reason of the last failure */
+std::string linearScanHandler::getError() {
+    return error;
+}
+
+/* Records the reason of a failure */
+bool linearScanHandler::fail(std::string reason) {
+    error = "Linear scan: " + reason;
+    return false;
+}
+
+/* Prints the intervals, spills and accumulator saves */
+void linearScanHandler::printStatistics() {
+    std::cout << "linear scan intervals:" << std::dec << intervalCount
+              << " global:" << globalRegisters.size()
+              << " function slots:" << functionSlots
+              << " spilled:" << spillCount
+              << " resident:" << residentCount
+              << " accumulator saves:" << accumulatorSaves << std::endl;
+}
+
+/* Gives the symbolic registers used in several blocks a function wide register */
+void linearScanHandler::allocateGlobalRegisters() {
+    compactCFG* function = cfgContainer->getCompactCFG();
+    /* First block of every symbolic register and the ones seen in another block */
+    std::map<unsigned, unsigned> firstBlock;
+    std::set<unsigned> crossing;
+    /* Registers referenced by an instruction or live somewhere in the function */
+    registerMask taken = 0;
+    for(unsigned block = 0; block < function->size(); ++block) {
+        taken |= liveness->getLiveIn(block) | liveness->getLiveOut(block);
+        SgAsmStatementPtrList& instructionVector = function->getBlock(block)->get_statementList();
+        for(size_t index = 0; index < instructionVector.size(); ++index) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(instructionVector[index]);
+            if (mips == NULL) {
+                continue;
+            }
+            registerMask def, use;
+            instructionDefUse(mips, &def, &use);
+            taken |= def | use;
+            if (mips->get_address() != 0) {
+                continue;
+            }
+            instructionStruct decoded = decodeInstruction(mips);
+            registerStruct registers[2 * maxRegisterOperands];
+            registerStruct* registersEnd = std::copy(decoded.destinationRegisters.begin(),
+                decoded.destinationRegisters.end(), registers);
+            registersEnd = std::copy(decoded.sourceRegisters.begin(), decoded.sourceRegisters.end(), registersEnd);
+            for(registerStruct* regIter = registers; regIter != registersEnd; ++regIter) {
+                if (regIter->regName != symbolic_reg) {
+                    continue;
+                }
+                std::map<unsigned, unsigned>::iterator found = firstBlock.find(regIter->symbolicNumber);
+                if (found == firstBlock.end()) {
+                    firstBlock.insert(std::make_pair(regIter->symbolicNumber, block));
+                } else if (found->second != block) {
+                    crossing.insert(regIter->symbolicNumber);
+                }
+            }
+        }
+    }
+    /*  Only temporaries, a callee saved register would have to be saved
+        in the prologue. Calls define the temporaries, so a function with
+        calls has none to give and its crossing registers live in slots. */
+    registerMask free = temporaryPool & ~taken;
+    for(std::set<unsigned>::iterator iter = crossing.begin(); iter != crossing.end(); ++iter) {
+        if (free == 0) {
+            homeSlots[*iter] = functionSlots++;
+            continue;
+        }
+        mipsRegisterName hardRegister = lowestRegister(free);
+        free &= ~registerBit(hardRegister);
+        globalMask |= registerBit(hardRegister);
+        globalRegisters[*iter] = hardRegister;
+    }
+}
+
+/* Allocates the symbolic registers in one block */
+void linearScanHandler::allocateBlock(unsigned blockNumber) {
+    SgAsmBlock* block = cfgContainer->getCompactCFG()->getBlock(blockNumber);
+    SgAsmStatementPtrList& instructionVector = block->get_statementList();
+    int instCount = instructionVector.size();
+
+    /* Physical registers live before each instruction, last entry is live out */
+    std::vector<registerMask> liveBefore;
+    liveness->getInstructionLiveness(blockNumber, &liveBefore);
+    /* def and use of each instruction and if it is inserted */
+    std::vector<registerMask> defMask(instCount, 0);
+    std::vector<registerMask> useMask(instCount, 0);
+    std::vector<bool> inserted(instCount, false);
+    for(int index = 0; index < instCount; ++index) {
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(instructionVector[index]);
+        if (mips != NULL) {
+            instructionDefUse(mips, &defMask[index], &useMask[index]);
+            inserted[index] = (mips->get_address() == 0);
+        }
+    }
+
+    /* Create the intervals, ordered by start */
+    std::vector<liveInterval> intervals;
+    buildIntervals(instructionVector, &intervals);
+    /*  Symbolic registers with a function wide register have no interval,
+        the ones with a function slot are loaded and stored around theirs. */
+    for(std::vector<liveInterval>::iterator iter = intervals.begin(); iter != intervals.end();) {
+        std::map<unsigned, int>::iterator home = homeSlots.find(iter->symbolicNumber);
+        if (globalRegisters.find(iter->symbolicNumber) != globalRegisters.end()) {
+            iter = intervals.erase(iter);
+            continue;
+        } else if (home != homeSlots.end()) {
+            iter->home = true;
+            iter->homeSlot = home->second;
+        }
+        ++iter;
+    }
+    intervalCount += intervals.size();
+    /* Reset the stack slots, they are only used within the block */
+    blockSlots = functionSlots;
+
+    /*  Linear scan. Active contains the indexes of intervals that hold
+        their register at the start of the current interval. */
+    std::map<unsigned, mipsRegisterName> symbolicToHard(globalRegisters);
+    std::vector<size_t> active;
+    for(size_t current = 0; current < intervals.size(); ++current) {
+        liveInterval& interval = intervals[current];
+        /*  Expire intervals that have ended. The current interval can reuse
+            the register of an interval ending where it starts, since the
+            operands are read before the destination is written. A saved
+            interval is restored after its end and is kept one more step, so
+            is one stored to its slot. A value loaded from its slot needs
+            the register before its first instruction. */
+        registerMask busy = 0;
+        for(std::vector<size_t>::iterator iter = active.begin(); iter != active.end();) {
+            liveInterval& other = intervals[*iter];
+            if (other.end < interval.start || (other.end == interval.start && other.saved == false &&
+                other.home == false && interval.home == false)) {
+                iter = active.erase(iter);
+            } else {
+                busy |= registerBit(other.hardRegister);
+                ++iter;
+            }
+        }
+        /*  Registers live during the interval or written by other instructions
+            within it can not hold the symbolic value. */
+        registerMask conflict = 0;
+        int last = std::max(interval.end, interval.start + 1);
+        for(int pos = interval.start + 1; pos <= last; ++pos) {
+            conflict |= liveBefore[pos];
+        }
+        for(int pos = interval.start + 1; pos < interval.end; ++pos) {
+            conflict |= defMask[pos];
+        }
+        /*  A value from its slot is loaded before the first instruction and
+            stored after the last, the register has to survive both. */
+        if (interval.home) {
+            conflict |= liveBefore[interval.start] | defMask[interval.start] | defMask[interval.end];
+        }
+        /* Prefer a free temporary then any free allocatable register */
+        registerMask candidates = allocatablePool & ~conflict & ~busy & ~globalMask;
+        if ((candidates & temporaryPool) != 0) {
+            candidates &= temporaryPool;
+        }
+        if (candidates != 0) {
+            interval.hardRegister = lowestRegister(candidates);
+            interval.saved = false;
+        } else {
+            /*  No free register, spill one that the interval does not
+                reference. It is saved before and restored after the interval. */
+            registerMask referenced = 0;
+            for(int pos = interval.start; pos <= interval.end; ++pos) {
+                referenced |= defMask[pos] | useMask[pos];
+            }
+            candidates = allocatablePool & ~referenced & ~busy & ~globalMask;
+            if (candidates == 0) {
+                /*  No register can be held over the interval, the value
+                    stays in a slot and is not active. */
+                interval.resident = true;
+                if (interval.home == false) {
+                    interval.homeSlot = blockSlots++;
+                }
+                residentCount++;
+                countStatistic(COUNT_SPILLED, 1);
+                continue;
+            }
+            interval.hardRegister = lowestRegister(candidates);
+            interval.saved = true;
+            interval.stackSlot = blockSlots++;
+            spillCount++;
+            countStatistic(COUNT_SPILLED, 1);
+        }
+        /* Save the mapping and make the interval active */
+        symbolicToHard[interval.symbolicNumber] = interval.hardRegister;
+        active.push_back(current);
+    }
+
+    /*  Resident values and the scratch slots of the registers they borrow,
+        an instruction has at most one resident per register operand. */
+    std::map<unsigned, int> residentSlots;
+    for(std::vector<liveInterval>::iterator iter = intervals.begin(); iter != intervals.end(); ++iter) {
+        if (iter->resident) {
+            residentSlots[iter->symbolicNumber] = iter->homeSlot;
+        }
+    }
+    int scratchSlot = blockSlots;
+    if (residentSlots.empty() == false) {
+        blockSlots += 2 * maxRegisterOperands;
+    }
+
+    /*  Find regions of inserted instructions that change hi/lo while the
+        original code has a live value in them. Each region gets stack slots
+        for hi, lo and a scratch register. */
+    std::vector<int> accumulatorSaveSlot(instCount, -1);
+    std::vector<int> accumulatorRestoreSlot(instCount, -1);
+    for(int regionStart = 0; regionStart < instCount; ++regionStart) {
+        if (inserted[regionStart] == false) {
+            continue;
+        }
+        /* Find the end of the region and what it writes */
+        int regionEnd = regionStart;
+        registerMask regionDef = defMask[regionStart];
+        while (regionEnd + 1 < instCount && inserted[regionEnd + 1]) {
+            regionEnd++;
+            regionDef |= defMask[regionEnd];
+        }
+        if ((regionDef & accumulatorMask & liveBefore[regionEnd + 1]) != 0) {
+            accumulatorSaveSlot[regionStart] = blockSlots;
+            accumulatorRestoreSlot[regionEnd] = blockSlots;
+            blockSlots += 3;
+            accumulatorSaves++;
+        }
+        regionStart = regionEnd;
+    }
+    /* Remember the maximum use of stack slots */
+    if (blockSlots > maximumSlotsUsed) {
+        maximumSlotsUsed = blockSlots;
+    }
+
+    /* Registers held by intervals when entering each instruction */
+    std::vector<registerMask> heldBefore(instCount + 1, globalMask);
+    for(std::vector<liveInterval>::iterator iter = intervals.begin();
+        iter != intervals.end(); ++iter) {
+        if (iter->resident) {
+            continue;
+        }
+        for(int pos = iter->start + 1; pos <= iter->end; ++pos) {
+            heldBefore[pos] |= registerBit(iter->hardRegister);
+        }
+    }
+
+    /* Build the new statement list with the saves and restores */
+    SgAsmStatementPtrList transformedInstructionVector;
+    for(int index = 0; index < instCount; ++index) {
+        /* Save spilled registers of intervals starting here */
+        for(std::vector<liveInterval>::iterator iter = intervals.begin();
+            iter != intervals.end(); ++iter) {
+            if (iter->saved && iter->start == index) {
+                transformedInstructionVector.push_back(
+                    buildStackInstruction(mips_sw, iter->hardRegister, iter->stackSlot));
+            }
+        }
+        /* Save the accumulator before the region */
+        if (accumulatorSaveSlot[index] >= 0) {
+            saveAccumulator(&transformedInstructionVector, liveBefore[index] | heldBefore[index],
+                accumulatorSaveSlot[index]);
+        }
+        /* Load the values kept in slots for the intervals starting here */
+        for(std::vector<liveInterval>::iterator iter = intervals.begin();
+            iter != intervals.end(); ++iter) {
+            if (iter->home && iter->resident == false && iter->start == index) {
+                transformedInstructionVector.push_back(
+                    buildStackInstruction(mips_lw, iter->hardRegister, iter->homeSlot));
+            }
+        }
+        /* Replace the symbolic registers and save the instruction */
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(instructionVector[index]);
+        std::vector<std::pair<int, mipsRegisterName> > borrowed;
+        if (mips != NULL && inserted[index]) {
+            if (residentSlots.empty() == false) {
+                loadResidents(mips, residentSlots, defMask[index] | useMask[index], scratchSlot,
+                    &symbolicToHard, &transformedInstructionVector, &borrowed);
+            }
+            replaceSymbolicRegisters(mips, &symbolicToHard);
+        }
+        transformedInstructionVector.push_back(instructionVector[index]);
+        storeResidents(borrowed, scratchSlot, &transformedInstructionVector);
+        /* Store the values kept in slots for the intervals ending here */
+        for(std::vector<liveInterval>::iterator iter = intervals.begin();
+            iter != intervals.end(); ++iter) {
+            if (iter->home && iter->resident == false && iter->end == index) {
+                transformedInstructionVector.push_back(
+                    buildStackInstruction(mips_sw, iter->hardRegister, iter->homeSlot));
+            }
+        }
+        /* Restore the accumulator after the region */
+        if (accumulatorRestoreSlot[index] >= 0) {
+            restoreAccumulator(&transformedInstructionVector, liveBefore[index + 1] | heldBefore[index + 1],
+                accumulatorRestoreSlot[index]);
+        }
+        /* Restore spilled registers of intervals ending here */
+        for(std::vector<liveInterval>::iterator iter = intervals.begin();
+            iter != intervals.end(); ++iter) {
+            if (iter->saved && iter->end == index) {
+                transformedInstructionVector.push_back(
+                    buildStackInstruction(mips_lw, iter->hardRegister, iter->stackSlot));
+            }
+        }
+    }
+    /* Swap the transformed vector with the one in the basic block */
+    instructionVector.swap(transformedInstructionVector);
+}
+
+/* Creates the live intervals of the symbolic registers in a block */
+void linearScanHandler::buildIntervals(SgAsmStatementPtrList& instructionVector,
+    std::vector<liveInterval>* intervals) {
+    /* Intervals by symbolic number */
+    std::map<unsigned, liveInterval> intervalMap;
+    for(size_t index = 0; index < instructionVector.size(); ++index) {
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(instructionVector[index]);
+        /* Only inserted instructions have symbolic registers */
+        if (mips == NULL || mips->get_address() != 0) {
+            continue;
+        }
+        instructionStruct decoded = decodeInstruction(mips);
+        /* Collect all register operands */
+        registerStruct registers[2 * maxRegisterOperands];
+        registerStruct* registersEnd = std::copy(decoded.destinationRegisters.begin(),
+            decoded.destinationRegisters.end(), registers);
+        registersEnd = std::copy(decoded.sourceRegisters.begin(), decoded.sourceRegisters.end(), registersEnd);
+        for(registerStruct* regIter = registers; regIter != registersEnd; ++regIter) {
+            if (regIter->regName != symbolic_reg) {
+                continue;
+            }
+            std::map<unsigned, liveInterval>::iterator found = intervalMap.find(regIter->symbolicNumber);
+            if (found == intervalMap.end()) {
+                /* First appearance, start a new interval */
+                liveInterval interval;
+                interval.symbolicNumber = regIter->symbolicNumber;
+                interval.start = index;
+                interval.end = index;
+                interval.hardRegister = zero;
+                interval.saved = false;
+                interval.stackSlot = -1;
+                interval.home = false;
+                interval.resident = false;
+                interval.homeSlot = -1;
+                intervalMap.insert(std::pair<unsigned, liveInterval>(regIter->symbolicNumber, interval));
+            } else {
+                /* Extend the interval */
+                found->second.end = index;
+            }
+        }
+    }
+    /* Move the intervals to the vector and sort them on start */
+    intervals->clear();
+    for(std::map<unsigned, liveInterval>::iterator iter = intervalMap.begin();
+        iter != intervalMap.end(); ++iter) {
+        intervals->push_back(iter->second);
+    }
+    std::sort(intervals->begin(), intervals->end(), intervalStartsBefore);
+}
+
+/* Orders intervals by their start, symbolic number breaks ties */
+bool linearScanHandler::intervalStartsBefore(const liveInterval& first, const liveInterval& second) {
+    if (first.start != second.start) {
+        return first.start < second.start;
+    }
+    return first.symbolicNumber < second.symbolicNumber;
+}
+
+/* Returns the lowest register in a mask */
+mipsRegisterName linearScanHandler::lowestRegister(registerMask mask) {
+    for(int reg = at; reg <= ra; ++reg) {
+        if ((mask & registerBit(static_cast<mipsRegisterName>(reg))) != 0) {
+            return static_cast<mipsRegisterName>(reg);
+        }
+    }
+    ASSERT_not_reachable("Linear scan: Empty register mask.");
+    return zero;
+}
+
+/* Replaces symbolic registers in an instruction with the physical ones */
+void linearScanHandler::replaceSymbolicRegisters(SgAsmMipsInstruction* mips,
+    std::map<unsigned, mipsRegisterName>* symbolicToHard) {
+    invalidateDecodedInstruction(mips);
+    SgAsmExpressionPtrList& opList = mips->get_operandList()->get_operands();
+    for(SgAsmExpressionPtrList::iterator opIter = opList.begin();
+        opIter != opList.end(); ++opIter) {
+        if ((*opIter)->variantT() == V_SgAsmDirectRegisterExpression) {
+            (*opIter) = replaceRegisterExpression(*opIter, symbolicToHard);
+        } else if ((*opIter)->variantT() == V_SgAsmMemoryReferenceExpression) {
+            /* The base register of a memory reference can be symbolic as well */
+            SgAsmMemoryReferenceExpression* memRef = isSgAsmMemoryReferenceExpression(*opIter);
+            SgAsmBinaryAdd* binAdd = isSgAsmBinaryAdd(memRef->get_address());
+            if (binAdd != NULL) {
+                binAdd->set_lhs(replaceRegisterExpression(binAdd->get_lhs(), symbolicToHard));
+            }
+        }
+    }
+}
+
+/* Replaces a single register expression if it is symbolic */
+SgAsmExpression* linearScanHandler::replaceRegisterExpression(SgAsmExpression* expr,
+    std::map<unsigned, mipsRegisterName>* symbolicToHard) {
+    registerStruct rStruct = decodeRegister(expr);
+    if (rStruct.regName != symbolic_reg) {
+        return expr;
+    }
+    /* Every symbolic register in the block has an interval */
+    rStruct.regName = symbolicToHard->find(rStruct.symbolicNumber)->second;
+    return buildRegister(rStruct);
+}
+
+/*  Loads the resident symbolic registers of an inserted instruction. Each
+    borrows a register that the instruction does not reference, an
+    instruction references at most six registers so one of the allocatable
+    registers is always left. */
+void linearScanHandler::loadResidents(SgAsmMipsInstruction* mips, std::map<unsigned, int>& residentSlots,
+    registerMask referenced, int scratchSlot, std::map<unsigned, mipsRegisterName>* symbolicToHard,
+    SgAsmStatementPtrList* list, std::vector<std::pair<int, mipsRegisterName> >* borrowed) {
+    instructionStruct decoded = decodeInstruction(mips);
+    registerStruct registers[2 * maxRegisterOperands];
+    registerStruct* registersEnd = std::copy(decoded.destinationRegisters.begin(),
+        decoded.destinationRegisters.end(), registers);
+    registersEnd = std::copy(decoded.sourceRegisters.begin(), decoded.sourceRegisters.end(), registersEnd);
+    /* The registers of the other symbolic operands can not be borrowed */
+    std::vector<unsigned> residents;
+    for(registerStruct* regIter = registers; regIter != registersEnd; ++regIter) {
+        if (regIter->regName != symbolic_reg) {
+            continue;
+        }
+        if (residentSlots.find(regIter->symbolicNumber) == residentSlots.end()) {
+            referenced |= registerBit(symbolicToHard->find(regIter->symbolicNumber)->second);
+        } else if (std::find(residents.begin(), residents.end(), regIter->symbolicNumber) == residents.end()) {
+            residents.push_back(regIter->symbolicNumber);
+        }
+    }
+    for(std::vector<unsigned>::iterator iter = residents.begin(); iter != residents.end(); ++iter) {
+        mipsRegisterName reg = lowestRegister(allocatablePool & ~referenced);
+        referenced |= registerBit(reg);
+        int homeSlot = residentSlots[*iter];
+        list->push_back(buildStackInstruction(mips_sw, reg, scratchSlot + borrowed->size()));
+        list->push_back(buildStackInstruction(mips_lw, reg, homeSlot));
+        (*symbolicToHard)[*iter] = reg;
+        borrowed->push_back(std::make_pair(homeSlot, reg));
+    }
+}
+
+/* Stores the resident values back and restores the borrowed registers */
+void linearScanHandler::storeResidents(std::vector<std::pair<int, mipsRegisterName> >& borrowed,
+    int scratchSlot, SgAsmStatementPtrList* list) {
+    for(size_t index = borrowed.size(); index > 0; --index) {
+        list->push_back(buildStackInstruction(mips_sw, borrowed[index - 1].second, borrowed[index - 1].first));
+        list->push_back(buildStackInstruction(mips_lw, borrowed[index - 1].second, scratchSlot + index - 1));
+    }
+}
+
+/*  Inserts instructions saving hi and lo before a region. A register that
+    is not in the avoid mask is used for the moves, if there is none then
+    t0 is saved in the scratch slot and used. */
+void linearScanHandler::saveAccumulator(SgAsmStatementPtrList* list, registerMask avoid, int firstSlot) {
+    registerMask candidates = temporaryPool & ~avoid;
+    bool scratch = (candidates == 0);
+    mipsRegisterName moveReg = scratch ? t0 : lowestRegister(candidates);
+    if (scratch) {
+        list->push_back(buildStackInstruction(mips_sw, moveReg, firstSlot + 2));
+    }
+    list->push_back(buildAccumulatorMove(mips_mfhi, moveReg));
+    list->push_back(buildStackInstruction(mips_sw, moveReg, firstSlot));
+    list->push_back(buildAccumulatorMove(mips_mflo, moveReg));
+    list->push_back(buildStackInstruction(mips_sw, moveReg, firstSlot + 1));
+    if (scratch) {
+        list->push_back(buildStackInstruction(mips_lw, moveReg, firstSlot + 2));
+    }
+}
+
+/* Inserts instructions restoring hi and lo after a region. */
+void linearScanHandler::restoreAccumulator(SgAsmStatementPtrList* list, registerMask avoid, int firstSlot) {
+    registerMask candidates = temporaryPool & ~avoid;
+    bool scratch = (candidates == 0);
+    mipsRegisterName moveReg = scratch ? t0 : lowestRegister(candidates);
+    if (scratch) {
+        list->push_back(buildStackInstruction(mips_sw, moveReg, firstSlot + 2));
+    }
+    list->push_back(buildStackInstruction(mips_lw, moveReg, firstSlot));
+    list->push_back(buildAccumulatorMove(mips_mthi, moveReg));
+    list->push_back(buildStackInstruction(mips_lw, moveReg, firstSlot + 1));
+    list->push_back(buildAccumulatorMove(mips_mtlo, moveReg));
+    if (scratch) {
+        list->push_back(buildStackInstruction(mips_lw, moveReg, firstSlot + 2));
+    }
+}
+
+/* Builds a load or store of a stack slot */
+SgAsmMipsInstruction* linearScanHandler::buildStackInstruction(MipsInstructionKind kind,
+    mipsRegisterName regName, int slot) {
+    /* Stack pointer register */
+    registerStruct spStruct;
+    spStruct.regName = sp;
+    /* The register being saved or restored */
+    registerStruct dataReg;
+    dataReg.regName = regName;
+    instructionStruct loadstoreStruct;
+    loadstoreStruct.kind = kind;
+    loadstoreStruct.format = getInstructionFormat(kind);
+    if (mips_lw == kind) {
+        loadstoreStruct.mnemonic = "lw";
+        loadstoreStruct.destinationRegisters.push_back(dataReg);
+        loadstoreStruct.sourceRegisters.push_back(spStruct);
+    } else if (mips_sw == kind) {
+        loadstoreStruct.mnemonic = "sw";
+        loadstoreStruct.sourceRegisters.push_back(spStruct);
+        loadstoreStruct.sourceRegisters.push_back(dataReg);
+    } else {
+        ASSERT_not_reachable("Invalid kind supplied for stack instruction build function");
+    }
+    /*  the slots are placed above the original frame, in the space the
+        increase of the frame makes below the incoming arguments */
+    loadstoreStruct.memoryReferenceSize = 32;
+    loadstoreStruct.significantBits = 32;
+    loadstoreStruct.isSignedMemory = true;
+    loadstoreStruct.instructionConstant = frameSize + slot * 4;
+    SgAsmMipsInstruction* slotInstruction = buildInstruction(&loadstoreStruct);
+    slotInstructions.insert(slotInstruction);
+    return slotInstruction;
+}
+
+/* Builds mfhi, mflo, mthi or mtlo */
+SgAsmMipsInstruction* linearScanHandler::buildAccumulatorMove(MipsInstructionKind kind, mipsRegisterName regName) {
+    registerStruct moveReg;
+    moveReg.regName = regName;
+    instructionStruct move;
+    move.kind = kind;
+    move.format = getInstructionFormat(kind);
+    switch (kind) {
+        case mips_mfhi: move.mnemonic = "mfhi"; move.destinationRegisters.push_back(moveReg); break;
+        case mips_mflo: move.mnemonic = "mflo"; move.destinationRegisters.push_back(moveReg); break;
+        case mips_mthi: move.mnemonic = "mthi"; move.sourceRegisters.push_back(moveReg); break;
+        case mips_mtlo: move.mnemonic = "mtlo"; move.sourceRegisters.push_back(moveReg); break;
+        default: {
+            ASSERT_not_reachable("Invalid kind supplied for accumulator move build function");
+        }
+    }
+    return buildInstruction(&move);
+}
+
+/* Reads the original stack frame size from the activation record */
+void linearScanHandler::findFrameSize() {
+    std::pair<SgAsmInstruction*, SgAsmInstruction*> activationRecordPair;
+    activationRecordPair = cfgContainer->getActivationRecord();
+    SgAsmMipsInstruction* allocMips = isSgAsmMipsInstruction(activationRecordPair.first);
+    if (allocMips == NULL) {
+        /* The function has no stack frame */
+        frameSize = -1;
+        return;
+    }
+    /* addiu sp, sp, -frame. The constant is a signed 16 bit value */
+    instructionStruct allocInst = decodeInstruction(allocMips);
+    frameSize = -static_cast<int16_t>(allocInst.instructionConstant & 0xffff);
+    /* move fp, sp makes fp address the frame as well */
+    compactCFG* function = cfgContainer->getCompactCFG();
+    for(unsigned block = 0; block < function->size(); ++block) {
+        SgAsmStatementPtrList& instructionVector = function->getBlock(block)->get_statementList();
+        for(size_t index = 0; index < instructionVector.size(); ++index) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(instructionVector[index]);
+            if (mips == NULL || mips->get_address() == 0) {
+                continue;
+            }
+            instructionStruct decoded = decodeInstruction(mips);
+            if (decoded.format == R_RD_RS_RT && decoded.destinationRegisters.size() == 1 &&
+                decoded.destinationRegisters[0].regName == fp && decoded.sourceRegisters.size() == 2 &&
+                ((decoded.sourceRegisters[0].regName == sp && decoded.sourceRegisters[1].regName == zero) ||
+                 (decoded.sourceRegisters[0].regName == zero && decoded.sourceRegisters[1].regName == sp))) {
+                framePointer = true;
+            }
+        }
+    }
+}
+
+/* Increases the stack frame with the used slots */
+bool linearScanHandler::modifyStack() {
+    /* Nothing was spilled, the frame is unchanged */
+    if (maximumSlotsUsed == 0) {
+        return true;
+    }
+    if (frameSize < 0) {
+        return fail("stack slots needed but the function has no activation record.");
+    }
+    /* The stack pointer has to stay 8 byte aligned */
+    uint64_t increase = ((maximumSlotsUsed * 4) + 7) & ~7;
+    std::pair<SgAsmInstruction*, SgAsmInstruction*> activationRecordPair;
+    activationRecordPair = cfgContainer->getActivationRecord();
+    SgAsmMipsInstruction* recordMips[2];
+    recordMips[0] = isSgAsmMipsInstruction(activationRecordPair.first);
+    recordMips[1] = isSgAsmMipsInstruction(activationRecordPair.second);
+    for(int record = 0; record < 2; ++record) {
+        if (recordMips[record] == NULL) {
+            continue;
+        }
+        invalidateDecodedInstruction(recordMips[record]);
+        SgAsmExpressionPtrList& operands = recordMips[record]->get_operandList()->get_operands();
+        for(SgAsmExpressionPtrList::iterator iter = operands.begin();
+            iter != operands.end(); ++iter) {
+            /*  Find the constant in the instruction */
+            if (V_SgAsmIntegerValueExpression == (*iter)->variantT()) {
+                SgAsmIntegerValueExpression* valConst = isSgAsmIntegerValueExpression(*iter);
+                uint64_t constant = valConst->get_absoluteValue();
+                /* Allocation subtracts more, deallocation adds more */
+                if (record == 0) {
+                    constant -= increase;
+                } else {
+                    constant += increase;
+                }
+                valConst->set_absoluteValue(constant);
+            }
+        }
+    }
+    /* The incoming argument area is above the grown frame */
+    return shiftIncomingOffsets(increase);
+}
+
+/*  Moves original references to the incoming argument area. Loads, stores
+    and address computations relative to sp, or fp when it is a copy of sp,
+    with an offset at or above the original frame size get the increase. */
+bool linearScanHandler::shiftIncomingOffsets(int increase) {
+    std::pair<SgAsmInstruction*, SgAsmInstruction*> activationRecordPair;
+    activationRecordPair = cfgContainer->getActivationRecord();
+    registerMask frameBases = registerBit(sp) | (framePointer ? registerBit(fp) : 0);
+    compactCFG* function = cfgContainer->getCompactCFG();
+    for(unsigned block = 0; block < function->size(); ++block) {
+        SgAsmStatementPtrList& instructionVector = function->getBlock(block)->get_statementList();
+        for(size_t index = 0; index < instructionVector.size(); ++index) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(instructionVector[index]);
+            if (mips == NULL || slotInstructions.count(mips) != 0 ||
+                mips == activationRecordPair.first || mips == activationRecordPair.second) {
+                continue;
+            }
+            instructionStruct decoded = decodeInstruction(mips);
+            if (decoded.sourceRegisters.empty() ||
+                (frameBases & registerBit(decoded.sourceRegisters[0].regName)) == 0) {
+                continue;
+            }
+            /* A memory access with the base first, or addiu rd, base, offset */
+            bool memoryAccess = getInstructionDescriptor(decoded.kind).memoryBytes != 0;
+            bool addressComputation = decoded.kind == mips_addiu && decoded.destinationRegisters.size() == 1 &&
+                decoded.destinationRegisters[0].regName != sp;
+            if (memoryAccess == false && addressComputation == false) {
+                continue;
+            }
+            int offset = static_cast<int16_t>(decoded.instructionConstant & 0xffff);
+            if (offset < frameSize) {
+                continue;
+            }
+            if (offset + increase > 0x7fff) {
+                return fail("an incoming argument offset does not fit the grown frame.");
+            }
+            setInstructionOffset(mips, offset + increase);
+        }
+    }
+    return true;
+}
+
+/* Sets the 16 bit offset of a load, store or addiu */
+void linearScanHandler::setInstructionOffset(SgAsmMipsInstruction* mips, int offset) {
+    invalidateDecodedInstruction(mips);
+    SgAsmExpressionPtrList& operands = mips->get_operandList()->get_operands();
+    for(SgAsmExpressionPtrList::iterator iter = operands.begin(); iter != operands.end(); ++iter) {
+        SgAsmIntegerValueExpression* valConst = isSgAsmIntegerValueExpression(*iter);
+        SgAsmMemoryReferenceExpression* memRef = isSgAsmMemoryReferenceExpression(*iter);
+        if (memRef != NULL && isSgAsmBinaryAdd(memRef->get_address()) != NULL) {
+            valConst = isSgAsmIntegerValueExpression(isSgAsmBinaryAdd(memRef->get_address())->get_rhs());
+        }
+        if (valConst != NULL) {
+            valConst->set_absoluteValue(static_cast<uint64_t>(offset) & 0xffff);
+            return;
+        }
+    }
+    ASSERT_not_reachable("Linear scan: No offset found in a frame reference.");
+}
@@ -5,6 +5,8 @@
 
 /* header file */
 #include "mipsISA.hpp"
+#include "decodeCache.hpp"
+#include "nodeRegistry.hpp"
 
 
 /******************************************************************************
@@ -14,8 +16,8 @@
 /********** Building instruction functions **********/
 /* Builds an SgAsmMipsInstruction that can be inserted into the binary */
 SgAsmMipsInstruction* buildInstruction(instructionStruct* instInfo); 
-/* Build operand list */
-SgAsmOperandList* buildOperandList(instructionStruct*, bool, bool, bool, bool, bool);
+/* Build operand list from the operandRole bits */
+SgAsmOperandList* buildOperandList(instructionStruct*, unsigned);
 /* Creates a register expression */
 SgAsmDirectRegisterExpression* buildRegister(registerStruct);
 /* Create a value expression, constant */
@@ -26,8 +28,8 @@ SgAsmMemoryReferenceExpression* buildMemoryReference(instructionStruct*);
 /********** Decoding instruction functions. **********/
 /* Decode the instruction */
 instructionStruct decodeInstruction(SgAsmMipsInstruction*);
-/* operandList decoder, decodes the operands in the list. */
-instructionStruct decodeOpList(SgAsmExpressionPtrList*, bool, bool, bool, bool, bool);
+/* operandList decoder, decodes the operands given by the operandRole bits. */
+instructionStruct decodeOpList(SgAsmExpressionPtrList*, unsigned);
 /* decode register names */
 registerStruct decodeRegister(SgAsmExpression*); 
 /* decode value expression, a constant */
@@ -51,78 +53,17 @@ static biRegMap registerNameMap = initRegisterNameMap();
 ******************************************************************************/
 /* Builds an SgAsmMipsInstruction that can be inserted into the binary */
 SgAsmMipsInstruction* buildInstruction(instructionStruct* instInfo) {
+    /* The operand nodes are built under the same lock */
+    boost::recursive_mutex::scoped_lock lock(frameworkNodeMutex());
     /* Construct a mips instruction, use information from the struct. */
     SgAsmMipsInstruction* mipsInst = new SgAsmMipsInstruction;
+    trackFrameworkNode(mipsInst, sizeof(SgAsmMipsInstruction));
     /* Create statementlist pointer reference */
-    SgAsmOperandList* asmOpList; 
-    /* depending on instruction format use right arguments for build function
-        and create the operandlist. */
-    switch (instInfo->format) {
-        /* R instructions */
-        case R_RD_RS_RT :{
-            asmOpList = buildOperandList(instInfo, true, true, true, false, false);
-            break;
-        }
-        case R_RD_RS_C  :{
-            asmOpList = buildOperandList(instInfo, true, true, false, true, false);
-            break;
-        }
-        case R_RD       :{
-            asmOpList = buildOperandList(instInfo, true, false, false, false, false);
-            break;
-        }
-        case R_RS_RT    :{
-            asmOpList = buildOperandList(instInfo, false, true, true, false, false);
-            break;
-        }
-        case R_RS       :{
-            asmOpList = buildOperandList(instInfo, false, true, false, false, false);
-            break;
-        }
-        case R_NOP  :{
-            break;
-        }
-        /* I instructions  */
-        case I_RD_RS_C   :{
-            asmOpList = buildOperandList(instInfo, true, true, false, true, false);
-            break;
-        }
-        case I_RD_MEM_RS_C:{
-            asmOpList = buildOperandList(instInfo, true, false, false, false, true);
-            break;
-        }
-        case I_RD_C      :{
-            asmOpList = buildOperandList(instInfo, true, false, false, true, false);
-            break;
-        }
-        case I_RS_RT_C   :{
-            asmOpList = buildOperandList(instInfo, false, true, true, true, false);
-            break;
-        }
-        case I_RS_MEM_RT_C:{
-            asmOpList = buildOperandList(instInfo, false, true, false, false, true);
-            break;
-        }
-        case I_RS_C      :{
-            asmOpList = buildOperandList(instInfo, false, true, false, true, false);
-            break;
-        }
-        /* J instructions */
-        case J_C        :{
-            asmOpList = buildOperandList(instInfo, false, false, false, true, false);
-            break;
-        }
-        case J_RS       :{
-            asmOpList = buildOperandList(instInfo, false, true, false, false, false);
-            break;
-        }
-        case J_RD_RS    :{
-            asmOpList = buildOperandList(instInfo, true, true, false, false, false);
-            break;
-        }
-        default: {
-            //The instruction is unknown.
-        }
+    SgAsmOperandList* asmOpList = NULL;
+    /* The operand roles of the descriptor decide the operand list. Unknown
+        instructions are not built with operands. */
+    if (instInfo->format != MIPS_UNKNOWN) {
+        asmOpList = buildOperandList(instInfo, getInstructionDescriptor(instInfo->kind).operands);
     }
     /* Set the general values of the instruction. */
     mipsInst->set_kind(instInfo->kind);
@@ -130,83 +71,36 @@ SgAsmMipsInstruction* buildInstruction(instructionStruct* instInfo) {
     mipsInst->set_address(instInfo->address);
     /* Attach the operand list to the instruction */
     mipsInst->set_operandList(asmOpList);
+    /* A new node can reuse the memory of a deleted one, drop a stale decode */
+    invalidateDecodedInstruction(mipsInst);
 
     return mipsInst;
 }
 
-/* decode instruction. Calls on the R,I or J decode functions. */
+/* decode instruction. Uses the active cache, decodes on a miss. */
 instructionStruct decodeInstruction(SgAsmMipsInstruction* inst) {
+    decodeCache* cache = getActiveDecodeCache();
+    if (cache != NULL) {
+        return cache->decode(inst);
+    }
+    return decodeInstructionOperands(inst);
+}
+
+/* decode the operands. Calls on the R,I or J decode functions. */
+instructionStruct decodeInstructionOperands(SgAsmMipsInstruction* inst) {
     instructionStruct instStruct;
-    /* Check what kind of instruction format it is.  */
-    instructionType format = getInstructionFormat(inst->get_kind());
+    /* The format and the operand roles come from the descriptor table */
+    const instructionDescriptor& descriptor = getInstructionDescriptor(inst->get_kind());
+    instructionType format = descriptor.format;
     /* get the operand list */
     SgAsmExpressionPtrList* operandList = &inst->get_operandList()->get_operands();
-    /* depending on instruction format use right arguments for decode function
-        and save the returned instruction struct. */
-    switch (format) {
-        /* R instructions */
-        case R_RD_RS_RT :{
-            instStruct = decodeOpList(operandList, true, true, true, false, false);
-            break;
-        }
-        case R_RD_RS_C  :{
-            instStruct = decodeOpList(operandList, true, true, false, true, false);
-            break;
-        }
-        case R_RD       :{
-            instStruct = decodeOpList(operandList, true, false, false, false, false);
-            break;
-        }
-        case R_RS_RT    :{
-            instStruct = decodeOpList(operandList, false, true, true, false, false);
-            break;
-        }
-        case R_RS       :{
-            instStruct = decodeOpList(operandList, false, true, false, false, false);
-            break;
-        }
-        case R_NOP  :{
-            break;
-        }
-        /* I instructions  */
-        case I_RD_RS_C   :
-            instStruct = decodeOpList(operandList, true, true, false, true, false);
-            break;
-        case I_RD_MEM_RS_C: 
-            instStruct = decodeOpList(operandList, true, false, false, false, true);
-            break;
-        case I_RD_C      :
-            instStruct = decodeOpList(operandList, true, false, false, true, false);
-            break;
-        case I_RS_RT_C   :
-            instStruct = decodeOpList(operandList, false, true, true, true, false);
-            break;
-        case I_RS_MEM_RT_C:
-            instStruct = decodeOpList(operandList, false, true, false, false, true);
-            break;
-        case I_RS_C      : {
-            instStruct = decodeOpList(operandList, false, true, false, true, false);
-            break;
-        }
-        /* J instructions */
-        case J_C        :
-            instStruct = decodeOpList(operandList, false, false, false, true, false);
-            break;
-        case J_RS       :
-            instStruct = decodeOpList(operandList, false, true, false, false, false);
-            break;
-        case J_RD_RS    : {
-            instStruct = decodeOpList(operandList, true, true, false, false, false);
-            break;
-        }
-        default: {
-            //The instruction is unknown.
-        }
+    if (format != MIPS_UNKNOWN) {
+        instStruct = decodeOpList(operandList, descriptor.operands);
     }
     /* Save the address of the instruction, consider other
        values that are common to all instructions. kind,mnemonic, */
     instStruct.kind = inst->get_kind();
-    instStruct.mnemonic = inst->get_mnemonic();
+    instStruct.mnemonic = instructionMnemonic(inst->get_kind());
     instStruct.address = inst->get_address();
     instStruct.format = format;
 
@@ -218,15 +112,15 @@ instructionStruct decodeInstruction(SgAsmMipsInstruction* inst) {
 /******************************************************************************
 * Build/decode operandlist functions.
 ******************************************************************************/
-/* Build operand list */
-SgAsmOperandList* buildOperandList(instructionStruct* inst,
-    bool hasRD, bool hasRS, bool hasRT, bool hasC, bool memOp) {
+/* Build operand list, the roles are in operand order RD, RS, RT, C, MEM */
+SgAsmOperandList* buildOperandList(instructionStruct* inst, unsigned roles) {
     /* variables */
     SgAsmOperandList* asmOpListPtr = new SgAsmOperandList;
+    trackFrameworkNode(asmOpListPtr, sizeof(SgAsmOperandList));
     /* Get the expression list that we can insert expressions into */
     SgAsmExpressionPtrList& exprList = asmOpListPtr->get_operands();    
     //TODO consider not poping the registers and instead indexing */
-    if (true == hasRD) {
+    if ((roles & OPERAND_RD) != 0) {
         /* Build RD register expression */
         SgAsmDirectRegisterExpression* regRD = buildRegister(inst->destinationRegisters.back());
         /* Remove the register from the vector */
@@ -234,7 +128,7 @@ SgAsmOperandList* buildOperandList(instructionStruct* inst,
         /* Add the rd register to the operand list */
         exprList.push_back(regRD);
     }
-    if (true == hasRS) {
+    if ((roles & OPERAND_RS) != 0) {
         /* Build RS register expression */
         SgAsmDirectRegisterExpression* regRS = buildRegister(inst->sourceRegisters.back());
         /* Remove the register from the vector */
@@ -242,7 +136,7 @@ SgAsmOperandList* buildOperandList(instructionStruct* inst,
         /* Add the rs register to the operand list */
         exprList.push_back(regRS);
     }
-    if (true == hasRT) {
+    if ((roles & OPERAND_RT) != 0) {
         /* Build RT register expression */
         SgAsmDirectRegisterExpression* regRT = buildRegister(inst->sourceRegisters.back());
         /* Remove the register from the vector */
@@ -250,13 +144,13 @@ SgAsmOperandList* buildOperandList(instructionStruct* inst,
         /* Add the rs register to the operand list */
         exprList.push_back(regRT);
     }
-    if (true == hasC) {
+    if ((roles & OPERAND_C) != 0) {
         /* Build constant expression */
         SgAsmIntegerValueExpression* constExpr = buildValueExpression(inst);
         /* Add the constant expression to the operand list */
         exprList.push_back(constExpr);
     }
-    if (true == memOp) {
+    if ((roles & OPERAND_MEM) != 0) {
         /* this is a memory instruction, extract the register and memory constant. */
         SgAsmMemoryReferenceExpression* memExpr = buildMemoryReference(inst);
         /* Add memory expression to the operand list */
@@ -266,15 +160,14 @@ SgAsmOperandList* buildOperandList(instructionStruct* inst,
     return asmOpListPtr;
 }
 
-/* operandList decoder, decodes the operands in the list. */
-instructionStruct decodeOpList(SgAsmExpressionPtrList* operandList,
-    bool hasRD, bool hasRS, bool hasRT, bool hasC, bool memOp) {
+/* operandList decoder, decodes the operands given by the roles in the list. */
+instructionStruct decodeOpList(SgAsmExpressionPtrList* operandList, unsigned roles) {
     /* variables */
     int opIndex = 0;
     instructionStruct instruction;
     /* Fill the struct with information. Check if for each type of value if it
-       is present in the instruction by checking the booleans. */
-    if (true == hasRD) {
+       is present in the instruction by checking the roles. */
+    if ((roles & OPERAND_RD) != 0) {
         /* Has a destination register, extract it. */
         registerStruct RDstruct = decodeRegister((*operandList)[opIndex]);       
         /* Insert the register into the struct as a destination register */
@@ -282,7 +175,7 @@ instructionStruct decodeOpList(SgAsmExpressionPtrList* operandList,
         /* Increment the operand index */
         opIndex++;
     }
-    if (true == hasRS) {
+    if ((roles & OPERAND_RS) != 0) {
         /* Has a rs register operand, extract it. */
         registerStruct RSstruct = decodeRegister((*operandList)[opIndex]);
         /* insert the registers into the struct as a source register */
@@ -290,7 +183,7 @@ instructionStruct decodeOpList(SgAsmExpressionPtrList* operandList,
         /* Increment the operand index */
         opIndex++;
     }
-    if (true == hasRT) {
+    if ((roles & OPERAND_RT) != 0) {
         /* Has a rt register operand, extract it. */
         registerStruct RTstruct = decodeRegister((*operandList)[opIndex]);       
         /* insert the registers into the struct as a source register */
@@ -298,13 +191,13 @@ instructionStruct decodeOpList(SgAsmExpressionPtrList* operandList,
         /* Increment the operand index */
         opIndex++;
     }
-    if (true == hasC) {
+    if ((roles & OPERAND_C) != 0) {
         /* get the relevant values from the constant */
         decodeValueExpression((*operandList)[opIndex], &instruction);
         /* increment the operand index */
         opIndex++;
     }
-    if (true == memOp) {
+    if ((roles & OPERAND_MEM) != 0) {
         /* this is a memory instruction, extract the register and memory constant. */
         decodeMemoryReference((*operandList)[opIndex], &instruction);       
     }
@@ -316,24 +209,19 @@ instructionStruct decodeOpList(SgAsmExpressionPtrList* operandList,
 /******************************************************************************
 * Build/decode register functions.
 ******************************************************************************/
-/* Creates a register expression */
+/*  Creates a register expression. Every operand naming the same register
+    in a function gets the same node, see symbolicRegisterContext for the
+    parent pointer rule. */
 SgAsmDirectRegisterExpression* buildRegister(registerStruct regStruct) {
-    /* Register expression, requires a register descriptor, it is
-        initially created as a zero register descriptor, however minor
-        needs to be set again. */
-    RegisterDescriptor rd = RegisterDescriptor(mips_regclass_gpr, 0, 0, 32);
     /* Direct register expression ptr */
     SgAsmDirectRegisterExpression* directReg;
 
-    /* If the register descriptor is not a symbolic register then
-        the minor number needs to be set to the correct register */
+    /* A physical register is the shared expression of the function, looked
+        up by its number. Nothing is allocated after the first use. */
     if (regStruct.regName != symbolic_reg) {
-        /* Get the number or the regname and set it to minor */
-        unsigned newMinor = registerNameMap.right.find(regStruct.regName)->second;
-        rd.set_minor(newMinor);
-        /* Construct the directregisterexpression with the register descriptor */
-        directReg = new SgAsmDirectRegisterExpression(rd);
-    } else if (regStruct.regName == symbolic_reg) {
+        unsigned minor = registerNameMap.right.find(regStruct.regName)->second;
+        directReg = getPhysicalRegisterExpression(minor);
+    } else {
         /* if the register is symbolic the register expression needs
             to be retrieved from the map */
         directReg = getDirectRegisterExpression(regStruct.symbolicNumber);
@@ -380,6 +268,8 @@ SgAsmIntegerValueExpression* buildValueExpression(instructionStruct* container)
         SgAsmIntegerType(ByteOrder::ORDER_LSB, container->significantBits, container->isSignedConstant);
     //
     SgAsmIntegerValueExpression* intValExpr = new SgAsmIntegerValueExpression(container->instructionConstant, integerType);
+    trackFrameworkNode(integerType, sizeof(SgAsmIntegerType));
+    trackFrameworkNode(intValExpr, sizeof(SgAsmIntegerValueExpression));
 
     //TODO This could be set by passing this value and an integertype with the constructor....fixes the size of the significant bits.
     //intValExpr->set_absoluteValue(constantVal);
@@ -421,6 +311,7 @@ SgAsmMemoryReferenceExpression* buildMemoryReference(instructionStruct* containe
 
     /* Create a binary expression with the lhs and rhs expressions. */
     SgAsmBinaryAdd* binAdd = new SgAsmBinaryAdd(lhs_reg, rhs_valexpr);
+    trackFrameworkNode(binAdd, sizeof(SgAsmBinaryAdd));
 
     /* Create the memoryexpression and set the type */
     //TODO consider adding segment expression 
@@ -430,6 +321,8 @@ SgAsmMemoryReferenceExpression* buildMemoryReference(instructionStruct* containe
         SgAsmIntegerType(ByteOrder::ORDER_LSB, container->memoryReferenceSize, container->isSignedMemory);
     /* Set the type in the memoryreference */
     memRef->set_type(integerType);
+    trackFrameworkNode(memRef, sizeof(SgAsmMemoryReferenceExpression));
+    trackFrameworkNode(integerType, sizeof(SgAsmIntegerType));
     
     return memRef;
 }
@@ -454,115 +347,485 @@ void decodeMemoryReference(SgAsmExpression* inst, instructionStruct* instStruct)
 
 
 /******************************************************************************
-* Return the instruction format.
+* Instruction descriptor table. One row per instruction kind the framework
+* knows. Each row specializes kindDescriptor for its kind, the dense table
+* indexed by kind is built from the specializations at compile time so it is
+* constant initialized and a lookup is a single index. Kinds without a row
+* are unknown and have no properties. Everything the framework needs to know
+* about an instruction kind is kept here, other functions read the table
+* instead of switching on the kind.
 ******************************************************************************/
+/* Properties of a kind, the default is an unknown kind */
+template<int kind> struct kindDescriptor {
+    enum {
+        format = MIPS_UNKNOWN, operands = 0, accumulator = 0, memoryBytes = 0,
+        memorySigned = false, flags = 0, latency = LATENCY_SINGLE
+    };
+};
+
+/* Short names for the table */
+#define ACC_R   (ACCUMULATOR_READ_HI | ACCUMULATOR_READ_LO)
+#define ACC_W   (ACCUMULATOR_WRITE_HI | ACCUMULATOR_WRITE_LO)
+#define BR      (INSTRUCTION_BRANCH | INSTRUCTION_DELAY_SLOT)
+#define OP_RD   OPERAND_RD
+#define OP_RS   OPERAND_RS
+#define OP_RT   OPERAND_RT
+#define OP_C    OPERAND_C
+#define OP_MEM  OPERAND_MEM
+#define DESCRIBE(KIND, FORMAT, OPERANDS, ACCUMULATOR, BYTES, SIGNED, FLAGS, LATENCY) \
+    template<> struct kindDescriptor<KIND> { \
+        enum { \
+            format = FORMAT, operands = OPERANDS, accumulator = ACCUMULATOR, memoryBytes = BYTES, \
+            memorySigned = SIGNED, flags = FLAGS, latency = LATENCY \
+        }; \
+    };
+
+/*       kind         format         operands               accumulator          mem signed  flags                                   latency */
+/* Arithmetic and logic */
+DESCRIBE(mips_add,    R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_addu,   R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_sub,    R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_subu,   R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_and,    R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_nor,    R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_or,     R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_xor,    R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_sllv,   R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_srav,   R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_srlv,   R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_slt,    R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_sltu,   R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_mul,    R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, ACC_W,                0, false, 0,                                      LATENCY_MULTIPLY)
+DESCRIBE(mips_movn,   R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, INSTRUCTION_MERGES_DESTINATION,         LATENCY_SINGLE)
+DESCRIBE(mips_movz,   R_RD_RS_RT,    OP_RD | OP_RS | OP_RT, 0,                    0, false, INSTRUCTION_MERGES_DESTINATION,         LATENCY_SINGLE)
+DESCRIBE(mips_sll,    R_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_sra,    R_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_srl,    R_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+/* Multiply and divide unit */
+DESCRIBE(mips_div,    R_RS_RT,       OP_RS | OP_RT,         ACC_W,                0, false, 0,                                      LATENCY_DIVIDE)
+DESCRIBE(mips_divu,   R_RS_RT,       OP_RS | OP_RT,         ACC_W,                0, false, 0,                                      LATENCY_DIVIDE)
+DESCRIBE(mips_mult,   R_RS_RT,       OP_RS | OP_RT,         ACC_W,                0, false, 0,                                      LATENCY_MULTIPLY)
+DESCRIBE(mips_multu,  R_RS_RT,       OP_RS | OP_RT,         ACC_W,                0, false, 0,                                      LATENCY_MULTIPLY)
+DESCRIBE(mips_madd,   R_RS_RT,       OP_RS | OP_RT,         ACC_R | ACC_W,        0, false, 0,                                      LATENCY_MULTIPLY)
+DESCRIBE(mips_maddu,  R_RS_RT,       OP_RS | OP_RT,         ACC_R | ACC_W,        0, false, 0,                                      LATENCY_MULTIPLY)
+DESCRIBE(mips_msub,   R_RS_RT,       OP_RS | OP_RT,         ACC_R | ACC_W,        0, false, 0,                                      LATENCY_MULTIPLY)
+DESCRIBE(mips_msubu,  R_RS_RT,       OP_RS | OP_RT,         ACC_R | ACC_W,        0, false, 0,                                      LATENCY_MULTIPLY)
+DESCRIBE(mips_mfhi,   R_RD,          OP_RD,                 ACCUMULATOR_READ_HI,  0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_mflo,   R_RD,          OP_RD,                 ACCUMULATOR_READ_LO,  0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_mthi,   R_RS,          OP_RS,                 ACCUMULATOR_WRITE_HI, 0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_mtlo,   R_RS,          OP_RS,                 ACCUMULATOR_WRITE_LO, 0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_nop,    R_NOP,         0,                     0,                    0, false, 0,                                      LATENCY_SINGLE)
+/* Immediate */
+DESCRIBE(mips_addi,   I_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_addiu,  I_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_andi,   I_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_ori,    I_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_xori,   I_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_slti,   I_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_sltiu,  I_RD_RS_C,     OP_RD | OP_RS | OP_C,  0,                    0, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_lui,    I_RD_C,        OP_RD | OP_C,          0,                    0, false, 0,                                      LATENCY_SINGLE)
+/* Loads */
+DESCRIBE(mips_lb,     I_RD_MEM_RS_C, OP_RD | OP_MEM,        0,                    1, true,  0,                                      LATENCY_LOAD)
+DESCRIBE(mips_lbu,    I_RD_MEM_RS_C, OP_RD | OP_MEM,        0,                    1, false, 0,                                      LATENCY_LOAD)
+DESCRIBE(mips_lh,     I_RD_MEM_RS_C, OP_RD | OP_MEM,        0,                    2, true,  0,                                      LATENCY_LOAD)
+DESCRIBE(mips_lhu,    I_RD_MEM_RS_C, OP_RD | OP_MEM,        0,                    2, false, 0,                                      LATENCY_LOAD)
+DESCRIBE(mips_lw,     I_RD_MEM_RS_C, OP_RD | OP_MEM,        0,                    4, true,  0,                                      LATENCY_LOAD)
+DESCRIBE(mips_lwl,    I_RD_MEM_RS_C, OP_RD | OP_MEM,        0,                    4, false, INSTRUCTION_MERGES_DESTINATION,         LATENCY_LOAD)
+DESCRIBE(mips_lwr,    I_RD_MEM_RS_C, OP_RD | OP_MEM,        0,                    4, false, INSTRUCTION_MERGES_DESTINATION,         LATENCY_LOAD)
+/* Stores */
+DESCRIBE(mips_sb,     I_RS_MEM_RT_C, OP_RS | OP_MEM,        0,                    1, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_sh,     I_RS_MEM_RT_C, OP_RS | OP_MEM,        0,                    2, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_sw,     I_RS_MEM_RT_C, OP_RS | OP_MEM,        0,                    4, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_swl,    I_RS_MEM_RT_C, OP_RS | OP_MEM,        0,                    4, false, 0,                                      LATENCY_SINGLE)
+DESCRIBE(mips_swr,    I_RS_MEM_RT_C, OP_RS | OP_MEM,        0,                    4, false, 0,                                      LATENCY_SINGLE)
+/* Branches, the target is a constant */
+DESCRIBE(mips_beq,    I_RS_RT_C,     OP_RS | OP_RT | OP_C,  0,                    0, false, BR,                                     LATENCY_SINGLE)
+DESCRIBE(mips_bne,    I_RS_RT_C,     OP_RS | OP_RT | OP_C,  0,                    0, false, BR,                                     LATENCY_SINGLE)
+DESCRIBE(mips_bgez,   I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR,                                     LATENCY_SINGLE)
+DESCRIBE(mips_bgezal, I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR | INSTRUCTION_CALL,                  LATENCY_SINGLE)
+DESCRIBE(mips_bgtz,   I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR,                                     LATENCY_SINGLE)
+DESCRIBE(mips_blez,   I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR,                                     LATENCY_SINGLE)
+DESCRIBE(mips_bltz,   I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR,                                     LATENCY_SINGLE)
+DESCRIBE(mips_bltzal, I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR | INSTRUCTION_CALL,                  LATENCY_SINGLE)
+/* Branch likely, the delay slot is annulled when the branch is not taken */
+DESCRIBE(mips_beql,   I_RS_RT_C,     OP_RS | OP_RT | OP_C,  0,                    0, false, BR | INSTRUCTION_LIKELY,                LATENCY_SINGLE)
+DESCRIBE(mips_bnel,   I_RS_RT_C,     OP_RS | OP_RT | OP_C,  0,                    0, false, BR | INSTRUCTION_LIKELY,                LATENCY_SINGLE)
+DESCRIBE(mips_bgezl,  I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR | INSTRUCTION_LIKELY,                LATENCY_SINGLE)
+DESCRIBE(mips_bgtzl,  I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR | INSTRUCTION_LIKELY,                LATENCY_SINGLE)
+DESCRIBE(mips_blezl,  I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR | INSTRUCTION_LIKELY,                LATENCY_SINGLE)
+DESCRIBE(mips_bltzl,  I_RS_C,        OP_RS | OP_C,          0,                    0, false, BR | INSTRUCTION_LIKELY,                LATENCY_SINGLE)
+DESCRIBE(mips_bgezall, I_RS_C,       OP_RS | OP_C,          0,                    0, false, BR | INSTRUCTION_CALL | INSTRUCTION_LIKELY, LATENCY_SINGLE)
+DESCRIBE(mips_bltzall, I_RS_C,       OP_RS | OP_C,          0,                    0, false, BR | INSTRUCTION_CALL | INSTRUCTION_LIKELY, LATENCY_SINGLE)
+/* Jumps */
+DESCRIBE(mips_j,      J_C,           OP_C,                  0,                    0, false, BR,                                     LATENCY_SINGLE)
+DESCRIBE(mips_jal,    J_C,           OP_C,                  0,                    0, false, BR | INSTRUCTION_CALL,                  LATENCY_SINGLE)
+DESCRIBE(mips_jr,     J_RS,          OP_RS,                 0,                    0, false, INSTRUCTION_DELAY_SLOT,                 LATENCY_SINGLE)
+DESCRIBE(mips_jalr,   J_RD_RS,       OP_RD | OP_RS,         0,                    0, false, INSTRUCTION_DELAY_SLOT | INSTRUCTION_CALL, LATENCY_SINGLE)
+
+#undef DESCRIBE
+#undef ACC_R
+#undef ACC_W
+#undef BR
+#undef OP_RD
+#undef OP_RS
+#undef OP_RT
+#undef OP_C
+#undef OP_MEM
+
+/* Number of entries in the dense table, every kind has to fit */
+#define DESCRIPTOR_TABLE_SIZE 512
+typedef char descriptorTableHoldsAllKinds[(mips_last_instruction < DESCRIPTOR_TABLE_SIZE) ? 1 : -1];
+
+/* Entry of the dense table and the doubling macros that list the indexes */
+#define DESCRIPTOR(INDEX) { \
+    static_cast<instructionType>(kindDescriptor<(INDEX)>::format), kindDescriptor<(INDEX)>::operands, \
+    kindDescriptor<(INDEX)>::accumulator, kindDescriptor<(INDEX)>::memoryBytes, \
+    kindDescriptor<(INDEX)>::memorySigned != 0, kindDescriptor<(INDEX)>::flags, \
+    static_cast<latencyClass>(kindDescriptor<(INDEX)>::latency) }
+#define DESCRIPTORS_2(INDEX)   DESCRIPTOR(INDEX), DESCRIPTOR(INDEX + 1)
+#define DESCRIPTORS_4(INDEX)   DESCRIPTORS_2(INDEX), DESCRIPTORS_2(INDEX + 2)
+#define DESCRIPTORS_8(INDEX)   DESCRIPTORS_4(INDEX), DESCRIPTORS_4(INDEX + 4)
+#define DESCRIPTORS_16(INDEX)  DESCRIPTORS_8(INDEX), DESCRIPTORS_8(INDEX + 8)
+#define DESCRIPTORS_32(INDEX)  DESCRIPTORS_16(INDEX), DESCRIPTORS_16(INDEX + 16)
+#define DESCRIPTORS_64(INDEX)  DESCRIPTORS_32(INDEX), DESCRIPTORS_32(INDEX + 32)
+#define DESCRIPTORS_128(INDEX) DESCRIPTORS_64(INDEX), DESCRIPTORS_64(INDEX + 64)
+#define DESCRIPTORS_256(INDEX) DESCRIPTORS_128(INDEX), DESCRIPTORS_128(INDEX + 128)
+
+/* The dense table, indexed by kind */
+static const instructionDescriptor descriptorTable[DESCRIPTOR_TABLE_SIZE] = {
+    DESCRIPTORS_256(0), DESCRIPTORS_256(256)
+};
+
+#undef DESCRIPTOR
+#undef DESCRIPTORS_2
+#undef DESCRIPTORS_4
+#undef DESCRIPTORS_8
+#undef DESCRIPTORS_16
+#undef DESCRIPTORS_32
+#undef DESCRIPTORS_64
+#undef DESCRIPTORS_128
+#undef DESCRIPTORS_256
+
+/* Returns the descriptor of an instruction kind */
+const instructionDescriptor& getInstructionDescriptor(MipsInstructionKind mipsKind) {
+    if ((unsigned)mipsKind >= DESCRIPTOR_TABLE_SIZE) {
+        return descriptorTable[mips_unknown_instruction];
+    }
+    return descriptorTable[mipsKind];
+}
+
+/* Return the format of an instruction defined by the framework */
 instructionType getInstructionFormat(MipsInstructionKind mipsKind) {
-    //check the check the kind of instruction.
+    return getInstructionDescriptor(mipsKind).format;
+}
+
+/* Checks if an instruction is a branch or jump, followed by a delay slot */
+bool hasDelaySlot(MipsInstructionKind mipsKind) {
+    return (getInstructionDescriptor(mipsKind).flags & INSTRUCTION_DELAY_SLOT) != 0;
+}
+
+
+/******************************************************************************
+* Mnemonic of an instruction kind. Decoding uses this instead of copying the
+* mnemonic string of the instruction.
+******************************************************************************/
+const char* instructionMnemonic(MipsInstructionKind mipsKind) {
     switch (mipsKind) {
-        /********** R type instruction **********/
-        //arithmetic.
-        case mips_add   :
-        case mips_addu  :
-        case mips_sub   :
-        case mips_subu  :
-
-        //logical
-        case mips_and   :
-        case mips_nor   :   
-        case mips_or    :   
-        case mips_xor   :   
-
-        //shift operations
-        case mips_sllv  :
-        case mips_srav  :
-        case mips_srlv  :
-
-        //condition, testing
-        case mips_slt   :
-        case mips_sltu  :
-
-        //multiply and div
-        case mips_mul   : return R_RD_RS_RT;
-
-        //shift operations 
-        case mips_sll   :   
-        case mips_sra   :   
-        case mips_srl   : return R_RD_RS_C;
-
-        //multiply and div.
-        case mips_div   :
-        case mips_divu  :
-        case mips_madd  :
-        case mips_maddu :
-        case mips_msub  :
-        case mips_msubu :
-        case mips_mult  :
-        case mips_multu : return R_RS_RT;
-
-        //accumulator ops.
-        case mips_mflo  : 
-        case mips_mfhi  : return R_RD;
-        case mips_mthi  :
-        case mips_mtlo  : return R_RS;
-
-        //nop instruction
-        case mips_nop   : return R_NOP;
-
-        /********** I type instruction **********/
-        //arithmetic
-        case mips_addi  :
-        case mips_addiu :
-
-        //logical ops.
-        case mips_andi  :
-        case mips_ori   :   
-        case mips_xori  :
-
-        //condition, testing
-        case mips_slti  :
-        case mips_sltiu : return I_RD_RS_C;
-
-        //load operations.
-        case mips_lb    :
-        case mips_lbu   :
-        case mips_lh    :
-        case mips_lhu   :
-        case mips_lw    :
-        case mips_lwl   :
-        case mips_lwr   : return I_RD_MEM_RS_C;
-
-        //conditional branch 
-        case mips_beq   :
-        case mips_bne   : return I_RS_RT_C;
-
-        //store operations
-        case mips_sb    :
-        case mips_sh    :
-        case mips_sw    :
-        case mips_swl   :
-        case mips_swr   : return I_RS_MEM_RT_C;
-
-        //conditional branches
-        case mips_bgez  :
-        case mips_bgezal:
-        case mips_bgtz  :
-        case mips_blez  :
-        case mips_bltz  : return I_RS_C;
-
-        //load upper immediate.
-        case mips_lui   : return I_RD_C;
-
-        /********** J type instruction **********/
-        case mips_j     :
-        case mips_jal   : return J_C;
-        case mips_jr    : return J_RS;
-        case mips_jalr  : return J_RD_RS;
+        case mips_add   : return "add";
+        case mips_addi  : return "addi";
+        case mips_addiu : return "addiu";
+        case mips_addu  : return "addu";
+        case mips_and   : return "and";
+        case mips_andi  : return "andi";
+        case mips_beq   : return "beq";
+        case mips_beql  : return "beql";
+        case mips_bgez  : return "bgez";
+        case mips_bgezal: return "bgezal";
+        case mips_bgezall: return "bgezall";
+        case mips_bgezl : return "bgezl";
+        case mips_bgtz  : return "bgtz";
+        case mips_bgtzl : return "bgtzl";
+        case mips_blez  : return "blez";
+        case mips_blezl : return "blezl";
+        case mips_bltz  : return "bltz";
+        case mips_bltzal: return "bltzal";
+        case mips_bltzall: return "bltzall";
+        case mips_bltzl : return "bltzl";
+        case mips_bne   : return "bne";
+        case mips_bnel  : return "bnel";
+        case mips_break : return "break";
+        case mips_clo   : return "clo";
+        case mips_clz   : return "clz";
+        case mips_div   : return "div";
+        case mips_divu  : return "divu";
+        case mips_j     : return "j";
+        case mips_jal   : return "jal";
+        case mips_jalr  : return "jalr";
+        case mips_jr    : return "jr";
+        case mips_lb    : return "lb";
+        case mips_lbu   : return "lbu";
+        case mips_lh    : return "lh";
+        case mips_lhu   : return "lhu";
+        case mips_lui   : return "lui";
+        case mips_lw    : return "lw";
+        case mips_lwl   : return "lwl";
+        case mips_lwr   : return "lwr";
+        case mips_madd  : return "madd";
+        case mips_maddu : return "maddu";
+        case mips_mfhi  : return "mfhi";
+        case mips_mflo  : return "mflo";
+        case mips_movn  : return "movn";
+        case mips_movz  : return "movz";
+        case mips_msub  : return "msub";
+        case mips_msubu : return "msubu";
+        case mips_mthi  : return "mthi";
+        case mips_mtlo  : return "mtlo";
+        case mips_mul   : return "mul";
+        case mips_mult  : return "mult";
+        case mips_multu : return "multu";
+        case mips_nop   : return "nop";
+        case mips_nor   : return "nor";
+        case mips_or    : return "or";
+        case mips_ori   : return "ori";
+        case mips_sb    : return "sb";
+        case mips_sh    : return "sh";
+        case mips_sll   : return "sll";
+        case mips_sllv  : return "sllv";
+        case mips_slt   : return "slt";
+        case mips_slti  : return "slti";
+        case mips_sltiu : return "sltiu";
+        case mips_sltu  : return "sltu";
+        case mips_sra   : return "sra";
+        case mips_srav  : return "srav";
+        case mips_srl   : return "srl";
+        case mips_srlv  : return "srlv";
+        case mips_sub   : return "sub";
+        case mips_subu  : return "subu";
+        case mips_sw    : return "sw";
+        case mips_swl   : return "swl";
+        case mips_swr   : return "swr";
+        case mips_syscall: return "syscall";
+        case mips_xor   : return "xor";
+        case mips_xori  : return "xori";
+
+        default: {
+        //Kind without a known mnemonic.
+        return "unknown";
+        }
+    }
+}
+
+
+/******************************************************************************
+* Encoding of instructions into machine words.
+******************************************************************************/
+/*  Opcode and function field of an instruction. SPECIAL instructions have
+    opcode 0 and REGIMM branches keep their condition in the rt field. */
+static bool instructionEncoding(MipsInstructionKind mipsKind, uint32_t* opcode, uint32_t* funct) {
+    *funct = 0;
+    switch (mipsKind) {
+        /* SPECIAL */
+        case mips_sll   : *opcode = 0x00; *funct = 0x00; return true;
+        case mips_srl   : *opcode = 0x00; *funct = 0x02; return true;
+        case mips_sra   : *opcode = 0x00; *funct = 0x03; return true;
+        case mips_sllv  : *opcode = 0x00; *funct = 0x04; return true;
+        case mips_srlv  : *opcode = 0x00; *funct = 0x06; return true;
+        case mips_srav  : *opcode = 0x00; *funct = 0x07; return true;
+        case mips_jr    : *opcode = 0x00; *funct = 0x08; return true;
+        case mips_jalr  : *opcode = 0x00; *funct = 0x09; return true;
+        case mips_movz  : *opcode = 0x00; *funct = 0x0a; return true;
+        case mips_movn  : *opcode = 0x00; *funct = 0x0b; return true;
+        case mips_mfhi  : *opcode = 0x00; *funct = 0x10; return true;
+        case mips_mthi  : *opcode = 0x00; *funct = 0x11; return true;
+        case mips_mflo  : *opcode = 0x00; *funct = 0x12; return true;
+        case mips_mtlo  : *opcode = 0x00; *funct = 0x13; return true;
+        case mips_mult  : *opcode = 0x00; *funct = 0x18; return true;
+        case mips_multu : *opcode = 0x00; *funct = 0x19; return true;
+        case mips_div   : *opcode = 0x00; *funct = 0x1a; return true;
+        case mips_divu  : *opcode = 0x00; *funct = 0x1b; return true;
+        case mips_add   : *opcode = 0x00; *funct = 0x20; return true;
+        case mips_addu  : *opcode = 0x00; *funct = 0x21; return true;
+        case mips_sub   : *opcode = 0x00; *funct = 0x22; return true;
+        case mips_subu  : *opcode = 0x00; *funct = 0x23; return true;
+        case mips_and   : *opcode = 0x00; *funct = 0x24; return true;
+        case mips_or    : *opcode = 0x00; *funct = 0x25; return true;
+        case mips_xor   : *opcode = 0x00; *funct = 0x26; return true;
+        case mips_nor   : *opcode = 0x00; *funct = 0x27; return true;
+        case mips_slt   : *opcode = 0x00; *funct = 0x2a; return true;
+        case mips_sltu  : *opcode = 0x00; *funct = 0x2b; return true;
+        /* SPECIAL2 */
+        case mips_madd  : *opcode = 0x1c; *funct = 0x00; return true;
+        case mips_maddu : *opcode = 0x1c; *funct = 0x01; return true;
+        case mips_mul   : *opcode = 0x1c; *funct = 0x02; return true;
+        case mips_msub  : *opcode = 0x1c; *funct = 0x04; return true;
+        case mips_msubu : *opcode = 0x1c; *funct = 0x05; return true;
+        /* REGIMM, the funct value is placed in rt */
+        case mips_bltz  : *opcode = 0x01; *funct = 0x00; return true;
+        case mips_bgez  : *opcode = 0x01; *funct = 0x01; return true;
+        case mips_bltzl : *opcode = 0x01; *funct = 0x02; return true;
+        case mips_bgezl : *opcode = 0x01; *funct = 0x03; return true;
+        case mips_bltzal: *opcode = 0x01; *funct = 0x10; return true;
+        case mips_bgezal: *opcode = 0x01; *funct = 0x11; return true;
+        case mips_bltzall: *opcode = 0x01; *funct = 0x12; return true;
+        case mips_bgezall: *opcode = 0x01; *funct = 0x13; return true;
+        /* Jumps */
+        case mips_j     : *opcode = 0x02; return true;
+        case mips_jal   : *opcode = 0x03; return true;
+        /* Branches */
+        case mips_beq   : *opcode = 0x04; return true;
+        case mips_bne   : *opcode = 0x05; return true;
+        case mips_blez  : *opcode = 0x06; return true;
+        case mips_bgtz  : *opcode = 0x07; return true;
+        case mips_beql  : *opcode = 0x14; return true;
+        case mips_bnel  : *opcode = 0x15; return true;
+        case mips_blezl : *opcode = 0x16; return true;
+        case mips_bgtzl : *opcode = 0x17; return true;
+        /* Immediate arithmetic */
+        case mips_addi  : *opcode = 0x08; return true;
+        case mips_addiu : *opcode = 0x09; return true;
+        case mips_slti  : *opcode = 0x0a; return true;
+        case mips_sltiu : *opcode = 0x0b; return true;
+        case mips_andi  : *opcode = 0x0c; return true;
+        case mips_ori   : *opcode = 0x0d; return true;
+        case mips_xori  : *opcode = 0x0e; return true;
+        case mips_lui   : *opcode = 0x0f; return true;
+        /* Loads and stores */
+        case mips_lb    : *opcode = 0x20; return true;
+        case mips_lh    : *opcode = 0x21; return true;
+        case mips_lwl   : *opcode = 0x22; return true;
+        case mips_lw    : *opcode = 0x23; return true;
+        case mips_lbu   : *opcode = 0x24; return true;
+        case mips_lhu   : *opcode = 0x25; return true;
+        case mips_lwr   : *opcode = 0x26; return true;
+        case mips_sb    : *opcode = 0x28; return true;
+        case mips_sh    : *opcode = 0x29; return true;
+        case mips_swl   : *opcode = 0x2a; return true;
+        case mips_sw    : *opcode = 0x2b; return true;
+        case mips_swr   : *opcode = 0x2e; return true;
+
+        default: {
+        //Not an instruction the framework can encode.
+        return false;
+        }
+    }
+}
 
+/* Hardware number of a register, symbolic registers must be allocated */
+static uint32_t registerNumber(registerStruct& reg) {
+    if (reg.regName == symbolic_reg) {
+        ASSERT_not_reachable("Encoding: Symbolic register left in instruction.");
+    }
+    return registerNameMap.right.find(reg.regName)->second;
+}
+
+/*  Encodes an instruction into its machine word. Branch offsets are
+    computed from the address of the instruction, so it has to be set.
+    Returns false for instructions the framework does not know and for
+    branches whose target is out of range. */
+bool encodeInstruction(SgAsmMipsInstruction* inst, uint32_t* word) {
+    uint32_t opcode, funct;
+    instructionType format = getInstructionFormat(inst->get_kind());
+    if (format == MIPS_UNKNOWN || instructionEncoding(inst->get_kind(), &opcode, &funct) == false) {
+        return false;
+    }
+    instructionStruct decoded = decodeInstruction(inst);
+    uint32_t rs = 0, rt = 0, rd = 0, sa = 0, immediate = 0;
+    /* The registers are in operand order in the decoded struct */
+    switch (format) {
+        case R_RD_RS_RT: {
+            rd = registerNumber(decoded.destinationRegisters[0]);
+            /* Variable shifts are written rd, rt, rs */
+            if (decoded.kind == mips_sllv || decoded.kind == mips_srlv || decoded.kind == mips_srav) {
+                rt = registerNumber(decoded.sourceRegisters[0]);
+                rs = registerNumber(decoded.sourceRegisters[1]);
+            } else {
+                rs = registerNumber(decoded.sourceRegisters[0]);
+                rt = registerNumber(decoded.sourceRegisters[1]);
+            }
+            break;
+        }
+        case R_RD_RS_C: {
+            /* Shifts by constant, rd, rt, sa */
+            rd = registerNumber(decoded.destinationRegisters[0]);
+            rt = registerNumber(decoded.sourceRegisters[0]);
+            sa = decoded.instructionConstant & 0x1f;
+            break;
+        }
+        case R_RD: {
+            rd = registerNumber(decoded.destinationRegisters[0]);
+            break;
+        }
+        case R_RS_RT: {
+            rs = registerNumber(decoded.sourceRegisters[0]);
+            rt = registerNumber(decoded.sourceRegisters[1]);
+            break;
+        }
+        case R_RS:
+        case J_RS: {
+            rs = registerNumber(decoded.sourceRegisters[0]);
+            break;
+        }
+        case J_RD_RS: {
+            rd = registerNumber(decoded.destinationRegisters[0]);
+            rs = registerNumber(decoded.sourceRegisters[0]);
+            break;
+        }
+        case R_NOP: {
+            /* sll zero, zero, 0 */
+            *word = 0;
+            return true;
+        }
+        case I_RD_RS_C:
+        case I_RD_MEM_RS_C: {
+            /* The memory base is decoded as the source register */
+            rt = registerNumber(decoded.destinationRegisters[0]);
+            rs = registerNumber(decoded.sourceRegisters[0]);
+            immediate = decoded.instructionConstant & 0xffff;
+            break;
+        }
+        case I_RD_C: {
+            rt = registerNumber(decoded.destinationRegisters[0]);
+            immediate = decoded.instructionConstant & 0xffff;
+            break;
+        }
+        case I_RS_MEM_RT_C: {
+            /* Stored register first, then the memory base */
+            rt = registerNumber(decoded.sourceRegisters[0]);
+            rs = registerNumber(decoded.sourceRegisters[1]);
+            immediate = decoded.instructionConstant & 0xffff;
+            break;
+        }
+        case I_RS_RT_C:
+        case I_RS_C: {
+            rs = registerNumber(decoded.sourceRegisters[0]);
+            if (format == I_RS_RT_C) {
+                rt = registerNumber(decoded.sourceRegisters[1]);
+            } else if (opcode == 0x01) {
+                rt = funct;
+            }
+            /* The constant is the target, encode the word offset from the delay slot */
+            int64_t offset = ((int64_t)decoded.instructionConstant - (int64_t)(inst->get_address() + 4)) / 4;
+            if (offset < -32768 || offset > 32767) {
+                return false;
+            }
+            immediate = offset & 0xffff;
+            break;
+        }
+        case J_C: {
+            /* Jumps keep the upper bits of the delay slot address */
+            *word = (opcode << 26) | ((decoded.instructionConstant >> 2) & 0x3ffffff);
+            return true;
+        }
         default: {
-        //Not a identifiable instruction.
-        return MIPS_UNKNOWN;
+            return false;
         }
     }
+    if (opcode == 0x00 || opcode == 0x1c) {
+        *word = (opcode << 26) | (rs << 21) | (rt << 16) | (rd << 11) | (sa << 6) | funct;
+    } else {
+        *word = (opcode << 26) | (rs << 21) | (rt << 16) | immediate;
+    }
+    return true;
 }
 
 
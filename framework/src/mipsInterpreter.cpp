@@ -0,0 +1,740 @@
+/* MIPS32 interpreter implementation */
+
+/* header file */
+#include "mipsInterpreter.hpp"
+/* ELF definitions and file reading */
+#include <elf.h>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+/*  STEPS of a run
+        1. Copy the loaded segments into a fresh memory and set up the
+        registers, a call returns to an address without code.
+        2. Index the block starts and the original instructions by address.
+        Inserted instructions have no address, they are reached by
+        following the statement lists.
+        3. Execute the statement at the position, a branch or jump first
+        executes its delay slot and then enters the block of the target.
+        Likely branches that are not taken skip the delay slot.
+        4. Count the cycles like the static estimate, an instruction issues
+        when the registers it reads are ready. The stall is a load-use stall
+        or a hi/lo stall depending on the register that was waited for. */
+
+/* Memory layout of a run */
+static const uint32_t pageSize = 4096;
+static const uint32_t stackTop = 0x7fff0000;
+/* Lowest address of the stack */
+static const uint32_t stackLimit = stackTop - 0x1000000;
+/* Return address of a called function, there is no code at it */
+static const uint32_t returnSentinel = 0xfffffff0;
+/* Linux o32 system calls */
+static const uint32_t syscallExit = 4001;
+static const uint32_t syscallWrite = 4004;
+static const uint32_t syscallExitGroup = 4246;
+static const uint32_t errorNoSystemCall = 89;
+/* Default instruction limit */
+static const uint64_t defaultInstructionLimit = 100000000ULL;
+/* Register index of hi and lo in the register masks */
+static const int hiIndex = 32;
+static const int loIndex = 33;
+
+
+/* Constructor */
+mipsInterpreter::mipsInterpreter(CFG* cfg) {
+    programCFG = cfg;
+    bigEndian = false;
+    entryPoint = 0;
+    globalPointer = 0;
+    entryStack = 0;
+    hi = 0;
+    lo = 0;
+    instructionLimit = defaultInstructionLimit;
+    for(int reg = 0; reg < 32; ++reg) {
+        registers[reg] = 0;
+    }
+}
+
+/* Highest number of instructions a run executes */
+void mipsInterpreter::setInstructionLimit(uint64_t limit) {
+    instructionLimit = limit;
+}
+
+/* Bytes the program wrote */
+std::string mipsInterpreter::getOutput() {
+    return output;
+}
+
+/* Reads ELF fields in the byte order of the file */
+static uint32_t elfWord(const std::vector<unsigned char>& data, size_t offset, int size, bool bigEndian) {
+    uint32_t value = 0;
+    for(int byte = 0; byte < size; ++byte) {
+        unsigned char current = data[offset + (bigEndian ? byte : size - 1 - byte)];
+        value = (value << 8) | current;
+    }
+    return value;
+}
+
+/* Loads the segments and symbols of a static ELF */
+bool mipsInterpreter::loadELF(std::string file) {
+    std::ifstream input(file.c_str(), std::ios::in | std::ios::binary);
+    if (!input) {
+        return false;
+    }
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(Elf32_Ehdr) || memcmp(&data[0], ELFMAG, SELFMAG) != 0 ||
+        data[EI_CLASS] != ELFCLASS32) {
+        return false;
+    }
+    bigEndian = (data[EI_DATA] == ELFDATA2MSB);
+    entryPoint = elfWord(data, offsetof(Elf32_Ehdr, e_entry), 4, bigEndian);
+    uint32_t programOffset = elfWord(data, offsetof(Elf32_Ehdr, e_phoff), 4, bigEndian);
+    uint32_t programSize = elfWord(data, offsetof(Elf32_Ehdr, e_phentsize), 2, bigEndian);
+    uint32_t programCount = elfWord(data, offsetof(Elf32_Ehdr, e_phnum), 2, bigEndian);
+    uint32_t sectionOffset = elfWord(data, offsetof(Elf32_Ehdr, e_shoff), 4, bigEndian);
+    uint32_t sectionSize = elfWord(data, offsetof(Elf32_Ehdr, e_shentsize), 2, bigEndian);
+    uint32_t sectionCount = elfWord(data, offsetof(Elf32_Ehdr, e_shnum), 2, bigEndian);
+
+    /* Loadable segments, the part after the file size is zero */
+    image.clear();
+    for(uint32_t index = 0; index < programCount; ++index) {
+        size_t header = programOffset + (size_t)index * programSize;
+        if (header + sizeof(Elf32_Phdr) > data.size()) {
+            return false;
+        }
+        if (elfWord(data, header + offsetof(Elf32_Phdr, p_type), 4, bigEndian) != PT_LOAD) {
+            continue;
+        }
+        uint32_t offset = elfWord(data, header + offsetof(Elf32_Phdr, p_offset), 4, bigEndian);
+        uint32_t address = elfWord(data, header + offsetof(Elf32_Phdr, p_vaddr), 4, bigEndian);
+        uint32_t fileSize = elfWord(data, header + offsetof(Elf32_Phdr, p_filesz), 4, bigEndian);
+        uint32_t memorySize = elfWord(data, header + offsetof(Elf32_Phdr, p_memsz), 4, bigEndian);
+        if ((size_t)offset + fileSize > data.size()) {
+            return false;
+        }
+        for(uint32_t byte = 0; byte < memorySize; ++byte) {
+            memoryPage& page = image[(address + byte) / pageSize];
+            if (page.empty()) {
+                page.assign(pageSize, 0);
+            }
+            page[(address + byte) % pageSize] = byte < fileSize ? data[offset + byte] : 0;
+        }
+    }
+
+    /* The global pointer of a called function is the _gp symbol */
+    globalPointer = 0;
+    for(uint32_t index = 0; index < sectionCount; ++index) {
+        size_t header = sectionOffset + (size_t)index * sectionSize;
+        if (header + sizeof(Elf32_Shdr) > data.size() ||
+            elfWord(data, header + offsetof(Elf32_Shdr, sh_type), 4, bigEndian) != SHT_SYMTAB) {
+            continue;
+        }
+        uint32_t symbolOffset = elfWord(data, header + offsetof(Elf32_Shdr, sh_offset), 4, bigEndian);
+        uint32_t symbolBytes = elfWord(data, header + offsetof(Elf32_Shdr, sh_size), 4, bigEndian);
+        uint32_t link = elfWord(data, header + offsetof(Elf32_Shdr, sh_link), 4, bigEndian);
+        size_t stringHeader = sectionOffset + (size_t)link * sectionSize;
+        if (link >= sectionCount || stringHeader + sizeof(Elf32_Shdr) > data.size()) {
+            continue;
+        }
+        uint32_t stringOffset = elfWord(data, stringHeader + offsetof(Elf32_Shdr, sh_offset), 4, bigEndian);
+        uint32_t stringBytes = elfWord(data, stringHeader + offsetof(Elf32_Shdr, sh_size), 4, bigEndian);
+        for(uint32_t symbol = 0; symbol + sizeof(Elf32_Sym) <= symbolBytes; symbol += sizeof(Elf32_Sym)) {
+            size_t entry = symbolOffset + symbol;
+            if (entry + sizeof(Elf32_Sym) > data.size()) {
+                break;
+            }
+            uint32_t name = elfWord(data, entry + offsetof(Elf32_Sym, st_name), 4, bigEndian);
+            if (name < stringBytes && (size_t)stringOffset + name + 4 <= data.size() &&
+                memcmp(&data[stringOffset + name], "_gp", 4) == 0) {
+                globalPointer = elfWord(data, entry + offsetof(Elf32_Sym, st_value), 4, bigEndian);
+            }
+        }
+    }
+    return image.empty() == false;
+}
+
+/* Indexes the statement lists as they are now */
+void mipsInterpreter::indexCode() {
+    blockStarts.clear();
+    instructions.clear();
+    fallThrough.clear();
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*programCFG);
+        vPair.first != vPair.second; ++vPair.first) {
+        SgAsmBlock* block = get(boost::vertex_name, *programCFG, *vPair.first);
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        codePosition start;
+        start.block = block;
+        start.index = 0;
+        blockStarts[block->get_address()] = start;
+        rose_addr_t lastAddress = 0;
+        for(size_t index = 0; index < stmtList.size(); ++index) {
+            rose_addr_t address = stmtList[index]->get_address();
+            if (address == 0) {
+                continue;
+            }
+            codePosition position;
+            position.block = block;
+            position.index = index;
+            instructions[address] = position;
+            lastAddress = std::max(lastAddress, address);
+        }
+        fallThrough[block] = lastAddress + 4;
+    }
+}
+
+/* Position of an address, the start of a block before an instruction in one */
+bool mipsInterpreter::findPosition(rose_addr_t address, codePosition* position) {
+    boost::unordered_map<rose_addr_t, codePosition>::iterator found = blockStarts.find(address);
+    if (found == blockStarts.end()) {
+        found = instructions.find(address);
+        if (found == instructions.end()) {
+            return false;
+        }
+    }
+    *position = found->second;
+    return true;
+}
+
+/* Position after the statement, the next block when the list ends */
+bool mipsInterpreter::nextPosition(codePosition current, codePosition* next) {
+    if (current.index + 1 < current.block->get_statementList().size()) {
+        next->block = current.block;
+        next->index = current.index + 1;
+        return true;
+    }
+    return findPosition(fallThrough[current.block], next);
+}
+
+/* Byte of the memory, pages are created on first use */
+unsigned char* mipsInterpreter::memoryByte(uint32_t address) {
+    memoryPage& page = memory[address / pageSize];
+    if (page.empty()) {
+        page.assign(pageSize, 0);
+    }
+    return &page[address % pageSize];
+}
+
+/* Loads a value of 1, 2 or 4 bytes */
+uint32_t mipsInterpreter::loadMemory(uint32_t address, int size) {
+    uint32_t value = 0;
+    for(int byte = 0; byte < size; ++byte) {
+        uint32_t current = *memoryByte(address + (bigEndian ? byte : size - 1 - byte));
+        value = (value << 8) | current;
+    }
+    return value;
+}
+
+/* Stores a value of 1, 2 or 4 bytes */
+void mipsInterpreter::storeMemory(uint32_t address, int size, uint32_t value) {
+    for(int byte = 0; byte < size; ++byte) {
+        *memoryByte(address + (bigEndian ? size - 1 - byte : byte)) = value & 0xff;
+        value >>= 8;
+    }
+}
+
+/* Reads a register */
+uint32_t mipsInterpreter::readRegister(const registerStruct& reg) {
+    return registers[reg.regName];
+}
+
+/* Writes a register, zero stays zero */
+void mipsInterpreter::writeRegister(const registerStruct& reg, uint32_t value) {
+    if (reg.regName != zero) {
+        registers[reg.regName] = value;
+    }
+}
+
+/* Fresh memory and registers for a run */
+void mipsInterpreter::resetState() {
+    memory = image;
+    output.clear();
+    for(int reg = 0; reg < 32; ++reg) {
+        registers[reg] = 0;
+    }
+    hi = 0;
+    lo = 0;
+}
+
+/*  Copies the strings to the top of the stack and builds the argv array
+    below them, followed by an empty environment and auxiliary vector.
+    The word before the array is 8 byte aligned for argc. Returns argv. */
+uint32_t mipsInterpreter::storeArguments(std::vector<std::string>& arguments) {
+    uint32_t stringAddress = stackTop;
+    std::vector<uint32_t> pointers;
+    for(size_t index = 0; index < arguments.size(); ++index) {
+        stringAddress -= arguments[index].size() + 1;
+        for(size_t byte = 0; byte <= arguments[index].size(); ++byte) {
+            *memoryByte(stringAddress + byte) = byte < arguments[index].size() ? arguments[index][byte] : 0;
+        }
+        pointers.push_back(stringAddress);
+    }
+    /* The NULL of argv, the NULL of the environment and AT_NULL with its value */
+    uint32_t array = ((stringAddress - 4 * (pointers.size() + 4) - 4) & ~7) + 4;
+    for(size_t index = 0; index < pointers.size(); ++index) {
+        storeMemory(array + 4 * index, 4, pointers[index]);
+    }
+    for(size_t index = pointers.size(); index < pointers.size() + 4; ++index) {
+        storeMemory(array + 4 * index, 4, 0);
+    }
+    return array;
+}
+
+/* Calls the function at the address */
+interpreterResult mipsInterpreter::runFunction(rose_addr_t function, std::vector<uint32_t> arguments) {
+    resetState();
+    /* Arguments in a0 to a3, the caller reserves their stack slots */
+    for(size_t index = 0; index < arguments.size() && index < 4; ++index) {
+        registers[a0 + index] = arguments[index];
+    }
+    registers[sp] = stackTop - 32;
+    return call(function);
+}
+
+/* Calls a main function with argc, argv and an empty environment */
+interpreterResult mipsInterpreter::runMain(rose_addr_t function, std::vector<std::string> arguments) {
+    resetState();
+    uint32_t array = storeArguments(arguments);
+    registers[a0] = arguments.size();
+    registers[a1] = array;
+    registers[a2] = array + 4 * (arguments.size() + 1);
+    /* Argument slots of the caller below the arrays */
+    registers[sp] = (array - 4) - 32;
+    return call(function);
+}
+
+/* Calls a function with the stack pointer and arguments set */
+interpreterResult mipsInterpreter::call(rose_addr_t function) {
+    registers[gp] = globalPointer;
+    registers[ra] = returnSentinel;
+    /* Position independent callees compute gp from t9 */
+    registers[t9] = function;
+    return run(function);
+}
+
+/* Runs the program from the entry point */
+interpreterResult mipsInterpreter::runProgram() {
+    resetState();
+    /* argc followed by argv with the program name */
+    std::vector<std::string> arguments(1, "program");
+    uint32_t array = storeArguments(arguments);
+    storeMemory(array - 4, 4, arguments.size());
+    registers[sp] = array - 4;
+    registers[ra] = returnSentinel;
+    return run(entryPoint);
+}
+
+/* Register after a run */
+uint32_t mipsInterpreter::getRegister(mipsRegisterName reg) {
+    return registers[reg];
+}
+
+/* Digest of the memory after a run, without the stack below the caller */
+uint64_t mipsInterpreter::memoryDigest() {
+    /* Pages in address order, created pages that stayed zero do not count */
+    std::vector<uint32_t> pages;
+    for(boost::unordered_map<uint32_t, memoryPage>::iterator iter = memory.begin();
+        iter != memory.end(); ++iter) {
+        pages.push_back(iter->first);
+    }
+    std::sort(pages.begin(), pages.end());
+    uint64_t digest = 0xcbf29ce484222325ULL;
+    for(std::vector<uint32_t>::iterator iter = pages.begin(); iter != pages.end(); ++iter) {
+        memoryPage& page = memory[*iter];
+        for(uint32_t byte = 0; byte < pageSize; ++byte) {
+            uint32_t address = *iter * pageSize + byte;
+            if (page[byte] == 0 || (address >= stackLimit && address < entryStack)) {
+                continue;
+            }
+            digest = (digest ^ address) * 0x100000001b3ULL;
+            digest = (digest ^ page[byte]) * 0x100000001b3ULL;
+        }
+    }
+    return digest;
+}
+
+/* Executes a system call */
+bool mipsInterpreter::systemCall(interpreterResult* result) {
+    uint32_t number = registers[v0];
+    if (number == syscallExit || number == syscallExitGroup) {
+        result->status = INTERPRETER_EXITED;
+        result->returnValue = registers[a0];
+        return true;
+    }
+    if (number == syscallWrite) {
+        uint32_t buffer = registers[a1];
+        uint32_t length = registers[a2];
+        for(uint32_t byte = 0; byte < length; ++byte) {
+            output.push_back(*memoryByte(buffer + byte));
+        }
+        registers[v0] = length;
+        registers[a3] = 0;
+        return false;
+    }
+    /* Everything else fails */
+    registers[v0] = errorNoSystemCall;
+    registers[a3] = 1;
+    return false;
+}
+
+/* Sign extends the low 16 bits of a constant */
+static uint32_t signedImmediate(uint64_t constant) {
+    return (uint32_t)(int32_t)(int16_t)(constant & 0xffff);
+}
+
+/* Runs from an address until the run stops */
+interpreterResult mipsInterpreter::run(rose_addr_t start) {
+    interpreterResult result;
+    entryStack = registers[sp];
+    indexCode();
+    codePosition position;
+    if (findPosition(start, &position) == false) {
+        result.stopAddress = start;
+        return result;
+    }
+    /* Cycle each register result is ready and whether a load wrote it */
+    std::vector<uint64_t> readyCycle(34, 0);
+    std::vector<bool> loadResult(34, false);
+    uint64_t cycle = 0;
+    /* Pending control transfer, taken after the delay slot */
+    bool inDelaySlot = false;
+    bool transferTaken = false;
+    rose_addr_t transferTarget = 0;
+
+    while (true) {
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(position.block->get_statementList()[position.index]);
+        rose_addr_t address = position.block->get_statementList()[position.index]->get_address();
+        result.stopAddress = address;
+        if (result.instructions >= instructionLimit) {
+            result.status = INTERPRETER_LIMIT;
+            break;
+        }
+        if (mips == NULL) {
+            result.status = INTERPRETER_UNKNOWN;
+            break;
+        }
+        /* System calls and breaks have no operands the framework decodes */
+        if (mips->get_kind() == mips_syscall || mips->get_kind() == mips_break) {
+            result.instructions++;
+            cycle++;
+            if (mips->get_kind() == mips_break) {
+                result.status = INTERPRETER_BREAK;
+                break;
+            }
+            if (systemCall(&result)) {
+                break;
+            }
+            codePosition next;
+            if (nextPosition(position, &next) == false) {
+                result.status = INTERPRETER_NO_CODE;
+                result.stopAddress = fallThrough[position.block];
+                break;
+            }
+            position = next;
+            continue;
+        }
+        if (getInstructionFormat(mips->get_kind()) == MIPS_UNKNOWN) {
+            result.status = INTERPRETER_UNKNOWN;
+            break;
+        }
+        instructionStruct decoded = decodeInstruction(mips);
+        registerList& dst = decoded.destinationRegisters;
+        registerList& src = decoded.sourceRegisters;
+        for(registerList::iterator iter = dst.begin(); iter != dst.end(); ++iter) {
+            if (iter->regName == symbolic_reg) {
+                result.status = INTERPRETER_UNKNOWN;
+                result.cycles = cycle;
+                return result;
+            }
+        }
+        for(registerList::iterator iter = src.begin(); iter != src.end(); ++iter) {
+            if (iter->regName == symbolic_reg) {
+                result.status = INTERPRETER_UNKNOWN;
+                result.cycles = cycle;
+                return result;
+            }
+        }
+
+        /* Timing, issue when the operands are ready */
+        registerMask def, use;
+        instructionDefUse(mips, &def, &use);
+        uint64_t issue = cycle;
+        int waitedFor = -1;
+        for(int reg = 0; reg < 34; ++reg) {
+            if ((use & ((registerMask)1 << reg)) != 0 && readyCycle[reg] > issue) {
+                issue = readyCycle[reg];
+                waitedFor = reg;
+            }
+        }
+        if (waitedFor == hiIndex || waitedFor == loIndex) {
+            result.hiLoStalls += issue - cycle;
+        } else if (waitedFor >= 0 && loadResult[waitedFor]) {
+            result.loadUseStalls += issue - cycle;
+        }
+        bool isLoad = getInstructionDescriptor(decoded.kind).memoryBytes != 0 && decoded.format == I_RD_MEM_RS_C;
+        int latency = instructionLatency(decoded.kind);
+        for(int reg = 0; reg < 34; ++reg) {
+            if ((def & ((registerMask)1 << reg)) != 0) {
+                readyCycle[reg] = issue + latency;
+                loadResult[reg] = isLoad;
+            }
+        }
+        cycle = issue + 1;
+        result.instructions++;
+
+        /* Execute */
+        bool branch = false;
+        bool taken = false;
+        rose_addr_t target = 0;
+        uint32_t immediate = signedImmediate(decoded.instructionConstant);
+        switch (decoded.kind) {
+            /* Arithmetic and logic on registers, overflow is not trapped */
+            case mips_add:
+            case mips_addu: writeRegister(dst[0], readRegister(src[0]) + readRegister(src[1])); break;
+            case mips_sub:
+            case mips_subu: writeRegister(dst[0], readRegister(src[0]) - readRegister(src[1])); break;
+            case mips_and: writeRegister(dst[0], readRegister(src[0]) & readRegister(src[1])); break;
+            case mips_or: writeRegister(dst[0], readRegister(src[0]) | readRegister(src[1])); break;
+            case mips_xor: writeRegister(dst[0], readRegister(src[0]) ^ readRegister(src[1])); break;
+            case mips_nor: writeRegister(dst[0], ~(readRegister(src[0]) | readRegister(src[1]))); break;
+            case mips_slt: writeRegister(dst[0], (int32_t)readRegister(src[0]) < (int32_t)readRegister(src[1])); break;
+            case mips_sltu: writeRegister(dst[0], readRegister(src[0]) < readRegister(src[1])); break;
+            case mips_mul: writeRegister(dst[0], (uint32_t)((int64_t)(int32_t)readRegister(src[0]) *
+                (int64_t)(int32_t)readRegister(src[1]))); break;
+            case mips_movn: if (readRegister(src[1]) != 0) writeRegister(dst[0], readRegister(src[0])); break;
+            case mips_movz: if (readRegister(src[1]) == 0) writeRegister(dst[0], readRegister(src[0])); break;
+            /* Variable shifts, the value first and then the amount */
+            case mips_sllv: writeRegister(dst[0], readRegister(src[0]) << (readRegister(src[1]) & 0x1f)); break;
+            case mips_srlv: writeRegister(dst[0], readRegister(src[0]) >> (readRegister(src[1]) & 0x1f)); break;
+            case mips_srav: writeRegister(dst[0], (uint32_t)((int32_t)readRegister(src[0]) >> (readRegister(src[1]) & 0x1f))); break;
+            /* Shifts by a constant */
+            case mips_sll: writeRegister(dst[0], readRegister(src[0]) << (decoded.instructionConstant & 0x1f)); break;
+            case mips_srl: writeRegister(dst[0], readRegister(src[0]) >> (decoded.instructionConstant & 0x1f)); break;
+            case mips_sra: writeRegister(dst[0], (uint32_t)((int32_t)readRegister(src[0]) >> (decoded.instructionConstant & 0x1f))); break;
+            case mips_nop: break;
+            /* Immediates, the logic ones are zero extended */
+            case mips_addi:
+            case mips_addiu: writeRegister(dst[0], readRegister(src[0]) + immediate); break;
+            case mips_slti: writeRegister(dst[0], (int32_t)readRegister(src[0]) < (int32_t)immediate); break;
+            case mips_sltiu: writeRegister(dst[0], readRegister(src[0]) < immediate); break;
+            case mips_andi: writeRegister(dst[0], readRegister(src[0]) & (decoded.instructionConstant & 0xffff)); break;
+            case mips_ori: writeRegister(dst[0], readRegister(src[0]) | (decoded.instructionConstant & 0xffff)); break;
+            case mips_xori: writeRegister(dst[0], readRegister(src[0]) ^ (decoded.instructionConstant & 0xffff)); break;
+            case mips_lui: writeRegister(dst[0], (decoded.instructionConstant & 0xffff) << 16); break;
+            /* Accumulator */
+            case mips_mfhi: writeRegister(dst[0], hi); break;
+            case mips_mflo: writeRegister(dst[0], lo); break;
+            case mips_mthi: hi = readRegister(src[0]); break;
+            case mips_mtlo: lo = readRegister(src[0]); break;
+            case mips_mult:
+            case mips_multu:
+            case mips_madd:
+            case mips_maddu:
+            case mips_msub:
+            case mips_msubu: {
+                bool isSigned = decoded.kind == mips_mult || decoded.kind == mips_madd || decoded.kind == mips_msub;
+                uint64_t product = isSigned ?
+                    (uint64_t)((int64_t)(int32_t)readRegister(src[0]) * (int64_t)(int32_t)readRegister(src[1])) :
+                    (uint64_t)readRegister(src[0]) * (uint64_t)readRegister(src[1]);
+                uint64_t accumulator = ((uint64_t)hi << 32) | lo;
+                if (decoded.kind == mips_madd || decoded.kind == mips_maddu) {
+                    product = accumulator + product;
+                } else if (decoded.kind == mips_msub || decoded.kind == mips_msubu) {
+                    product = accumulator - product;
+                }
+                hi = product >> 32;
+                lo = product & 0xffffffff;
+                break;
+            }
+            case mips_div:
+            case mips_divu: {
+                uint32_t dividend = readRegister(src[0]);
+                uint32_t divisor = readRegister(src[1]);
+                /* Division by zero leaves hi and lo unpredictable, keep them */
+                if (divisor == 0) {
+                    break;
+                }
+                if (decoded.kind == mips_divu) {
+                    lo = dividend / divisor;
+                    hi = dividend % divisor;
+                } else if (dividend == 0x80000000 && divisor == 0xffffffff) {
+                    lo = dividend;
+                    hi = 0;
+                } else {
+                    lo = (uint32_t)((int32_t)dividend / (int32_t)divisor);
+                    hi = (uint32_t)((int32_t)dividend % (int32_t)divisor);
+                }
+                break;
+            }
+            /* Loads, the memory base is the source register */
+            case mips_lb: writeRegister(dst[0], (uint32_t)(int32_t)(int8_t)loadMemory(readRegister(src[0]) + immediate, 1)); break;
+            case mips_lbu: writeRegister(dst[0], loadMemory(readRegister(src[0]) + immediate, 1)); break;
+            case mips_lh: writeRegister(dst[0], (uint32_t)(int32_t)(int16_t)loadMemory(readRegister(src[0]) + immediate, 2)); break;
+            case mips_lhu: writeRegister(dst[0], loadMemory(readRegister(src[0]) + immediate, 2)); break;
+            case mips_lw: writeRegister(dst[0], loadMemory(readRegister(src[0]) + immediate, 4)); break;
+            case mips_lwl:
+            case mips_lwr: {
+                /*  Unaligned halves. Bytes of the register are numbered from
+                    the least significant, memory bytes from the aligned word. */
+                uint32_t effective = readRegister(src[0]) + immediate;
+                uint32_t aligned = effective & ~3;
+                uint32_t offset = effective & 3;
+                uint32_t value = readRegister(dst[0]);
+                bool left = decoded.kind == mips_lwl;
+                for(uint32_t byte = 0; byte < 4; ++byte) {
+                    /* Significance of the memory byte in a big or little endian word */
+                    uint32_t significance = bigEndian ? 3 - byte : byte;
+                    uint32_t shifted;
+                    if (left) {
+                        /* Memory up to the address goes to the high bytes */
+                        if ((bigEndian && byte < offset) || (bigEndian == false && byte > offset)) {
+                            continue;
+                        }
+                        shifted = significance + (bigEndian ? offset : 3 - offset);
+                    } else {
+                        /* Memory from the address goes to the low bytes */
+                        if ((bigEndian && byte > offset) || (bigEndian == false && byte < offset)) {
+                            continue;
+                        }
+                        shifted = significance - (bigEndian ? 3 - offset : offset);
+                    }
+                    value &= ~(0xffu << (8 * shifted));
+                    value |= (uint32_t)*memoryByte(aligned + byte) << (8 * shifted);
+                }
+                writeRegister(dst[0], value);
+                break;
+            }
+            /* Stores, the stored register first and then the base */
+            case mips_sb: storeMemory(readRegister(src[1]) + immediate, 1, readRegister(src[0])); break;
+            case mips_sh: storeMemory(readRegister(src[1]) + immediate, 2, readRegister(src[0])); break;
+            case mips_sw: storeMemory(readRegister(src[1]) + immediate, 4, readRegister(src[0])); break;
+            case mips_swl:
+            case mips_swr: {
+                uint32_t effective = readRegister(src[1]) + immediate;
+                uint32_t aligned = effective & ~3;
+                uint32_t offset = effective & 3;
+                uint32_t value = readRegister(src[0]);
+                bool left = decoded.kind == mips_swl;
+                for(uint32_t byte = 0; byte < 4; ++byte) {
+                    uint32_t significance = bigEndian ? 3 - byte : byte;
+                    uint32_t shifted;
+                    if (left) {
+                        if ((bigEndian && byte < offset) || (bigEndian == false && byte > offset)) {
+                            continue;
+                        }
+                        shifted = significance + (bigEndian ? offset : 3 - offset);
+                    } else {
+                        if ((bigEndian && byte > offset) || (bigEndian == false && byte < offset)) {
+                            continue;
+                        }
+                        shifted = significance - (bigEndian ? 3 - offset : offset);
+                    }
+                    *memoryByte(aligned + byte) = (value >> (8 * shifted)) & 0xff;
+                }
+                break;
+            }
+            /* Branches, the constant is the target */
+            case mips_beq: branch = true; taken = readRegister(src[0]) == readRegister(src[1]); break;
+            case mips_bne: branch = true; taken = readRegister(src[0]) != readRegister(src[1]); break;
+            case mips_bgez: branch = true; taken = (int32_t)readRegister(src[0]) >= 0; break;
+            case mips_bgtz: branch = true; taken = (int32_t)readRegister(src[0]) > 0; break;
+            case mips_blez: branch = true; taken = (int32_t)readRegister(src[0]) <= 0; break;
+            case mips_bltz: branch = true; taken = (int32_t)readRegister(src[0]) < 0; break;
+            /* Branch likely, the slot is skipped below when not taken */
+            case mips_beql: branch = true; taken = readRegister(src[0]) == readRegister(src[1]); break;
+            case mips_bnel: branch = true; taken = readRegister(src[0]) != readRegister(src[1]); break;
+            case mips_bgezl: branch = true; taken = (int32_t)readRegister(src[0]) >= 0; break;
+            case mips_bgtzl: branch = true; taken = (int32_t)readRegister(src[0]) > 0; break;
+            case mips_blezl: branch = true; taken = (int32_t)readRegister(src[0]) <= 0; break;
+            case mips_bltzl: branch = true; taken = (int32_t)readRegister(src[0]) < 0; break;
+            /* Linking branches write ra whether they are taken or not */
+            case mips_bgezal:
+            case mips_bgezall: {
+                branch = true;
+                taken = (int32_t)readRegister(src[0]) >= 0;
+                registers[ra] = address + 8;
+                break;
+            }
+            case mips_bltzal:
+            case mips_bltzall: {
+                branch = true;
+                taken = (int32_t)readRegister(src[0]) < 0;
+                registers[ra] = address + 8;
+                break;
+            }
+            case mips_j: branch = true; taken = true; break;
+            case mips_jal: branch = true; taken = true; registers[ra] = address + 8; break;
+            case mips_jr: branch = true; taken = true; target = readRegister(src[0]); break;
+            case mips_jalr: {
+                branch = true;
+                taken = true;
+                target = readRegister(src[0]);
+                writeRegister(dst[0], address + 8);
+                break;
+            }
+            default: {
+                result.status = INTERPRETER_UNKNOWN;
+                result.cycles = cycle;
+                return result;
+            }
+        }
+        if (branch && decoded.kind != mips_jr && decoded.kind != mips_jalr) {
+            target = decoded.instructionConstant;
+        }
+
+        /* Move to the next statement */
+        codePosition next;
+        if (inDelaySlot) {
+            /* The delay slot was executed, do the transfer */
+            inDelaySlot = false;
+            if (transferTaken) {
+                if (transferTarget == returnSentinel) {
+                    result.status = INTERPRETER_RETURNED;
+                    result.returnValue = registers[v0];
+                    break;
+                }
+                if (findPosition(transferTarget, &next) == false) {
+                    result.status = INTERPRETER_NO_CODE;
+                    result.stopAddress = transferTarget;
+                    break;
+                }
+                position = next;
+                continue;
+            }
+        } else if (branch) {
+            transferTaken = taken;
+            transferTarget = target;
+            /* A likely branch that is not taken skips its delay slot */
+            if (taken == false && (getInstructionDescriptor(decoded.kind).flags & INSTRUCTION_LIKELY) != 0) {
+                if (nextPosition(position, &next) == false || nextPosition(next, &next) == false) {
+                    result.status = INTERPRETER_NO_CODE;
+                    break;
+                }
+                position = next;
+                continue;
+            }
+            inDelaySlot = true;
+        }
+        if (nextPosition(position, &next) == false) {
+            result.status = INTERPRETER_NO_CODE;
+            result.stopAddress = fallThrough[position.block];
+            break;
+        }
+        position = next;
+    }
+    result.cycles = cycle;
+    return result;
+}
+
+/* Prints the result of a run */
+void mipsInterpreter::printResult(std::string label, interpreterResult& result) {
+    const char* statusNames[] = {"returned", "exited", "limit", "no code", "unknown instruction", "break"};
+    std::cout << label << " " << statusNames[result.status]
+              << " value:" << std::dec << result.returnValue
+              << " instructions:" << result.instructions
+              << " cycles:" << result.cycles
+              << " hi/lo stalls:" << result.hiLoStalls
+              << " load-use stalls:" << result.loadUseStalls
+              << " at:0x" << std::hex << result.stopAddress << std::dec << std::endl;
+}
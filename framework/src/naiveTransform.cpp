@@ -40,23 +40,33 @@ naiveHandler::naiveHandler(CFGhandler* handler) {
     offset = 0;
 }
 
+/* Reason of the last failure */
+std::string naiveHandler::getError() {
+    return error;
+}
+
 /* Function that applies the naive transformation to the binary */
-void naiveHandler::applyTransformation() {
+bool naiveHandler::applyTransformation() {
     /* Variables */
-    CFG* function = cfgContainer->getFunctionCFG();
+    compactCFG* function = cfgContainer->getCompactCFG();
     /* Find the maximum use of symbolic registers. */
-    determineStackModification();
+    {
+        phaseTimer timer(PHASE_STACK_MODIFICATION);
+        determineStackModification();
+    }
     //TODO perform stack modification
-    modifyStack();
+    if (modifyStack() == false) {
+        return false;
+    }
     
     /* Go through the instructions in a basic block and  */
-    for(std::pair<CFGVIter, CFGVIter> iterPair = vertices(*function);
-        iterPair.first != iterPair.second; ++iterPair.first) {
-        /* Get the basicblock from the vertex.  */
-        SgAsmBlock* bb = get(boost::vertex_name, *function, *iterPair.first);
+    for(unsigned number = 0; number < function->size(); ++number) {
+        /* Get the basicblock from the compact cfg.  */
+        SgAsmBlock* bb = function->getBlock(number);
         /* Transform the block. */
         naiveBlockTransform(bb);
     }
+    return true;
 }
 
 /* Goes applies the naive transformation in a basic block. */
@@ -117,6 +127,7 @@ void naiveHandler::naiveBlockTransform(SgAsmBlock* block) {
 
 /*  Transforms a region of inserted instructions so they have real registers */
 void naiveHandler::regionAllocation(std::list<SgAsmStatement*>* regionList) {//, SgAsmStatementPtrList* instVector) {
+    phaseTimer timer(PHASE_REGION_ALLOCATION);
     /*  We know the maximum number of registers that will be used
         by using the maximum symbolics */
     std::map<unsigned, mipsRegisterName> symbolicToHard;
@@ -157,6 +168,8 @@ void naiveHandler::regionAllocation(std::list<SgAsmStatement*>* regionList) {//,
                 }
             }
         }
+        /* The operands changed, the decoded instruction is stale */
+        invalidateDecodedInstruction(mips);
     }
     /*  The operands that were symbolic register have now been replaced with
         hard registers. Now load and store instructions are to be insterted. */
@@ -170,6 +183,8 @@ void naiveHandler::regionAllocation(std::list<SgAsmStatement*>* regionList) {//,
         saveAccumulator(regionList, moveReg);
     }
     
+    /* Every hard register of the region is saved to the stack */
+    countStatistic(COUNT_SPILLED, symbolicToHard.size());
     // iterate through the symbolic to hard map and push to stack.
     for(std::map<unsigned, mipsRegisterName>::reverse_iterator symIter = symbolicToHard.rbegin();
         symIter != symbolicToHard.rend(); ++symIter) {
@@ -349,7 +364,7 @@ mipsRegisterName naiveHandler::getHardRegister() {
 }
 
 /* Adjust the size of the stack */
-void naiveHandler::modifyStack() {
+bool naiveHandler::modifyStack() {
     /*  From the cfgHandler retrieve the activation records
         that adjusts the stack and modify them to include
         naivetransformers stack */ 
@@ -359,9 +374,20 @@ void naiveHandler::modifyStack() {
         the stack allocation and deallocation */
     SgAsmMipsInstruction* allocMips = isSgAsmMipsInstruction(activationRecordPair.first);
     SgAsmMipsInstruction* deallocMips = isSgAsmMipsInstruction(activationRecordPair.second);
+    /* Without the records the stack can only stay as it is */
+    if (allocMips == NULL || deallocMips == NULL) {
+        if (maximumSymbolicsUsed == 0) {
+            return true;
+        }
+        error = "Naive transformation: No activation record to grow the stack.";
+        return false;
+    }
     //get the instructions operand list
     SgAsmExpressionPtrList& allocOperands = allocMips->get_operandList()->get_operands();
     SgAsmExpressionPtrList& deallocOperands = deallocMips->get_operandList()->get_operands();
+    /* The constants are changed below */
+    invalidateDecodedInstruction(allocMips);
+    invalidateDecodedInstruction(deallocMips);
     //find the constant in the instruction.
     for(SgAsmExpressionPtrList::iterator iter = allocOperands.begin();
         iter != allocOperands.end(); ++iter) {
@@ -394,6 +420,7 @@ void naiveHandler::modifyStack() {
             valConst->set_absoluteValue(constant);
         }
     }
+    return true;
 }
 
 /* Find the maximum amount of used symbolic registers used at the same time */
@@ -403,12 +430,11 @@ void naiveHandler::determineStackModification() {
     /* Keep track of registers to avoid counted registers. */
     std::set<unsigned> symregsCounted;
     /* Go through the cfg and look for the maximum number of used instructions */
-    CFG* function = cfgContainer->getFunctionCFG(); 
-    /* Get all vertices and their block. */
-    for(std::pair<CFGVIter, CFGVIter> vpIter = vertices(*function);
-        vpIter.first != vpIter.second; ++vpIter.first) {
+    compactCFG* function = cfgContainer->getCompactCFG();
+    /* Get all blocks. */
+    for(unsigned number = 0; number < function->size(); ++number) {
         /* Get the basicblock */
-        SgAsmBlock* block = get(boost::vertex_name, *function, *vpIter.first);
+        SgAsmBlock* block = function->getBlock(number);
         /* Get the statement list from the block, get it as a reference. */
         SgAsmStatementPtrList& instList = block->get_statementList();
         /* Go through the instructions and count symbolic registers */
@@ -424,7 +450,7 @@ void naiveHandler::determineStackModification() {
                 if (decodedInst.address == 0) {
                     /* The instruction is an inserted one, check use of symbolic
                         registers. */
-                    for(std::vector<registerStruct>::iterator regIter = decodedInst.destinationRegisters.begin();
+                    for(registerList::iterator regIter = decodedInst.destinationRegisters.begin();
                         regIter != decodedInst.destinationRegisters.end(); ++regIter) {
                         /* reg struct variable */
                         registerStruct reg = (*regIter);
@@ -437,7 +463,7 @@ void naiveHandler::determineStackModification() {
                             symregsCounted.insert(reg.symbolicNumber);
                         }
                     }
-                    for(std::vector<registerStruct>::iterator regIter = decodedInst.sourceRegisters.begin();
+                    for(registerList::iterator regIter = decodedInst.sourceRegisters.begin();
                         regIter != decodedInst.sourceRegisters.end(); ++regIter) {
                         /* reg struct variable */
                         registerStruct reg = (*regIter); 
@@ -474,31 +500,24 @@ void naiveHandler::determineStackModification() {
     The instruction kind will be used to determine how much stack needs to
     modified. */
 void naiveHandler::specialInstructionUse(MipsInstructionKind kind, int* currentModification) {
-    /* Switch case for instructions */
-    switch(kind) {
-        /* These instructions uses the accumulator register, Hi and low */
-        case mips_madd:
-        case mips_maddu:
-        case mips_msub:
-        case mips_msubu:
-        case mips_mult:
-        case mips_multu:
-        case mips_div:
-        case mips_divu: {
-            /*  Check if the counter is zero, then we need to increment it once extra.
-                Special case since we need to an extra register to be used when saving ACC. */
-            if (*currentModification == 0) {
-                *currentModification++;
-            }
-            *currentModification += 2;
-            /*  Set that the acc register needs to be saved */
-            usesAcc = true;
-            break;
-        }
-        default: {
-            /* Default instructions does not need any consideration */
+    /* Instructions that use the accumulator register, Hi and low */
+    if (usesAccumulator(kind)) {
+        /*  Check if the counter is zero, then we need to increment it once extra.
+            Special case since we need to an extra register to be used when saving ACC. */
+        if (*currentModification == 0) {
+            (*currentModification)++;
         }
+        *currentModification += 2;
+        /*  Set that the acc register needs to be saved */
+        usesAcc = true;
     }
 }
 
+/* Function to check if a function uses accumulator register */
+bool naiveHandler::usesAccumulator(MipsInstructionKind kind) {
+    /* Instructions writing hi and lo, mult, div, madd and msub */
+    return (getInstructionDescriptor(kind).accumulator &
+        (ACCUMULATOR_WRITE_HI | ACCUMULATOR_WRITE_LO)) != 0;
+}
+
 
@@ -0,0 +1,130 @@
+/* Node registry implementation */
+
+/* header file */
+#include "nodeRegistry.hpp"
+#include "symbolicRegisters.hpp"
+
+/* The registry used when nodes are built by this thread */
+static __thread nodeRegistry* activeNodeRegistry = NULL;
+/* Serializes node creation between threads */
+static boost::recursive_mutex nodeMutex;
+
+
+/* Constructor */
+nodeRegistry::nodeRegistry() {
+    liveBytes = 0;
+    peakBytes = 0;
+    nodesCreated = 0;
+    nodesFreed = 0;
+}
+
+/* Records a node created by the framework, the builders record each node once */
+void nodeRegistry::track(SgNode* node, size_t bytes) {
+    if (node == NULL) {
+        return;
+    }
+    ownedNodes.push_back(node);
+    nodesCreated++;
+    liveBytes += bytes;
+    peakBytes = std::max(peakBytes, liveBytes);
+}
+
+/*  Deletes the recorded nodes that are not used by the function. Nodes can
+    be shared, a register expression is used by every operand naming it, so
+    the used list is complete before anything is deleted. */
+void nodeRegistry::releaseUnused(CFG* functionCFG) {
+    std::vector<SgNode*> used;
+    markReachable(functionCFG, &used);
+    std::sort(used.begin(), used.end());
+    boost::recursive_mutex::scoped_lock lock(nodeMutex);
+    for(std::vector<SgNode*>::iterator iter = ownedNodes.begin();
+        iter != ownedNodes.end(); ++iter) {
+        if (std::binary_search(used.begin(), used.end(), *iter)) {
+            continue;
+        }
+        /* Stale references in the framework tables go first */
+        if ((*iter)->variantT() == V_SgAsmDirectRegisterExpression) {
+            forgetSymbolicRegister(isSgAsmDirectRegisterExpression(*iter));
+        }
+        delete *iter;
+        nodesFreed++;
+    }
+    /* The used nodes belong to the AST now */
+    ownedNodes.clear();
+    liveBytes = 0;
+}
+
+/* Collects every node reachable from the blocks of a cfg */
+void nodeRegistry::markReachable(CFG* cfg, std::vector<SgNode*>* reachable) {
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*cfg);
+        vPair.first != vPair.second; ++vPair.first) {
+        SgAsmBlock* block = get(boost::vertex_name, *cfg, *vPair.first);
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            reachable->push_back(*iter);
+            SgAsmMipsInstruction* inst = isSgAsmMipsInstruction(*iter);
+            if (inst == NULL || inst->get_operandList() == NULL) {
+                continue;
+            }
+            reachable->push_back(inst->get_operandList());
+            SgAsmExpressionPtrList& operands = inst->get_operandList()->get_operands();
+            for(SgAsmExpressionPtrList::iterator opIter = operands.begin();
+                opIter != operands.end(); ++opIter) {
+                markExpression(*opIter, reachable);
+            }
+        }
+    }
+}
+
+/* Adds an expression and everything below it to the list */
+void nodeRegistry::markExpression(SgAsmExpression* expr, std::vector<SgNode*>* reachable) {
+    if (expr == NULL) {
+        return;
+    }
+    reachable->push_back(expr);
+    if (expr->get_type() != NULL) {
+        reachable->push_back(expr->get_type());
+    }
+    if (V_SgAsmMemoryReferenceExpression == expr->variantT()) {
+        markExpression(isSgAsmMemoryReferenceExpression(expr)->get_address(), reachable);
+    } else if (V_SgAsmBinaryAdd == expr->variantT()) {
+        SgAsmBinaryAdd* binAdd = isSgAsmBinaryAdd(expr);
+        markExpression(binAdd->get_lhs(), reachable);
+        markExpression(binAdd->get_rhs(), reachable);
+    }
+}
+
+/* Bytes of the registered nodes */
+size_t nodeRegistry::getLiveBytes() {
+    return liveBytes;
+}
+
+size_t nodeRegistry::getPeakBytes() {
+    return peakBytes;
+}
+
+/* Prints the counters */
+void nodeRegistry::printStatistics() {
+    std::cout << "framework nodes created:" << std::dec << nodesCreated
+              << " freed:" << nodesFreed
+              << " peak bytes:" << peakBytes << std::endl;
+}
+
+
+/* Sets the registry framework nodes are recorded in, NULL disables it */
+void setActiveNodeRegistry(nodeRegistry* registry) {
+    activeNodeRegistry = registry;
+}
+
+/* Records a node in the active registry, if there is one */
+void trackFrameworkNode(SgNode* node, size_t bytes) {
+    if (activeNodeRegistry != NULL) {
+        activeNodeRegistry->track(node, bytes);
+    }
+}
+
+/* Held while the framework creates or deletes ROSE nodes */
+boost::recursive_mutex& frameworkNodeMutex() {
+    return nodeMutex;
+}
@@ -0,0 +1,299 @@
+/* Pattern rewriter implementation */
+
+/* header file */
+#include "patternRewriter.hpp"
+/* Breadth first construction */
+#include <deque>
+#include <algorithm>
+/* Description of the rules */
+#include <sstream>
+
+/*  STEPS of compiling the rules
+        1. Give every kind that appears in a pattern a symbol, all other
+        kinds share symbol zero.
+        2. Build a trie of the patterns, a state is a matched prefix.
+        3. Breadth first, every state gets the transitions of its longest
+        proper suffix that is also a state for the symbols it lacks, and
+        the rules ending in that suffix. The result is a complete automaton,
+        one table lookup per instruction.
+    STEPS of rewriting a block
+        1. Step the automaton with every instruction, other statements reset
+        it. The rules ending in the state are tried longest first.
+        2. A rule matches when its window is not in a delay slot, holds no
+        branch or forbidden instruction and the registers satisfy the
+        constraints. The action then builds the replacement.
+        3. The replacement takes the place of the window and the automaton
+        restarts after it. */
+
+/* Fixed registers are encoded below PATTERN_ANY */
+int patternFixed(mipsRegisterName reg) {
+    return PATTERN_ANY - 1 - (int)reg;
+}
+
+/* Builds a pattern element */
+patternElement patternInstruction(MipsInstructionKind kind, int destination, int firstSource, int secondSource) {
+    patternElement element;
+    element.kind = kind;
+    element.destination = destination;
+    element.sources[0] = firstSource;
+    element.sources[1] = secondSource;
+    return element;
+}
+
+/* Constructor */
+patternRewriter::patternRewriter() {
+    symbolCount = 1;
+    compiled = false;
+}
+
+/* Adds a rule */
+void patternRewriter::addRule(std::string name, std::vector<patternElement> pattern, rewriteAction action) {
+    if (pattern.empty() || action == NULL) {
+        ASSERT_not_reachable("Pattern: a rule needs a pattern and an action.");
+    }
+    rewriteRule rule;
+    rule.name = name;
+    rule.pattern = pattern;
+    rule.action = action;
+    rule.replacements = 0;
+    /* Number of variables, the highest one used plus one */
+    int highest = PATTERN_ANY;
+    for(std::vector<patternElement>::iterator iter = pattern.begin(); iter != pattern.end(); ++iter) {
+        highest = std::max(highest, std::max(iter->destination, std::max(iter->sources[0], iter->sources[1])));
+    }
+    rule.variables = highest + 1;
+    rules.push_back(rule);
+    compiled = false;
+}
+
+/* Orders the rules of a state, longest pattern first and then by number */
+struct longerRule {
+    longerRule(std::vector<size_t>* lengths): ruleLengths(lengths) {};
+    bool operator()(unsigned first, unsigned second) const {
+        if ((*ruleLengths)[first] != (*ruleLengths)[second]) {
+            return (*ruleLengths)[first] > (*ruleLengths)[second];
+        }
+        return first < second;
+    }
+    std::vector<size_t>* ruleLengths;
+};
+
+/* Builds the automaton of all rules */
+void patternRewriter::compile() {
+    /* Symbols of the kinds */
+    kindSymbols.assign(mips_last_instruction + 1, 0);
+    symbolCount = 1;
+    std::vector<size_t> ruleLengths;
+    for(std::vector<rewriteRule>::iterator rule = rules.begin(); rule != rules.end(); ++rule) {
+        ruleLengths.push_back(rule->pattern.size());
+        for(std::vector<patternElement>::iterator iter = rule->pattern.begin(); iter != rule->pattern.end(); ++iter) {
+            if (kindSymbols[iter->kind] == 0) {
+                kindSymbols[iter->kind] = symbolCount++;
+            }
+        }
+    }
+
+    /* Trie of the patterns, zero is the start state and no state points back to it */
+    std::vector<std::vector<unsigned> > trie(1, std::vector<unsigned>(symbolCount, 0));
+    stateRules.assign(1, std::vector<unsigned>());
+    for(unsigned number = 0; number < rules.size(); ++number) {
+        unsigned state = 0;
+        for(std::vector<patternElement>::iterator iter = rules[number].pattern.begin();
+            iter != rules[number].pattern.end(); ++iter) {
+            unsigned symbol = kindSymbols[iter->kind];
+            if (trie[state][symbol] == 0) {
+                trie[state][symbol] = trie.size();
+                trie.push_back(std::vector<unsigned>(symbolCount, 0));
+                stateRules.push_back(std::vector<unsigned>());
+            }
+            state = trie[state][symbol];
+        }
+        stateRules[state].push_back(number);
+    }
+
+    /* Suffix links breadth first, the missing transitions are the ones of the suffix */
+    std::vector<unsigned> suffix(trie.size(), 0);
+    transitions.assign(trie.size() * symbolCount, 0);
+    std::deque<unsigned> queue;
+    for(unsigned symbol = 0; symbol < symbolCount; ++symbol) {
+        unsigned next = trie[0][symbol];
+        transitions[symbol] = next;
+        if (next != 0) {
+            queue.push_back(next);
+        }
+    }
+    while (queue.empty() == false) {
+        unsigned state = queue.front();
+        queue.pop_front();
+        /* Rules that end in the suffix also end here */
+        stateRules[state].insert(stateRules[state].end(), stateRules[suffix[state]].begin(),
+            stateRules[suffix[state]].end());
+        std::sort(stateRules[state].begin(), stateRules[state].end(), longerRule(&ruleLengths));
+        for(unsigned symbol = 0; symbol < symbolCount; ++symbol) {
+            unsigned next = trie[state][symbol];
+            if (next != 0) {
+                suffix[next] = transitions[suffix[state] * symbolCount + symbol];
+                transitions[state * symbolCount + symbol] = next;
+                queue.push_back(next);
+            } else {
+                transitions[state * symbolCount + symbol] = transitions[suffix[state] * symbolCount + symbol];
+            }
+        }
+    }
+    compiled = true;
+}
+
+/* Checks the constraints of a rule on the decoded window */
+bool patternRewriter::bindRegisters(rewriteRule& rule, std::vector<instructionStruct>& window,
+    std::vector<registerStruct>* bindings) {
+    bindings->assign(rule.variables, registerStruct());
+    std::vector<bool> bound(rule.variables, false);
+    for(size_t index = 0; index < window.size(); ++index) {
+        patternElement& element = rule.pattern[index];
+        /* Constraints and the operands they apply to */
+        int constraints[3] = { element.destination, element.sources[0], element.sources[1] };
+        registerStruct* operands[3] = { NULL, NULL, NULL };
+        if (window[index].destinationRegisters.empty() == false) {
+            operands[0] = &window[index].destinationRegisters[0];
+        }
+        for(size_t source = 0; source < 2 && source < window[index].sourceRegisters.size(); ++source) {
+            operands[source + 1] = &window[index].sourceRegisters[source];
+        }
+        for(int operand = 0; operand < 3; ++operand) {
+            int constraint = constraints[operand];
+            if (constraint == PATTERN_ANY) {
+                continue;
+            }
+            if (operands[operand] == NULL) {
+                return false;
+            }
+            registerStruct& reg = *operands[operand];
+            if (constraint < PATTERN_ANY) {
+                /* Fixed physical register */
+                if (reg.regName != (mipsRegisterName)(PATTERN_ANY - 1 - constraint)) {
+                    return false;
+                }
+            } else if (bound[constraint] == false) {
+                (*bindings)[constraint] = reg;
+                bound[constraint] = true;
+            } else {
+                registerStruct& other = (*bindings)[constraint];
+                if (other.regName != reg.regName ||
+                    (reg.regName == symbolic_reg && other.symbolicNumber != reg.symbolicNumber)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/* Checks that the window can be replaced */
+bool patternRewriter::replaceableWindow(SgAsmStatementPtrList& stmtList, size_t start, size_t end,
+    CFGhandler* handler) {
+    /* A delay slot stays with its branch */
+    if (start > 0) {
+        SgAsmMipsInstruction* before = isSgAsmMipsInstruction(stmtList[start - 1]);
+        if (before != NULL && hasDelaySlot(before->get_kind())) {
+            return false;
+        }
+    }
+    for(size_t index = start; index < end; ++index) {
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmtList[index]);
+        if (hasDelaySlot(mips->get_kind()) || getInstructionFormat(mips->get_kind()) == MIPS_UNKNOWN ||
+            (handler != NULL && handler->isForbiddenInstruction(mips))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Rewrites a statement list */
+unsigned patternRewriter::rewriteBlock(SgAsmStatementPtrList& stmtList, CFGhandler* handler) {
+    if (compiled == false) {
+        ASSERT_not_reachable("Pattern: the rules are not compiled.");
+    }
+    if (rules.empty()) {
+        return 0;
+    }
+    SgAsmStatementPtrList rewritten;
+    std::vector<unsigned long> ruleReplacements(rules.size(), 0);
+    unsigned replacements = 0;
+    unsigned state = 0;
+    for(size_t index = 0; index < stmtList.size(); ++index) {
+        rewritten.push_back(stmtList[index]);
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmtList[index]);
+        if (mips == NULL) {
+            state = 0;
+            continue;
+        }
+        state = transitions[state * symbolCount + kindSymbols[mips->get_kind()]];
+        for(std::vector<unsigned>::iterator ruleIter = stateRules[state].begin();
+            ruleIter != stateRules[state].end(); ++ruleIter) {
+            rewriteRule& rule = rules[*ruleIter];
+            size_t start = index + 1 - rule.pattern.size();
+            if (replaceableWindow(stmtList, start, index + 1, handler) == false) {
+                continue;
+            }
+            std::vector<instructionStruct> window;
+            for(size_t position = start; position <= index; ++position) {
+                window.push_back(decodeInstruction(isSgAsmMipsInstruction(stmtList[position])));
+            }
+            std::vector<registerStruct> bindings;
+            std::vector<SgAsmMipsInstruction*> replacement;
+            if (bindRegisters(rule, window, &bindings) == false ||
+                rule.action(window, bindings, &replacement) == false) {
+                continue;
+            }
+            /* The window ends the rewritten list, put the replacement in its place */
+            rewritten.erase(rewritten.end() - rule.pattern.size(), rewritten.end());
+            rewritten.insert(rewritten.end(), replacement.begin(), replacement.end());
+            ruleReplacements[*ruleIter]++;
+            replacements++;
+            state = 0;
+            break;
+        }
+    }
+    if (replacements != 0) {
+        stmtList.swap(rewritten);
+        boost::mutex::scoped_lock lock(statisticsMutex);
+        for(size_t number = 0; number < rules.size(); ++number) {
+            rules[number].replacements += ruleReplacements[number];
+        }
+    }
+    return replacements;
+}
+
+/* Rewrites all blocks of the function cfg */
+unsigned patternRewriter::rewriteFunction(CFGhandler* handler) {
+    compactCFG* function = handler->getCompactCFG();
+    unsigned replacements = 0;
+    for(unsigned number = 0; number < function->size(); ++number) {
+        replacements += rewriteBlock(function->getBlock(number)->get_statementList(), handler);
+    }
+    return replacements;
+}
+
+/* Rules in order with the kinds and constraints of their patterns */
+std::string patternRewriter::describe() {
+    std::stringstream description;
+    for(std::vector<rewriteRule>::iterator rule = rules.begin(); rule != rules.end(); ++rule) {
+        description << rule->name << ":";
+        for(std::vector<patternElement>::iterator iter = rule->pattern.begin(); iter != rule->pattern.end(); ++iter) {
+            description << iter->kind << "(" << iter->destination << "," << iter->sources[0] << ","
+                        << iter->sources[1] << ")";
+        }
+        description << ";";
+    }
+    return description.str();
+}
+
+/* Prints the replacements made by each rule */
+void patternRewriter::printStatistics() {
+    boost::mutex::scoped_lock lock(statisticsMutex);
+    std::cout << "pattern rules:" << std::dec << rules.size()
+              << " states:" << stateRules.size() << std::endl;
+    for(std::vector<rewriteRule>::iterator iter = rules.begin(); iter != rules.end(); ++iter) {
+        std::cout << "rule " << iter->name << " replacements:" << iter->replacements << std::endl;
+    }
+}
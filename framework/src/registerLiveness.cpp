@@ -0,0 +1,319 @@
+/* Register liveness analysis implementation. */
+
+#include "registerLiveness.hpp"
+
+
+/******************************************************************************
+* Register masks for calls and function exits.
+******************************************************************************/
+/* Registers that a called function is allowed to change, caller saved. */
+static registerMask initCallClobberMask();
+/* Registers that must be live when the function returns. */
+static registerMask initExitLiveMask();
+/* Registers read by a called function, the arguments and pointers */
+static registerMask initCallUseMask();
+
+/* Global masks */
+static registerMask callClobberMask = initCallClobberMask();
+static registerMask exitLiveMask = initExitLiveMask();
+static registerMask callUseMask = initCallUseMask();
+
+
+/* Returns the mask bit of a physical register */
+registerMask registerBit(mipsRegisterName reg) {
+    /* symbolic and zero registers are never part of the mask */
+    if (reg == symbolic_reg || reg == zero) {
+        return 0;
+    }
+    return (registerMask)1 << reg;
+}
+
+/* Checks if the instruction is a call */
+bool isCallInstruction(MipsInstructionKind kind) {
+    return (getInstructionDescriptor(kind).flags & INSTRUCTION_CALL) != 0;
+}
+
+/* Fills in the physical registers that an instruction defines and uses. */
+void instructionDefUse(SgAsmMipsInstruction* inst, registerMask* def, registerMask* use, bool callEffects) {
+    /* reset the masks */
+    *def = 0;
+    *use = 0;
+    /* decode the instruction */
+    instructionStruct decoded = decodeInstruction(inst);
+    /* Unknown instructions might read anything, assume they use all registers. */
+    if (decoded.format == MIPS_UNKNOWN) {
+        *use = allRegistersMask;
+        return;
+    }
+    /* Add the register operands */
+    for(registerList::iterator iter = decoded.destinationRegisters.begin();
+        iter != decoded.destinationRegisters.end(); ++iter) {
+        *def |= registerBit(iter->regName);
+    }
+    for(registerList::iterator iter = decoded.sourceRegisters.begin();
+        iter != decoded.sourceRegisters.end(); ++iter) {
+        *use |= registerBit(iter->regName);
+    }
+    /* Implicit operands, the accumulator and calls. */
+    const instructionDescriptor& descriptor = getInstructionDescriptor(decoded.kind);
+    if ((descriptor.accumulator & ACCUMULATOR_READ_HI) != 0) {
+        *use |= hiRegisterBit;
+    }
+    if ((descriptor.accumulator & ACCUMULATOR_READ_LO) != 0) {
+        *use |= loRegisterBit;
+    }
+    if ((descriptor.accumulator & ACCUMULATOR_WRITE_HI) != 0) {
+        *def |= hiRegisterBit;
+    }
+    if ((descriptor.accumulator & ACCUMULATOR_WRITE_LO) != 0) {
+        *def |= loRegisterBit;
+    }
+    /* Partial loads merge with the old value of the destination */
+    if ((descriptor.flags & INSTRUCTION_MERGES_DESTINATION) != 0) {
+        *use |= *def;
+    }
+    /* The callee reads the arguments and may change caller saved registers */
+    if ((descriptor.flags & INSTRUCTION_CALL) != 0 && callEffects) {
+        *use |= callUseMask;
+        *def |= callClobberMask;
+    }
+}
+
+
+/* Checks if the statement is a call with its delay slot after it in the list */
+static bool callWithSlot(SgAsmStatementPtrList& stmtList, size_t index) {
+    SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmtList[index]);
+    return mips != NULL && isCallInstruction(mips->get_kind()) && index + 1 < stmtList.size() &&
+        isSgAsmMipsInstruction(stmtList[index + 1]) != NULL;
+}
+
+/*  Checks if the statement is the delay slot of a branch likely, the slot
+    only runs when the branch is taken */
+static bool likelySlot(SgAsmStatementPtrList& stmtList, size_t index) {
+    if (index == 0) {
+        return false;
+    }
+    SgAsmMipsInstruction* branch = isSgAsmMipsInstruction(stmtList[index - 1]);
+    return branch != NULL && (getInstructionDescriptor(branch->get_kind()).flags & INSTRUCTION_LIKELY) != 0;
+}
+
+
+/******************************************************************************
+* registerLiveness class.
+******************************************************************************/
+/* Constructor */
+registerLiveness::registerLiveness(compactCFG* cfg) {
+    functionCFG = cfg;
+}
+
+/* Registers live at the start of a block */
+registerMask registerLiveness::getLiveIn(unsigned block) {
+    return liveIn[block];
+}
+
+/* Registers live at the end of a block */
+registerMask registerLiveness::getLiveOut(unsigned block) {
+    return liveOut[block];
+}
+
+/* Computes live in and live out for all blocks */
+void registerLiveness::analyze() {
+    /* Allocate the sets for all blocks */
+    size_t blockCount = functionCFG->size();
+    blockUse.assign(blockCount, 0);
+    blockDef.assign(blockCount, 0);
+    liveIn.assign(blockCount, 0);
+    liveOut.assign(blockCount, 0);
+    /* Calculate use and def of each block */
+    for(unsigned block = 0; block < blockCount; ++block) {
+        blockDefUse(functionCFG->getBlock(block), &blockDef[block], &blockUse[block]);
+    }
+    /* Find how the blocks leave the function cfg */
+    findExitBehaviour();
+
+    /*  Iterate until nothing changes. Blocks are numbered in reverse post
+        order, visiting them backwards sees most successors first. */
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for(size_t index = blockCount; index > 0; --index) {
+            unsigned block = index - 1;
+            /* live out is the union of the successors live in */
+            registerMask out = exitLiveOut[block];
+            for(const unsigned* successor = functionCFG->successorsBegin(block);
+                successor != functionCFG->successorsEnd(block); ++successor) {
+                out |= liveIn[*successor];
+            }
+            for(std::vector<unsigned>::iterator iter = returnSuccessors[block].begin();
+                iter != returnSuccessors[block].end(); ++iter) {
+                out |= liveIn[*iter];
+            }
+            /* live in = use + (out - def) */
+            registerMask in = blockUse[block] | (out & ~blockDef[block]);
+            if (in != liveIn[block] || out != liveOut[block]) {
+                liveIn[block] = in;
+                liveOut[block] = out;
+                changed = true;
+            }
+        }
+    }
+}
+
+/* Fills the vector with the registers live before each instruction */
+void registerLiveness::getInstructionLiveness(unsigned blockNumber, std::vector<registerMask>* liveBefore) {
+    SgAsmBlock* block = functionCFG->getBlock(blockNumber);
+    SgAsmStatementPtrList& stmtList = block->get_statementList();
+    /* One entry per instruction and one for the live out */
+    liveBefore->assign(stmtList.size() + 1, 0);
+    registerMask live = liveOut[blockNumber];
+    (*liveBefore)[stmtList.size()] = live;
+    /*  Walk the block backwards. The callee runs after the delay slot, so
+        what the slot reads and writes is seen before the call clobbers. The
+        slot of a branch likely may not run, its writes do not end a value. */
+    for(size_t index = stmtList.size(); index > 0; --index) {
+        size_t position = index - 1;
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmtList[position]);
+        if (mips != NULL) {
+            if (position > 0 && callWithSlot(stmtList, position - 1)) {
+                live = callUseMask | (live & ~callClobberMask);
+            }
+            registerMask def, use;
+            instructionDefUse(mips, &def, &use, callWithSlot(stmtList, position) == false);
+            if (likelySlot(stmtList, position)) {
+                def = 0;
+            }
+            live = use | (live & ~def);
+        }
+        (*liveBefore)[position] = live;
+    }
+}
+
+/* Calculates use and def of a block */
+void registerLiveness::blockDefUse(SgAsmBlock* block, registerMask* def, registerMask* use) {
+    *def = 0;
+    *use = 0;
+    SgAsmStatementPtrList& stmtList = block->get_statementList();
+    /*  Go through the instructions in order, a register is used by the
+        block if it is read before it is written. The callee of a call
+        reads and clobbers after the delay slot. */
+    bool pendingCall = false;
+    for(size_t index = 0; index < stmtList.size(); ++index) {
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmtList[index]);
+        if (mips != NULL) {
+            bool slotFollows = callWithSlot(stmtList, index);
+            registerMask instDef, instUse;
+            instructionDefUse(mips, &instDef, &instUse, slotFollows == false);
+            /* The slot of a branch likely may not run */
+            if (likelySlot(stmtList, index)) {
+                instDef = 0;
+            }
+            *use |= instUse & ~(*def);
+            *def |= instDef;
+            if (pendingCall) {
+                *use |= callUseMask & ~(*def);
+                *def |= callClobberMask;
+            }
+            pendingCall = slotFollows;
+        }
+    }
+}
+
+/*  Determines what is live when a block leaves the function cfg. A block
+    ending with a call continues in the block after the call. A return
+    needs the return values and callee saved registers. Anything else is
+    unknown and everything is kept live. */
+void registerLiveness::findExitBehaviour() {
+    size_t blockCount = functionCFG->size();
+    exitLiveOut.assign(blockCount, 0);
+    returnSuccessors.assign(blockCount, std::vector<unsigned>());
+    /* Map the start address of each block to its number */
+    std::map<rose_addr_t, unsigned> blockStart;
+    /* End address and last control instruction of each block */
+    std::vector<rose_addr_t> blockEnd(blockCount, 0);
+    std::vector<SgAsmMipsInstruction*> controlInstruction(blockCount, NULL);
+
+    for(unsigned number = 0; number < blockCount; ++number) {
+        SgAsmStatementPtrList& stmtList = functionCFG->getBlock(number)->get_statementList();
+        rose_addr_t lowest = std::numeric_limits<rose_addr_t>::max();
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            /* Inserted instructions have address 0 and are skipped */
+            if (mips == NULL || mips->get_address() == 0) {
+                continue;
+            }
+            if (mips->get_address() < lowest) {
+                lowest = mips->get_address();
+            }
+            if (mips->get_address() + 4 > blockEnd[number]) {
+                blockEnd[number] = mips->get_address() + 4;
+            }
+            /* Remember calls and register jumps */
+            if (isCallInstruction(mips->get_kind()) || mips->get_kind() == mips_jr) {
+                controlInstruction[number] = mips;
+            }
+        }
+        if (lowest != std::numeric_limits<rose_addr_t>::max()) {
+            blockStart.insert(std::pair<rose_addr_t, unsigned>(lowest, number));
+        }
+    }
+
+    for(unsigned number = 0; number < blockCount; ++number) {
+        SgAsmMipsInstruction* control = controlInstruction[number];
+        if (control != NULL && isCallInstruction(control->get_kind())) {
+            /* The callee returns to the instruction after the delay slot. */
+            std::map<rose_addr_t, unsigned>::iterator found = blockStart.find(blockEnd[number]);
+            if (found != blockStart.end()) {
+                returnSuccessors[number].push_back(found->second);
+            } else {
+                exitLiveOut[number] = allRegistersMask;
+            }
+        } else if (functionCFG->successorCount(number) == 0) {
+            /* The block leaves the function cfg */
+            if (control != NULL && control->get_kind() == mips_jr &&
+                decodeInstruction(control).sourceRegisters.back().regName == ra) {
+                /* Function return */
+                exitLiveOut[number] = exitLiveMask;
+            } else {
+                /* Unknown destination, keep everything */
+                exitLiveOut[number] = allRegistersMask;
+            }
+        }
+    }
+}
+
+
+/******************************************************************************
+* Mask init functions.
+******************************************************************************/
+/* Registers that a called function is allowed to change, caller saved. */
+static registerMask initCallClobberMask() {
+    registerMask mask = 0;
+    mask |= registerBit(at);
+    mask |= registerBit(v0) | registerBit(v1);
+    mask |= registerBit(a0) | registerBit(a1) | registerBit(a2) | registerBit(a3);
+    mask |= registerBit(t0) | registerBit(t1) | registerBit(t2) | registerBit(t3);
+    mask |= registerBit(t4) | registerBit(t5) | registerBit(t6) | registerBit(t7);
+    mask |= registerBit(t8) | registerBit(t9);
+    mask |= registerBit(ra);
+    mask |= accumulatorMask;
+    return mask;
+}
+
+/* Registers that must be live when the function returns. */
+static registerMask initExitLiveMask() {
+    registerMask mask = 0;
+    mask |= registerBit(v0) | registerBit(v1);
+    mask |= registerBit(s0) | registerBit(s1) | registerBit(s2) | registerBit(s3);
+    mask |= registerBit(s4) | registerBit(s5) | registerBit(s6) | registerBit(s7);
+    mask |= registerBit(gp) | registerBit(sp) | registerBit(fp) | registerBit(ra);
+    return mask;
+}
+
+/* Registers read by a called function, the arguments and pointers */
+static registerMask initCallUseMask() {
+    registerMask mask = 0;
+    mask |= registerBit(a0) | registerBit(a1) | registerBit(a2) | registerBit(a3);
+    mask |= registerBit(gp) | registerBit(sp);
+    return mask;
+}
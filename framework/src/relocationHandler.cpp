@@ -0,0 +1,544 @@
+/* Address relocation implementation.  */
+
+#include "relocationHandler.hpp"
+
+
+/*  STEPS
+        1. Order the function blocks on their original address.
+
+        2. Walk the blocks once and give every instruction the next address
+        from the placement on. Record the displacement of each run of
+        original instructions in the relocation map. Gaps between blocks
+        keep their size and content.
+
+        3. Check that every branch in the function reaches its new target,
+        the branches to other functions now come from further away.
+        Conditional branches out of range are inverted around a jump, jumps
+        out of their 256MB region are replaced with lui/ori/jr through at
+        when the function does not read at. If anything was expanded the
+        layout is redone.
+
+        4. Set the new addresses and branch targets in the function.
+
+        5. Build j new entry; nop for the original entry. Every reference to
+        the entry, in code or in data, reaches the new function through it.
+
+    A function with a jump table, or with a branch that can not be expanded,
+    is refused. The reason is kept for getError and the function has to be
+    left out of the output.
+*/
+
+/* Constructor */
+relocationHandler::relocationHandler(CFGhandler* handler, rose_addr_t address) {
+    cfgContainer = handler;
+    addressMap = handler->getRelocationMap();
+    functionStart = 0;
+    functionEnd = 0;
+    functionEntry = 0;
+    placement = (address + codeAlignment - 1) & ~(rose_addr_t)(codeAlignment - 1);
+    placementEnd = placement;
+    growth = 0;
+    readsAt = false;
+    expandedBranches = 0;
+    patchedBranches = 0;
+}
+
+/* Number of bytes the function grew */
+int64_t relocationHandler::getGrowth() {
+    return growth;
+}
+
+/* Start address of the function */
+rose_addr_t relocationHandler::getFunctionStart() {
+    return functionStart;
+}
+
+/* First address after the original function */
+rose_addr_t relocationHandler::getFunctionEnd() {
+    return functionEnd;
+}
+
+/* Original entry of the function */
+rose_addr_t relocationHandler::getFunctionEntry() {
+    return functionEntry;
+}
+
+/* New start of the function */
+rose_addr_t relocationHandler::getPlacement() {
+    return placement;
+}
+
+/* First address after the relocated function */
+rose_addr_t relocationHandler::getPlacementEnd() {
+    return placementEnd;
+}
+
+/* Jump to the new entry and its delay slot */
+std::vector<SgAsmMipsInstruction*>* relocationHandler::getEntryJump() {
+    return &entryJump;
+}
+
+/* Reason the relocation was refused */
+std::string relocationHandler::getError() {
+    return error;
+}
+
+/* Records the reason of a failure, returns false */
+bool relocationHandler::fail(std::string message) {
+    error = "Relocation: " + message;
+    return false;
+}
+
+/* Assigns addresses, corrects all branches and builds the entry jump */
+bool relocationHandler::applyRelocation() {
+    collectBlocks();
+    /* The table entries hold old addresses and are not rewritten */
+    if (hasJumpTable()) {
+        return fail("Function jumps through a table.");
+    }
+    /* New address of every statement, per block */
+    std::vector<std::vector<rose_addr_t> > newAddresses;
+    /* Layout until every branch reaches its target, normally once */
+    layoutFunction(&newAddresses);
+    bool expanded = true;
+    while (expanded) {
+        if (expandOutOfRange(newAddresses, &expanded) == false) {
+            return false;
+        }
+        if (expanded) {
+            layoutFunction(&newAddresses);
+        }
+    }
+    /* Write the result to the instructions */
+    patchFunction(newAddresses);
+    buildEntryJump();
+    return true;
+}
+
+/* Prints the intervals, branches and expansions */
+void relocationHandler::printStatistics() {
+    std::cout << "relocation intervals:" << std::dec << addressMap->size()
+              << " placement:" << std::hex << placement << std::dec
+              << " growth:" << growth
+              << " branches patched:" << patchedBranches
+              << " expanded:" << expandedBranches << std::endl;
+}
+
+/* Sorts blocks on their original start address */
+static bool blockAddressBefore(SgAsmBlock* first, SgAsmBlock* second) {
+    return first->get_address() < second->get_address();
+}
+
+/* Collects the function blocks and the program block starts */
+void relocationHandler::collectBlocks() {
+    CFG* function = cfgContainer->getFunctionCFG();
+    CFG* program = cfgContainer->getProgramCFG();
+    functionBlocks.clear();
+    readsAt = false;
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*function);
+        vPair.first != vPair.second; ++vPair.first) {
+        SgAsmBlock* block = get(boost::vertex_name, *function, *vPair.first);
+        functionBlocks.push_back(block);
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            if (mips != NULL) {
+                registerMask def, use;
+                instructionDefUse(mips, &def, &use);
+                readsAt = readsAt || (use & registerBit(at)) != 0;
+            }
+        }
+    }
+    std::sort(functionBlocks.begin(), functionBlocks.end(), blockAddressBefore);
+    functionStart = functionBlocks.empty() ? 0 : functionBlocks.front()->get_address();
+    functionEntry = cfgContainer->getFunctionEntry();
+
+    /* The start of all blocks, code that branches into the function */
+    programBlockStarts.clear();
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*program);
+        vPair.first != vPair.second; ++vPair.first) {
+        programBlockStarts.push_back(get(boost::vertex_name, *program, *vPair.first)->get_address());
+    }
+    std::sort(programBlockStarts.begin(), programBlockStarts.end());
+}
+
+/*  Checks if the function jumps through a register that is not ra. Such a
+    jump reads its target from a table of old addresses. jr t9 without a
+    successor in the function is a call or tail call through the ABI register
+    and is kept. */
+bool relocationHandler::hasJumpTable() {
+    CFG* function = cfgContainer->getFunctionCFG();
+    for(std::pair<CFGVIter, CFGVIter> vPair = vertices(*function);
+        vPair.first != vPair.second; ++vPair.first) {
+        SgAsmBlock* block = get(boost::vertex_name, *function, *vPair.first);
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            if (mips == NULL || mips->get_kind() != mips_jr) {
+                continue;
+            }
+            instructionStruct decoded = decodeInstruction(mips);
+            if (decoded.sourceRegisters.empty()) {
+                return true;
+            }
+            mipsRegisterName target = decoded.sourceRegisters[0].regName;
+            if (target == ra) {
+                continue;
+            }
+            if (target != t9 || out_degree(*vPair.first, *function) > 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Single linear pass assigning new addresses, fills the map */
+void relocationHandler::layoutFunction(std::vector<std::vector<rose_addr_t> >* newAddresses) {
+    addressMap->clear();
+    newAddresses->assign(functionBlocks.size(), std::vector<rose_addr_t>());
+    rose_addr_t cursor = placement;
+    rose_addr_t previousEnd = functionStart;
+    for(size_t blockIndex = 0; blockIndex < functionBlocks.size(); ++blockIndex) {
+        SgAsmBlock* block = functionBlocks[blockIndex];
+        rose_addr_t blockStart = block->get_address();
+        /* Bytes between the blocks are kept as they are */
+        if (blockStart > previousEnd) {
+            addressMap->addRange(previousEnd, blockStart, cursor);
+            cursor += blockStart - previousEnd;
+        }
+        rose_addr_t blockNewStart = cursor;
+        /* Control reaching an original instruction starts at the instructions inserted before it */
+        rose_addr_t entry = cursor;
+        bool blockStartMapped = false;
+        rose_addr_t blockEnd = blockStart;
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            (*newAddresses)[blockIndex].push_back(cursor);
+            rose_addr_t oldAddress = (*iter)->get_address();
+            if (oldAddress != 0) {
+                /* Branches to the block go to the first instruction of the block */
+                if (oldAddress == blockStart) {
+                    addressMap->addInstruction(oldAddress, blockNewStart, cursor);
+                    blockStartMapped = true;
+                } else {
+                    addressMap->addInstruction(oldAddress, entry, cursor);
+                }
+                entry = cursor + 4;
+                blockEnd = std::max(blockEnd, oldAddress + 4);
+            }
+            cursor += 4;
+        }
+        /* The first instruction was removed, the block start still has to be found */
+        if (blockStartMapped == false) {
+            addressMap->addInstruction(blockStart, blockNewStart, blockNewStart);
+            blockEnd = std::max(blockEnd, blockStart + 4);
+        }
+        previousEnd = std::max(previousEnd, blockEnd);
+    }
+    functionEnd = previousEnd;
+    /* The next function is appended at the alignment, the padding is nops */
+    placementEnd = (cursor + codeAlignment - 1) & ~(rose_addr_t)(codeAlignment - 1);
+    growth = (int64_t)(cursor - placement) - (int64_t)(functionEnd - functionStart);
+    addressMap->finalize();
+}
+
+/*  Checks the branch ranges and expands the ones out of range. Sets if
+    anything was expanded, false when a branch can not be expanded. */
+bool relocationHandler::expandOutOfRange(std::vector<std::vector<rose_addr_t> >& newAddresses, bool* expanded) {
+    *expanded = false;
+    for(size_t blockIndex = 0; blockIndex < functionBlocks.size(); ++blockIndex) {
+        SgAsmStatementPtrList& stmtList = functionBlocks[blockIndex]->get_statementList();
+        /* Backwards so expansions do not move the remaining indexes */
+        for(size_t index = stmtList.size(); index > 0; --index) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmtList[index - 1]);
+            if (mips == NULL || hasBranchTarget(mips->get_kind()) == false) {
+                continue;
+            }
+            /* Branches to the expansion skip label are always short */
+            if (localBranches.count(mips) > 0) {
+                continue;
+            }
+            rose_addr_t pc = newAddresses[blockIndex][index - 1];
+            rose_addr_t target = newBranchTarget(mips, 0);
+            if (targetInRange(mips->get_kind(), pc, target) == false) {
+                if (expandBranch(&stmtList, index - 1) == false) {
+                    return false;
+                }
+                *expanded = true;
+            }
+        }
+    }
+    return true;
+}
+
+/*  Returns the new target of a branch in the function. Skip label branches
+    need the address of their nop which is passed when known. */
+rose_addr_t relocationHandler::newBranchTarget(SgAsmMipsInstruction* mips, rose_addr_t nopAddress) {
+    if (localBranches.count(mips) > 0) {
+        return nopAddress + 4;
+    }
+    SgAsmIntegerValueExpression* constant = findConstant(mips);
+    return addressMap->translate(constant->get_absoluteValue());
+}
+
+/* Checks if the target can be reached by the instruction at the address */
+bool relocationHandler::targetInRange(MipsInstructionKind kind, rose_addr_t pc, rose_addr_t target) {
+    if (getInstructionFormat(kind) == J_C) {
+        /* j and jal replace the low 28 bits of the address of the delay slot */
+        return ((pc + 4) & 0xf0000000) == (target & 0xf0000000);
+    }
+    /* Branches have a signed 16 bit word offset from the delay slot */
+    int64_t offset = ((int64_t)target - (int64_t)(pc + 4)) / 4;
+    return offset >= -32768 && offset <= 32767;
+}
+
+/*  Replaces the branch at the index and its delay slot with a long form,
+    false when the branch has no long form. */
+bool relocationHandler::expandBranch(SgAsmStatementPtrList* stmtList, size_t index) {
+    SgAsmMipsInstruction* branch = isSgAsmMipsInstruction((*stmtList)[index]);
+    if (index + 1 >= stmtList->size()) {
+        return fail("Branch out of range without a delay slot.");
+    }
+    SgAsmStatement* delaySlot = (*stmtList)[index + 1];
+    rose_addr_t target = findConstant(branch)->get_absoluteValue();
+    SgAsmStatementPtrList longForm;
+    if (getInstructionFormat(branch->get_kind()) == J_C) {
+        /*  j target; slot -> lui at; ori at; jr at; slot. jal uses jalr so
+            the return address is still after the delay slot. The halves of
+            the target are set to its new address when patching. */
+        if (readsAt) {
+            return fail("Jump out of its region needs at, which the function reads.");
+        }
+        SgAsmMipsInstruction* lui = buildAddressInstruction(mips_lui, at, target);
+        SgAsmMipsInstruction* ori = buildAddressInstruction(mips_ori, at, target);
+        targetAddressParts.insert(std::make_pair(lui, target));
+        targetAddressParts.insert(std::make_pair(ori, target));
+        longForm.push_back(lui);
+        longForm.push_back(ori);
+        longForm.push_back(buildAddressInstruction(branch->get_kind() == mips_jal ? mips_jalr : mips_jr, at, 0));
+        longForm.push_back(delaySlot);
+    } else {
+        /*  b target; slot -> binv skip; slot; j target; nop; skip:
+            The slot runs on both paths like before. */
+        if ((getInstructionDescriptor(branch->get_kind()).flags & INSTRUCTION_LIKELY) != 0) {
+            return fail("Branch likely out of range can not be expanded.");
+        }
+        SgAsmMipsInstruction* inverted = buildInvertedBranch(branch);
+        if (inverted == NULL) {
+            return fail("Branch out of range can not be inverted.");
+        }
+        SgAsmMipsInstruction* nop = buildNop();
+        if (branch->get_kind() == mips_bgezal || branch->get_kind() == mips_bltzal) {
+            /*  The linking branches write ra whether they are taken or not,
+                and the slot already sees it. ra is loaded with the address
+                after the long form first, the taken path jumps without link:
+                lui ra; ori ra; binv skip; slot; j target; nop; skip: */
+            SgAsmMipsInstruction* upper = buildAddressInstruction(mips_lui, ra, 0);
+            SgAsmMipsInstruction* lower = buildAddressInstruction(mips_ori, ra, 0);
+            longForm.push_back(upper);
+            longForm.push_back(lower);
+            returnAddressParts.insert(std::make_pair(upper, nop));
+            returnAddressParts.insert(std::make_pair(lower, nop));
+        }
+        longForm.push_back(inverted);
+        longForm.push_back(delaySlot);
+        longForm.push_back(buildJump(mips_j, target));
+        longForm.push_back(nop);
+        localBranches.insert(std::pair<SgAsmMipsInstruction*, SgAsmMipsInstruction*>(inverted, nop));
+    }
+    /* Replace the branch and the slot */
+    stmtList->erase(stmtList->begin() + index, stmtList->begin() + index + 2);
+    stmtList->insert(stmtList->begin() + index, longForm.begin(), longForm.end());
+    expandedBranches++;
+    return true;
+}
+
+/* Sets the new addresses and branch targets in the function */
+void relocationHandler::patchFunction(std::vector<std::vector<rose_addr_t> >& newAddresses) {
+    for(size_t blockIndex = 0; blockIndex < functionBlocks.size(); ++blockIndex) {
+        SgAsmStatementPtrList& stmtList = functionBlocks[blockIndex]->get_statementList();
+        /* New address of the statements, the expansions refer to their nop */
+        std::map<SgAsmStatement*, rose_addr_t> blockAddresses;
+        for(size_t index = 0; index < stmtList.size(); ++index) {
+            blockAddresses[stmtList[index]] = newAddresses[blockIndex][index];
+        }
+        /* Branch targets are translated before the addresses change */
+        for(size_t index = 0; index < stmtList.size(); ++index) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(stmtList[index]);
+            if (mips == NULL) {
+                continue;
+            }
+            /* Halves of the addresses built by the long forms */
+            std::map<SgAsmMipsInstruction*, SgAsmMipsInstruction*>::iterator part = returnAddressParts.find(mips);
+            std::map<SgAsmMipsInstruction*, rose_addr_t>::iterator targetPart = targetAddressParts.find(mips);
+            if (part != returnAddressParts.end() || targetPart != targetAddressParts.end()) {
+                /* The return address is the instruction after the nop */
+                rose_addr_t address = part != returnAddressParts.end() ?
+                    blockAddresses[part->second] + 4 : addressMap->translate(targetPart->second);
+                uint64_t value = mips->get_kind() == mips_lui ? (address >> 16) & 0xffff : address & 0xffff;
+                findConstant(mips)->set_absoluteValue(value);
+                invalidateDecodedInstruction(mips);
+                continue;
+            }
+            if (hasBranchTarget(mips->get_kind()) == false) {
+                continue;
+            }
+            rose_addr_t nopAddress = 0;
+            if (localBranches.count(mips) > 0) {
+                /* The skip label follows the nop */
+                nopAddress = blockAddresses[localBranches[mips]];
+            }
+            rose_addr_t target = newBranchTarget(mips, nopAddress);
+            SgAsmIntegerValueExpression* constant = findConstant(mips);
+            if (constant->get_absoluteValue() != target) {
+                constant->set_absoluteValue(target);
+                invalidateDecodedInstruction(mips);
+                patchedBranches++;
+            }
+        }
+        /* Set the new addresses */
+        for(size_t index = 0; index < stmtList.size(); ++index) {
+            stmtList[index]->set_address(newAddresses[blockIndex][index]);
+        }
+        if (stmtList.empty() == false) {
+            functionBlocks[blockIndex]->set_address(stmtList.front()->get_address());
+        }
+    }
+}
+
+/*  Builds j new entry; nop for the original entry. The second word of the
+    original function is overwritten by the nop, nothing may branch to it.
+    Without room for them the jump stays empty and the writer refuses. */
+void relocationHandler::buildEntryJump() {
+    rose_addr_t newEntry = addressMap->translate(functionEntry);
+    entryJump.clear();
+    if (functionEntry + 8 > functionEnd ||
+        std::binary_search(programBlockStarts.begin(), programBlockStarts.end(), functionEntry + 4) ||
+        targetInRange(mips_j, functionEntry, newEntry) == false) {
+        return;
+    }
+    entryJump.push_back(buildJump(mips_j, newEntry));
+    entryJump.push_back(buildNop());
+    entryJump[0]->set_address(functionEntry);
+    entryJump[1]->set_address(functionEntry + 4);
+}
+
+/* Returns the constant operand of an instruction */
+SgAsmIntegerValueExpression* relocationHandler::findConstant(SgAsmMipsInstruction* mips) {
+    SgAsmExpressionPtrList& operands = mips->get_operandList()->get_operands();
+    for(SgAsmExpressionPtrList::iterator iter = operands.begin();
+        iter != operands.end(); ++iter) {
+        if (V_SgAsmIntegerValueExpression == (*iter)->variantT()) {
+            return isSgAsmIntegerValueExpression(*iter);
+        }
+    }
+    ASSERT_not_reachable("Relocation: Instruction without constant.");
+    return NULL;
+}
+
+/* Checks if the instruction has a constant branch target */
+bool relocationHandler::hasBranchTarget(MipsInstructionKind kind) {
+    const instructionDescriptor& descriptor = getInstructionDescriptor(kind);
+    /* Branches the framework can not decode are left as they are */
+    return (descriptor.flags & INSTRUCTION_BRANCH) != 0 && descriptor.format != MIPS_UNKNOWN;
+}
+
+/******************************************************************************
+* Build functions for the long forms.
+******************************************************************************/
+/* Builds j or jal */
+SgAsmMipsInstruction* relocationHandler::buildJump(MipsInstructionKind kind, rose_addr_t target) {
+    instructionStruct jump;
+    jump.kind = kind;
+    jump.mnemonic = (kind == mips_jal) ? "jal" : "j";
+    jump.format = getInstructionFormat(kind);
+    jump.instructionConstant = target;
+    jump.significantBits = 32;
+    jump.isSignedConstant = false;
+    return buildInstruction(&jump);
+}
+
+/* Builds a nop */
+SgAsmMipsInstruction* relocationHandler::buildNop() {
+    instructionStruct nop;
+    nop.kind = mips_nop;
+    nop.mnemonic = "nop";
+    nop.format = getInstructionFormat(mips_nop);
+    return buildInstruction(&nop);
+}
+
+/*  Builds the branch with the opposite condition, the target is set when
+    patching. NULL when the branch has no opposite. */
+SgAsmMipsInstruction* relocationHandler::buildInvertedBranch(SgAsmMipsInstruction* branch) {
+    instructionStruct decoded = decodeInstruction(branch);
+    instructionStruct inverted;
+    switch (decoded.kind) {
+        case mips_beq   : inverted.kind = mips_bne;  inverted.mnemonic = "bne";  break;
+        case mips_bne   : inverted.kind = mips_beq;  inverted.mnemonic = "beq";  break;
+        case mips_bgez  : inverted.kind = mips_bltz; inverted.mnemonic = "bltz"; break;
+        case mips_bltz  : inverted.kind = mips_bgez; inverted.mnemonic = "bgez"; break;
+        case mips_bgtz  : inverted.kind = mips_blez; inverted.mnemonic = "blez"; break;
+        case mips_blez  : inverted.kind = mips_bgtz; inverted.mnemonic = "bgtz"; break;
+        /* The linking variants skip over the jump, ra is loaded before */
+        case mips_bgezal: inverted.kind = mips_bltz; inverted.mnemonic = "bltz"; break;
+        case mips_bltzal: inverted.kind = mips_bgez; inverted.mnemonic = "bgez"; break;
+        default: {
+            return NULL;
+        }
+    }
+    inverted.format = getInstructionFormat(inverted.kind);
+    /* Build takes the source registers from the back, reverse the decoded order */
+    inverted.sourceRegisters.assign(decoded.sourceRegisters.rbegin(), decoded.sourceRegisters.rend());
+    inverted.instructionConstant = 0;
+    inverted.significantBits = 32;
+    inverted.isSignedConstant = false;
+    return buildInstruction(&inverted);
+}
+
+/* Builds lui reg, ori reg, jr reg or jalr ra, reg for a target address */
+SgAsmMipsInstruction* relocationHandler::buildAddressInstruction(MipsInstructionKind kind,
+    mipsRegisterName regName, uint64_t target) {
+    registerStruct addressReg;
+    addressReg.regName = regName;
+    registerStruct raReg;
+    raReg.regName = ra;
+    instructionStruct inst;
+    inst.kind = kind;
+    inst.format = getInstructionFormat(kind);
+    inst.significantBits = 32;
+    inst.isSignedConstant = false;
+    switch (kind) {
+        case mips_lui: {
+            inst.mnemonic = "lui";
+            inst.destinationRegisters.push_back(addressReg);
+            inst.instructionConstant = (target >> 16) & 0xffff;
+            break;
+        }
+        case mips_ori: {
+            inst.mnemonic = "ori";
+            inst.destinationRegisters.push_back(addressReg);
+            inst.sourceRegisters.push_back(addressReg);
+            inst.instructionConstant = target & 0xffff;
+            break;
+        }
+        case mips_jr: {
+            inst.mnemonic = "jr";
+            inst.sourceRegisters.push_back(addressReg);
+            break;
+        }
+        case mips_jalr: {
+            inst.mnemonic = "jalr";
+            inst.destinationRegisters.push_back(raReg);
+            inst.sourceRegisters.push_back(addressReg);
+            break;
+        }
+        default: {
+            ASSERT_not_reachable("Relocation: Invalid long form instruction.");
+        }
+    }
+    return buildInstruction(&inst);
+}
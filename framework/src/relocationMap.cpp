@@ -0,0 +1,107 @@
+/* Relocation map implementation */
+
+/* header file */
+#include "relocationMap.hpp"
+
+
+/* Remove all intervals */
+void relocationMap::clear() {
+    intervals.clear();
+    pending.clear();
+}
+
+/* Add the new location of one old instruction */
+void relocationMap::addInstruction(rose_addr_t oldAddress, rose_addr_t entryAddress,
+    rose_addr_t instructionAddress) {
+    relocationInterval interval;
+    interval.oldStart = oldAddress;
+    interval.oldEnd = oldAddress + 4;
+    interval.newStart = entryAddress;
+    interval.insertedBefore = instructionAddress - entryAddress;
+    pending.push_back(interval);
+}
+
+/* Add a range that is moved as a whole */
+void relocationMap::addRange(rose_addr_t oldStart, rose_addr_t oldEnd, rose_addr_t newStart) {
+    relocationInterval interval;
+    interval.oldStart = oldStart;
+    interval.oldEnd = oldEnd;
+    interval.newStart = newStart;
+    interval.insertedBefore = 0;
+    pending.push_back(interval);
+}
+
+/* Sorts and merges the added instructions into intervals */
+void relocationMap::finalize() {
+    /* Add the pending intervals to the table and sort all of them */
+    intervals.insert(intervals.end(), pending.begin(), pending.end());
+    pending.clear();
+    std::sort(intervals.begin(), intervals.end(), intervalBefore);
+    /*  Merge an interval into the previous one when it continues it, the old
+        and new addresses follow directly and nothing was inserted between. */
+    std::vector<relocationInterval> merged;
+    for(std::vector<relocationInterval>::iterator iter = intervals.begin();
+        iter != intervals.end(); ++iter) {
+        if (merged.empty() == false) {
+            relocationInterval& last = merged.back();
+            rose_addr_t lastNewEnd = last.newStart + last.insertedBefore + (last.oldEnd - last.oldStart);
+            if (iter->oldStart == last.oldEnd && iter->insertedBefore == 0 && iter->newStart == lastNewEnd) {
+                last.oldEnd = iter->oldEnd;
+                continue;
+            }
+        }
+        merged.push_back(*iter);
+    }
+    intervals.swap(merged);
+}
+
+/* Check if the address is moved */
+bool relocationMap::isMoved(rose_addr_t oldAddress) {
+    return translate(oldAddress) != oldAddress;
+}
+
+/* Return the new address */
+rose_addr_t relocationMap::translate(rose_addr_t oldAddress) {
+    /* Binary search for the first interval ending after the address */
+    size_t low = 0;
+    size_t high = intervals.size();
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (intervals[middle].oldEnd <= oldAddress) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == intervals.size()) {
+        /* After the table, the address is not covered */
+        return oldAddress;
+    }
+    relocationInterval& interval = intervals[low];
+    if (oldAddress < interval.oldStart) {
+        /* Before the table the address is not moved, in a hole it was removed */
+        if (low == 0) {
+            return oldAddress;
+        }
+        return interval.newStart;
+    }
+    if (oldAddress == interval.oldStart) {
+        return interval.newStart;
+    }
+    return interval.newStart + interval.insertedBefore + (oldAddress - interval.oldStart);
+}
+
+/* Number of intervals in the table */
+size_t relocationMap::size() {
+    return intervals.size();
+}
+
+/* Access to the intervals */
+const std::vector<relocationMap::relocationInterval>& relocationMap::getIntervals() {
+    return intervals;
+}
+
+/* Sorts intervals on old start */
+bool relocationMap::intervalBefore(const relocationInterval& first, const relocationInterval& second) {
+    return first.oldStart < second.oldStart;
+}
@@ -0,0 +1,158 @@
+/* Rewriter statistics implementation */
+
+/* header file */
+#include "rewriterStatistics.hpp"
+/* Output and the monotonic clock */
+#include <iostream>
+#include <fstream>
+#include <time.h>
+
+/* The statistics timers and counters add to, one per thread */
+static __thread rewriterStatistics* activeStatistics = NULL;
+
+/* Names of the phases and counters, used for printing and in the JSON */
+static const char* phaseNames[PHASE_COUNT] = {
+    "frontend",
+    "program_cfg",
+    "function_cfg",
+    "user_traversal",
+    "pattern_rewrite",
+    "register_allocation",
+    "stack_modification",
+    "region_allocation",
+    "scheduling",
+    "delay_slots",
+    "relocation",
+    "write",
+    "debug_output"
+};
+static const char* counterNames[COUNTER_COUNT] = {
+    "functions",
+    "instructions_inspected",
+    "instructions_inserted",
+    "instructions_forbidden",
+    "registers_spilled"
+};
+
+
+/* Constructor */
+rewriterStatistics::rewriterStatistics() {
+    for(unsigned phase = 0; phase < PHASE_COUNT; ++phase) {
+        phaseTime[phase] = 0;
+        phaseRuns[phase] = 0;
+    }
+    for(unsigned counter = 0; counter < COUNTER_COUNT; ++counter) {
+        counters[counter] = 0;
+    }
+    peakSymbolicRegisters = 0;
+}
+
+/* Adds a run of a phase */
+void rewriterStatistics::addTime(rewriterPhase phase, uint64_t nanoseconds) {
+    phaseTime[phase] += nanoseconds;
+    phaseRuns[phase]++;
+}
+
+/* Adds to a counter */
+void rewriterStatistics::count(rewriterCounter counter, unsigned long amount) {
+    counters[counter] += amount;
+}
+
+/* Keeps the highest number of symbolic registers */
+void rewriterStatistics::recordSymbolicRegisters(unsigned registers) {
+    if (registers > peakSymbolicRegisters) {
+        peakSymbolicRegisters = registers;
+    }
+}
+
+/* Adds the statistics of a function */
+void rewriterStatistics::merge(const rewriterStatistics& other) {
+    for(unsigned phase = 0; phase < PHASE_COUNT; ++phase) {
+        phaseTime[phase] += other.phaseTime[phase];
+        phaseRuns[phase] += other.phaseRuns[phase];
+    }
+    for(unsigned counter = 0; counter < COUNTER_COUNT; ++counter) {
+        counters[counter] += other.counters[counter];
+    }
+    recordSymbolicRegisters(other.peakSymbolicRegisters);
+}
+
+/* Prints the phases and counters */
+void rewriterStatistics::printStatistics() {
+    for(unsigned phase = 0; phase < PHASE_COUNT; ++phase) {
+        std::cout << "phase " << phaseNames[phase] << " ms:" << std::dec << phaseTime[phase] / 1000000
+                  << " runs:" << phaseRuns[phase] << std::endl;
+    }
+    for(unsigned counter = 0; counter < COUNTER_COUNT; ++counter) {
+        std::cout << counterNames[counter] << ":" << std::dec << counters[counter] << std::endl;
+    }
+    std::cout << "peak symbolic registers:" << std::dec << peakSymbolicRegisters << std::endl;
+}
+
+/*  Writes the statistics as a JSON object. Phase times of functions that
+    were transformed in parallel are summed, they can be longer than the run. */
+void rewriterStatistics::writeJSON(std::ostream& output) {
+    output << "{" << std::endl << "  \"phases\": {" << std::endl;
+    for(unsigned phase = 0; phase < PHASE_COUNT; ++phase) {
+        output << "    \"" << phaseNames[phase] << "\": {\"nanoseconds\": " << std::dec << phaseTime[phase]
+               << ", \"runs\": " << phaseRuns[phase] << "}" << (phase + 1 < PHASE_COUNT ? "," : "") << std::endl;
+    }
+    output << "  }," << std::endl << "  \"counters\": {" << std::endl;
+    for(unsigned counter = 0; counter < COUNTER_COUNT; ++counter) {
+        output << "    \"" << counterNames[counter] << "\": " << std::dec << counters[counter]
+               << (counter + 1 < COUNTER_COUNT ? "," : "") << std::endl;
+    }
+    output << "  }," << std::endl;
+    output << "  \"peak_symbolic_registers\": " << std::dec << peakSymbolicRegisters << std::endl;
+    output << "}" << std::endl;
+}
+
+/* Writes the JSON object to a file */
+bool rewriterStatistics::writeJSON(std::string file) {
+    std::ofstream output(file.c_str(), std::ios::out | std::ios::trunc);
+    if (!output) {
+        return false;
+    }
+    writeJSON(output);
+    return output.good();
+}
+
+
+/* Starts the timer */
+phaseTimer::phaseTimer(rewriterPhase timedPhase) {
+    phase = timedPhase;
+    statistics = activeStatistics;
+    start = monotonicNanoseconds();
+}
+
+/* Adds the time to the active statistics */
+phaseTimer::~phaseTimer() {
+    if (statistics != NULL) {
+        statistics->addTime(phase, monotonicNanoseconds() - start);
+    }
+}
+
+
+/* Monotonic clock in nanoseconds */
+uint64_t monotonicNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* Sets the statistics of this thread */
+void setActiveStatistics(rewriterStatistics* statistics) {
+    activeStatistics = statistics;
+}
+
+/* Returns the statistics of this thread */
+rewriterStatistics* getActiveStatistics() {
+    return activeStatistics;
+}
+
+/* Adds to a counter of the active statistics */
+void countStatistic(rewriterCounter counter, unsigned long amount) {
+    if (activeStatistics != NULL) {
+        activeStatistics->count(counter, amount);
+    }
+}
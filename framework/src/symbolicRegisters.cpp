@@ -2,76 +2,147 @@
 
 /* Header file */
 #include "symbolicRegisters.hpp"
+#include "nodeRegistry.hpp"
 
-/* Forward declaration */
-unsigned generateRegName();
+/* The context of the function being transformed by this thread */
+static __thread symbolicRegisterContext* activeSymbolicContext = NULL;
 
-/* map to connect the register expression object to the symbolic register. */
-typedef boost::bimap<unsigned, SgAsmDirectRegisterExpression*> regBiMap;
-static regBiMap biRegisterMap;
+/* Returns the active context, symbolic registers need a selected function */
+symbolicRegisterContext* requireSymbolicContext();
 
-/* Number counter for the symbolic regs, starting on 1 since
-   0 is the default value for registerstructs. */
-static unsigned symbolicNumber = 1;
+
+/* Constructor. Number 0 is the default value for registerstructs and is
+   never handed out, its slot stays empty. */
+symbolicRegisterContext::symbolicRegisterContext() {
+    registers.push_back(NULL);
+    for(unsigned number = 0; number < 32; ++number) {
+        physicalRegisters[number] = NULL;
+    }
+}
 
 /* Create a symbolic register that can be used */
-registerStruct generateSymbolicRegister() {
+registerStruct symbolicRegisterContext::generate() {
     /* Create register struct to return  */
     registerStruct regStruct;
     regStruct.regName = symbolic_reg;
-    /* Create the register descriptor, it references zero. */
-    RegisterDescriptor rd = RegisterDescriptor(mips_regclass_gpr, 0, 0, 0); 
+    /* The number is the next slot in the vector */
+    regStruct.symbolicNumber = registers.size();
+    /*  Create the register descriptor, it references zero. Zero bits mark
+        it as symbolic and the offset holds the number. */
+    RegisterDescriptor rd = RegisterDescriptor(mips_regclass_gpr, 0, regStruct.symbolicNumber, 0);
     /* Create the register expression. */
+    boost::recursive_mutex::scoped_lock lock(frameworkNodeMutex());
     SgAsmDirectRegisterExpression* regExp = new SgAsmDirectRegisterExpression(rd);
-    /* Get a sym register name (number) */
-    regStruct.symbolicNumber = generateRegName();
-    /* Insert the register to the map with associated register */
-    biRegisterMap.left.insert(regBiMap::left_value_type(regStruct.symbolicNumber, regExp));
+    trackFrameworkNode(regExp, sizeof(SgAsmDirectRegisterExpression));
+    registers.push_back(regExp);
     /* Return the register number*/ 
     return regStruct;
 }
 
+/* Retrieve the DirectRegisterExpression */
+SgAsmDirectRegisterExpression* symbolicRegisterContext::getExpression(unsigned number) {
+    if (number >= registers.size() || registers[number] == NULL) {
+        ASSERT_not_reachable("symbolicRegisters: unknown symbolic register.");
+    }
+    return registers[number];
+}
+
+/*  Returns the shared expression of a physical register. It is built on
+    the first use in the function and recorded in the node registry like
+    the other built nodes. */
+SgAsmDirectRegisterExpression* symbolicRegisterContext::getPhysicalExpression(unsigned number) {
+    if (number >= 32) {
+        ASSERT_not_reachable("symbolicRegisters: physical register out of range.");
+    }
+    if (physicalRegisters[number] == NULL) {
+        RegisterDescriptor rd = RegisterDescriptor(mips_regclass_gpr, number, 0, 32);
+        boost::recursive_mutex::scoped_lock lock(frameworkNodeMutex());
+        physicalRegisters[number] = new SgAsmDirectRegisterExpression(rd);
+        trackFrameworkNode(physicalRegisters[number], sizeof(SgAsmDirectRegisterExpression));
+    }
+    return physicalRegisters[number];
+}
+
+/* Removes a register expression that is about to be deleted */
+void symbolicRegisterContext::forget(SgAsmDirectRegisterExpression* reg) {
+    if (isSymbolicRegister(reg) == false) {
+        unsigned number = reg->get_descriptor().get_minor();
+        if (number < 32 && physicalRegisters[number] == reg) {
+            physicalRegisters[number] = NULL;
+        }
+        return;
+    }
+    unsigned number = findSymbolicRegister(reg);
+    if (number < registers.size() && registers[number] == reg) {
+        registers[number] = NULL;
+    }
+}
+
+/*  Clear the registers and start the numbering again. The expressions stay
+    in the blocks that use them. */
+void symbolicRegisterContext::clear() {
+    registers.clear();
+    registers.push_back(NULL);
+    for(unsigned number = 0; number < 32; ++number) {
+        physicalRegisters[number] = NULL;
+    }
+}
+
+/* Number of registers generated */
+unsigned symbolicRegisterContext::size() {
+    return registers.size() - 1;
+}
+
+
+/* Sets the context the functions below work on */
+void setActiveSymbolicContext(symbolicRegisterContext* context) {
+    activeSymbolicContext = context;
+}
+
+/* Returns the active context, symbolic registers need a selected function */
+symbolicRegisterContext* requireSymbolicContext() {
+    if (activeSymbolicContext == NULL) {
+        ASSERT_not_reachable("symbolicRegisters: no function selected.");
+    }
+    return activeSymbolicContext;
+}
+
+/* Create a symbolic register in the active context */
+registerStruct generateSymbolicRegister() {
+    return requireSymbolicContext()->generate();
+}
+
 /* Retrieve the DirectRegisterExpression */
 SgAsmDirectRegisterExpression* getDirectRegisterExpression(unsigned number) {
-    /* search the map for the correct register expression */
-    SgAsmDirectRegisterExpression* reg = biRegisterMap.left.find(number)->second;
-    /* return the expression */
-    return reg;
+    return requireSymbolicContext()->getExpression(number);
 }
 
+/* Retrieve the shared expression of a physical register */
+SgAsmDirectRegisterExpression* getPhysicalRegisterExpression(unsigned number) {
+    return requireSymbolicContext()->getPhysicalExpression(number);
+}
 
-/* Clear the map of registers and set symbolic number value to 0  */
+/* Clear the registers of the active context */
 void clearSymbolicRegister() {
-    /* set symbolic number to 1 again */
-    symbolicNumber = 1;
-    /* clear the map */
-    biRegisterMap.clear();
+    requireSymbolicContext()->clear();
 }
 
-/* Generates the symbolic register name, which is just a number. */
-unsigned generateRegName() {
-    /* Increment the number */
-    int number = symbolicNumber++;
-    /* return the number*/
-    return number;
+/*  Removes a register expression from the active context. The expression
+    is deleted afterwards. */
+void forgetSymbolicRegister(SgAsmDirectRegisterExpression* reg) {
+    if (activeSymbolicContext != NULL) {
+        activeSymbolicContext->forget(reg);
+    }
 }
 
-/* Checks if a registerexpression is symbolic or not. */
+/*  Checks if a registerexpression is symbolic or not. Physical registers
+    always have their size set, symbolic ones have zero bits. */
 bool isSymbolicRegister(SgAsmDirectRegisterExpression* reg) {
-    /* Check if the register expression is present in the map. */
-    if (biRegisterMap.right.find(reg) != biRegisterMap.right.end()) {
-        return true;
-    } else {
-        return false;
-    }
+    RegisterDescriptor rd = reg->get_descriptor();
+    return rd.get_major() == mips_regclass_gpr && rd.get_nbits() == 0;
 }
 
-/* search for a symbolic register. */
+/* search for a symbolic register. The number is kept in the offset */
 unsigned findSymbolicRegister(SgAsmDirectRegisterExpression* reg) {
-    //get the symbolic name of the register.
-    unsigned symRegName = biRegisterMap.right.find(reg)->second;
-    //return the name.
-    return symRegName;
+    return reg->get_descriptor().get_offset();
 }
-
-
@@ -0,0 +1,161 @@
+/* Synchronization point TMR implementation */
+
+/* header file */
+#include "syncPointTMR.hpp"
+
+/*  STEPS of hardening a block
+        1. Walk the statements with a map from physical registers to their
+        two shadow registers. A register without shadows is its own shadow.
+        2. An original single destination arithmetic instruction gets two
+        copies in front of it that read the shadows of its sources and
+        write new shadows of its destination.
+        3. Any other instruction first votes the shadowed registers it
+        reads, then drops the shadows of the registers it writes.
+        4. A branch or jump votes the registers it, its delay slot and the
+        successors read, the shadows end there. A block without a branch
+        votes its shadowed live out registers at the end.
+        5. The shadows and voter temporaries are symbolic registers, they
+        are allocated by the linear scan. */
+
+/* Constructor */
+syncPointTMR::syncPointTMR(CFGhandler* handler, voterKind kind) {
+    cfgContainer = handler;
+    voter = kind;
+    triplicated = 0;
+    votes = 0;
+}
+
+/* Triplicates and votes in all blocks of the function cfg */
+void syncPointTMR::applyTransformation() {
+    compactCFG* function = cfgContainer->getCompactCFG();
+    /* Votes are only needed for the registers the successors read */
+    registerLiveness liveness(function);
+    liveness.analyze();
+    for(unsigned number = 0; number < function->size(); ++number) {
+        hardenBlock(function->getBlock(number), liveness.getLiveOut(number));
+    }
+}
+
+/* Prints the triplicated instructions and the inserted votes */
+void syncPointTMR::printStatistics() {
+    std::cout << "sync point tmr triplicated:" << std::dec << triplicated
+              << " votes:" << votes << std::endl;
+}
+
+/* Checks if the instruction is computed three times */
+bool syncPointTMR::isTriplicable(SgAsmMipsInstruction* mips, instructionStruct& decoded) {
+    /* Inserted and forbidden instructions are left as they are */
+    if (mips->get_address() == 0 || cfgContainer->isForbiddenInstruction(mips)) {
+        return false;
+    }
+    /* Register to register computations without side effects */
+    const instructionDescriptor& descriptor = getInstructionDescriptor(decoded.kind);
+    if (descriptor.accumulator != 0 || descriptor.memoryBytes != 0 ||
+        (descriptor.flags & (INSTRUCTION_BRANCH | INSTRUCTION_MERGES_DESTINATION)) != 0) {
+        return false;
+    }
+    if (decoded.format != R_RD_RS_RT && decoded.format != R_RD_RS_C &&
+        decoded.format != I_RD_RS_C && decoded.format != I_RD_C) {
+        return false;
+    }
+    return decoded.destinationRegisters.size() == 1 && decoded.destinationRegisters[0].regName != zero &&
+        decoded.destinationRegisters[0].regName != symbolic_reg;
+}
+
+/* Builds a copy of the instruction on the shadows of one side */
+SgAsmMipsInstruction* syncPointTMR::buildCopy(instructionStruct decoded, shadowMap& shadows,
+    bool secondSide, registerStruct destination) {
+    for(registerList::iterator iter = decoded.sourceRegisters.begin();
+        iter != decoded.sourceRegisters.end(); ++iter) {
+        shadowMap::iterator found = shadows.find(iter->regName);
+        if (found != shadows.end()) {
+            *iter = secondSide ? found->second.second : found->second.first;
+        }
+    }
+    decoded.destinationRegisters[0] = destination;
+    /* The copy is an inserted instruction */
+    decoded.address = 0;
+    /* Build takes the source registers from the back, reverse the decoded order */
+    registerList decodedSources = decoded.sourceRegisters;
+    decoded.sourceRegisters.assign(decodedSources.rbegin(), decodedSources.rend());
+    return buildInstruction(&decoded);
+}
+
+/* Votes the shadowed registers in the mask and drops their shadows */
+void syncPointTMR::voteRegisters(registerMask mask, shadowMap& shadows, SgAsmStatementPtrList* output) {
+    for(shadowMap::iterator iter = shadows.begin(); iter != shadows.end();) {
+        if ((mask & registerBit(iter->first)) == 0) {
+            ++iter;
+            continue;
+        }
+        registerStruct master;
+        master.regName = iter->first;
+        std::vector<SgAsmMipsInstruction*> sequence =
+            buildVoter(voter, master, master, iter->second.first, iter->second.second);
+        output->insert(output->end(), sequence.begin(), sequence.end());
+        votes++;
+        shadows.erase(iter++);
+    }
+}
+
+/* Hardens one block */
+void syncPointTMR::hardenBlock(SgAsmBlock* block, registerMask liveOut) {
+    SgAsmStatementPtrList& instructionVector = block->get_statementList();
+    SgAsmStatementPtrList hardened;
+    shadowMap shadows;
+    bool terminated = false;
+    for(size_t index = 0; index < instructionVector.size(); ++index) {
+        SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(instructionVector[index]);
+        if (mips == NULL) {
+            hardened.push_back(instructionVector[index]);
+            continue;
+        }
+        registerMask def, use;
+        instructionDefUse(mips, &def, &use);
+        if (hasDelaySlot(mips->get_kind())) {
+            /* The branch, its delay slot and the successors see voted values */
+            SgAsmMipsInstruction* slot = index + 1 < instructionVector.size() ?
+                isSgAsmMipsInstruction(instructionVector[index + 1]) : NULL;
+            registerMask slotDef = 0, slotUse = 0;
+            if (slot != NULL) {
+                instructionDefUse(slot, &slotDef, &slotUse);
+            }
+            voteRegisters(use | slotUse | liveOut, shadows, &hardened);
+            shadows.clear();
+            hardened.push_back(mips);
+            if (slot != NULL) {
+                hardened.push_back(slot);
+                index++;
+            }
+            terminated = true;
+            continue;
+        }
+        instructionStruct decoded = decodeInstruction(mips);
+        if (isTriplicable(mips, decoded)) {
+            /* Two copies on the shadows, then the original */
+            registerStruct first = generateSymbolicRegister();
+            registerStruct second = generateSymbolicRegister();
+            hardened.push_back(buildCopy(decoded, shadows, false, first));
+            hardened.push_back(buildCopy(decoded, shadows, true, second));
+            hardened.push_back(mips);
+            shadows[decoded.destinationRegisters[0].regName] = std::make_pair(first, second);
+            triplicated++;
+            continue;
+        }
+        /* The value leaves the triplicated computation */
+        voteRegisters(use, shadows, &hardened);
+        hardened.push_back(mips);
+        for(shadowMap::iterator iter = shadows.begin(); iter != shadows.end();) {
+            if ((def & registerBit(iter->first)) != 0) {
+                shadows.erase(iter++);
+            } else {
+                ++iter;
+            }
+        }
+    }
+    /* Falls through to the next block */
+    if (terminated == false) {
+        voteRegisters(liveOut, shadows, &hardened);
+    }
+    instructionVector.swap(hardened);
+}
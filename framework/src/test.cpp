@@ -3,11 +3,35 @@
 /* small testfile for compiling and testing the framework */
 
 #include "binaryRewriter.hpp"
+#include "policyRewriter.hpp"
+
+/* Policy that visits the memory instructions and keeps them */
+struct keepMemoryPolicy {
+    static bool handles(MipsInstructionKind kind) {
+        return kind == mips_lw || kind == mips_sw;
+    }
+    void transform(BinaryRewriter& rewriter, SgAsmMipsInstruction*) {
+        rewriter.saveInstruction();
+    }
+};
+
+/* Replaces lui r,0 and addiu r,r,c by addiu r,zero,c */
+bool foldZeroUpper(std::vector<instructionStruct>& matched, std::vector<registerStruct>&,
+    std::vector<SgAsmMipsInstruction*>* replacement) {
+    if (matched[0].instructionConstant != 0) {
+        return false;
+    }
+    instructionStruct folded = matched[1];
+    folded.sourceRegisters[0].regName = zero;
+    folded.address = 0;
+    replacement->push_back(buildInstruction(&folded));
+    return true;
+}
 
 
 int main(int argc, char **argv) {
-    //get framework object.
-    BinaryRewriter rewriter(argc, argv);
+    //get framework object, the decisions are made by the policy.
+    policyRewriter<keepMemoryPolicy> rewriter(argc, argv);
 
 //    SgAsmDirectRegisterExpression reg = generateSymbolicRegister();
 //    
@@ -15,6 +39,26 @@ int main(int argc, char **argv) {
 //        std::cout << "reg: " << findSymbolicRegister(&reg)  << " present" << std::endl;
     rewriter.functionSelect("main");
 
+    /* Compare traversal of the boost cfg and the compact cfg */
+    rewriter.benchmarkTraversal(10000);
+    /* Compare the virtual decisions and the policy traversal */
+    rewriter.benchmarkDecisions(10000);
+
+    /* Run main in the interpreter before and after the transformation,
+        with generated argv, and compare the results */
+    rewriter.generateMeasurementArgv(16, 1);
+
+    /* Harden main with the framework TMR, the harness checks it */
+    rewriter.selectHardening(SYNC_POINT_TMR, VOTER_BITWISE_MAJORITY);
+
+    /* Address materialization with a zero upper half, register 0 is the same in both */
+    patternRewriter patterns;
+    std::vector<patternElement> materialization;
+    materialization.push_back(patternInstruction(mips_lui, 0));
+    materialization.push_back(patternInstruction(mips_addiu, 0, 0));
+    patterns.addRule("fold_zero_upper", materialization, foldZeroUpper);
+    rewriter.setPatternRewriter(&patterns);
+
     /* To print out the basic blocks being transformed */
     rewriter.setDebug(true);
 
@@ -23,6 +67,9 @@ int main(int argc, char **argv) {
 
     //print traversal information.
     rewriter.printInformation();
+    patterns.printStatistics();
+    //machine readable timers and counters of the run.
+    rewriter.writeStatistics("rewriter_statistics.json");
 
     return 0;
 }
@@ -0,0 +1,391 @@
+/* Transform cache implementation */
+
+/* header file */
+#include "transformCache.hpp"
+/* File reading and writing */
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+
+/*  STEPS of a cached function
+        1. The number of blocks, then for every block in the order of the
+        compact cfg its address and the number of instructions.
+        2. For every instruction its address, kind and how it is restored.
+        The original instructions of the function are restored as the same
+        nodes, found by their address, so the activation records and the
+        other instructions the cfghandler holds stay valid. Their operands
+        are rebuilt from the stored ones unless their format is unknown.
+        Inserted instructions are built from the stored operands and marked
+        when the user inserted them.
+    The cache file is a magic word, the format version and the number of
+    functions, followed by the name, fingerprint, decisions and words of
+    each function. */
+
+/* Cache file format */
+static const uint64_t transformCacheMagic = 0x4546534e41525431ULL;
+static const uint64_t transformCacheVersion = 2;
+/* How an instruction is restored */
+enum cachedInstructionKind {
+    CACHED_ORIGINAL,    //The original node of the function, found by its address.
+    CACHED_BUILT,       //Built from the stored operands.
+    CACHED_USER,        //Built from the stored operands, inserted by the user.
+    CACHED_OPERANDS     //The original node, its operands built from the stored ones.
+};
+
+/* FNV-1a of a word */
+static void hashWord(uint64_t* hash, uint64_t word) {
+    for(unsigned byte = 0; byte < 8; ++byte) {
+        *hash ^= (word >> (byte * 8)) & 0xff;
+        *hash *= 0x100000001b3ULL;
+    }
+}
+
+/* Appends a register list to the words, false if it holds a symbolic register */
+static bool storeRegisters(const registerList& registers, std::vector<uint64_t>* words) {
+    words->push_back(registers.size());
+    for(registerList::const_iterator iter = registers.begin(); iter != registers.end(); ++iter) {
+        if (iter->regName == symbolic_reg) {
+            return false;
+        }
+        words->push_back(iter->regName);
+        words->push_back(iter->symbolicNumber);
+    }
+    return true;
+}
+
+/* Reads a register list from the words, false if the words are invalid */
+static bool readRegisters(const std::vector<uint64_t>& words, size_t* position, registerList* registers) {
+    if (*position >= words.size() || words[*position] > maxRegisterOperands ||
+        *position + 1 + 2 * words[*position] > words.size()) {
+        return false;
+    }
+    uint64_t count = words[(*position)++];
+    for(uint64_t index = 0; index < count; ++index) {
+        registerStruct reg;
+        reg.regName = (mipsRegisterName)words[(*position)++];
+        reg.symbolicNumber = words[(*position)++];
+        registers->push_back(reg);
+    }
+    return true;
+}
+
+
+/* Constructor */
+transformCache::transformCache() {
+    hits = 0;
+    misses = 0;
+    stored = 0;
+}
+
+/* Fingerprint of the function cfg and the policy key, collects the original statements */
+uint64_t transformCache::fingerprint(CFGhandler* cfgContainer, std::string policy,
+    std::vector<SgAsmStatement*>* originals) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(size_t index = 0; index < policy.size(); ++index) {
+        hashWord(&hash, (unsigned char)policy[index]);
+    }
+    compactCFG* function = cfgContainer->getCompactCFG();
+    hashWord(&hash, function->size());
+    for(unsigned number = 0; number < function->size(); ++number) {
+        SgAsmBlock* block = function->getBlock(number);
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        hashWord(&hash, block->get_address());
+        hashWord(&hash, stmtList.size());
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            hashWord(&hash, (*iter)->get_address());
+            originals->push_back(*iter);
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            if (mips != NULL) {
+                hashWord(&hash, mips->get_kind());
+                SgUnsignedCharList raw = mips->get_raw_bytes();
+                for(SgUnsignedCharList::iterator byte = raw.begin(); byte != raw.end(); ++byte) {
+                    hashWord(&hash, *byte);
+                }
+            }
+        }
+        /* The edges decide the order of the blocks and the liveness */
+        hashWord(&hash, function->successorCount(number));
+        for(const unsigned* successor = function->successorsBegin(number);
+            successor != function->successorsEnd(number); ++successor) {
+            hashWord(&hash, *successor);
+        }
+    }
+    std::sort(originals->begin(), originals->end());
+    return hash;
+}
+
+/* Caches the transformed blocks of a function */
+void transformCache::store(std::string name, CFGhandler* cfgContainer, uint64_t functionPrint, int decisionsMade,
+    const std::vector<SgAsmStatement*>& originals, const std::set<SgAsmStatement*>& userInstructions) {
+    cachedFunction entry;
+    entry.fingerprint = functionPrint;
+    entry.decisionsMade = decisionsMade;
+    compactCFG* function = cfgContainer->getCompactCFG();
+    entry.words.push_back(function->size());
+    for(unsigned number = 0; number < function->size(); ++number) {
+        SgAsmBlock* block = function->getBlock(number);
+        SgAsmStatementPtrList& stmtList = block->get_statementList();
+        entry.words.push_back(block->get_address());
+        entry.words.push_back(stmtList.size());
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            /* Functions with statements that can not be restored are not cached */
+            if (mips == NULL) {
+                return;
+            }
+            bool original = std::binary_search(originals.begin(), originals.end(), *iter);
+            entry.words.push_back(mips->get_address());
+            entry.words.push_back(mips->get_kind());
+            if (getInstructionFormat(mips->get_kind()) == MIPS_UNKNOWN) {
+                if (original == false) {
+                    return;
+                }
+                entry.words.push_back(CACHED_ORIGINAL);
+                continue;
+            }
+            instructionStruct decoded = decodeInstruction(mips);
+            if (original) {
+                entry.words.push_back(CACHED_OPERANDS);
+            } else if (userInstructions.count(*iter) > 0) {
+                entry.words.push_back(CACHED_USER);
+            } else {
+                entry.words.push_back(CACHED_BUILT);
+            }
+            entry.words.push_back(decoded.format);
+            /* Build takes the source registers from the back, reverse the decoded order */
+            registerList buildSources;
+            buildSources.assign(decoded.sourceRegisters.rbegin(), decoded.sourceRegisters.rend());
+            if (storeRegisters(decoded.destinationRegisters, &entry.words) == false ||
+                storeRegisters(buildSources, &entry.words) == false) {
+                return;
+            }
+            entry.words.push_back(decoded.instructionConstant);
+            entry.words.push_back(decoded.significantBits);
+            entry.words.push_back(decoded.isSignedConstant);
+            entry.words.push_back(decoded.memoryReferenceSize);
+            entry.words.push_back(decoded.isSignedMemory);
+        }
+    }
+    boost::mutex::scoped_lock lock(cacheMutex);
+    functions[name] = entry;
+    stored++;
+}
+
+/*  STEPS of restore
+        1. Find the function and compare the fingerprint.
+        2. Build the statement list of every block from its words, the
+        original nodes are found by their address in the function and get
+        new operand lists.
+        3. Replace the statement lists and the operand lists once every
+        block was read. */
+bool transformCache::restore(std::string name, CFGhandler* cfgContainer, uint64_t functionPrint, int* decisionsMade,
+    std::set<SgAsmStatement*>* userInstructions) {
+    cachedFunction* entry = NULL;
+    {
+        boost::mutex::scoped_lock lock(cacheMutex);
+        std::map<std::string, cachedFunction>::iterator found = functions.find(name);
+        if (found == functions.end() || found->second.fingerprint != functionPrint) {
+            misses++;
+            return false;
+        }
+        /* Entries are only replaced by store after the function was restored */
+        entry = &found->second;
+    }
+    const std::vector<uint64_t>& words = entry->words;
+    compactCFG* function = cfgContainer->getCompactCFG();
+    /* Original instructions of the function by address */
+    std::map<rose_addr_t, SgAsmMipsInstruction*> originals;
+    for(unsigned number = 0; number < function->size(); ++number) {
+        SgAsmStatementPtrList& stmtList = function->getBlock(number)->get_statementList();
+        for(SgAsmStatementPtrList::iterator iter = stmtList.begin();
+            iter != stmtList.end(); ++iter) {
+            SgAsmMipsInstruction* mips = isSgAsmMipsInstruction(*iter);
+            if (mips != NULL) {
+                originals.insert(std::make_pair(mips->get_address(), mips));
+            }
+        }
+    }
+    size_t position = 0;
+    bool valid = words.empty() == false && words[position++] == function->size();
+    std::vector<SgAsmStatementPtrList> blockLists(function->size());
+    std::vector<std::pair<SgAsmMipsInstruction*, SgAsmOperandList*> > operandLists;
+    std::set<SgAsmStatement*> restoredUser;
+    for(unsigned number = 0; number < function->size() && valid; ++number) {
+        SgAsmBlock* block = function->getBlock(number);
+        if (position + 2 > words.size() || words[position] != block->get_address()) {
+            valid = false;
+            break;
+        }
+        uint64_t instructionCount = words[position + 1];
+        position += 2;
+        for(uint64_t index = 0; index < instructionCount && valid; ++index) {
+            if (position + 3 > words.size()) {
+                valid = false;
+                break;
+            }
+            rose_addr_t address = words[position];
+            MipsInstructionKind kind = (MipsInstructionKind)words[position + 1];
+            uint64_t restoreKind = words[position + 2];
+            position += 3;
+            /* The original node, it has to be the cached instruction */
+            SgAsmMipsInstruction* original = NULL;
+            if (restoreKind == CACHED_ORIGINAL || restoreKind == CACHED_OPERANDS) {
+                std::map<rose_addr_t, SgAsmMipsInstruction*>::iterator found = originals.find(address);
+                valid = found != originals.end() && found->second->get_kind() == kind;
+                if (valid == false) {
+                    break;
+                }
+                original = found->second;
+                blockLists[number].push_back(original);
+                if (restoreKind == CACHED_ORIGINAL) {
+                    continue;
+                }
+            } else if (restoreKind != CACHED_BUILT && restoreKind != CACHED_USER) {
+                valid = false;
+                break;
+            }
+            instructionStruct instStruct;
+            instStruct.kind = kind;
+            instStruct.mnemonic = instructionMnemonic(kind);
+            instStruct.address = address;
+            if (position >= words.size()) {
+                valid = false;
+                break;
+            }
+            instStruct.format = (instructionType)words[position++];
+            if (readRegisters(words, &position, &instStruct.destinationRegisters) == false ||
+                readRegisters(words, &position, &instStruct.sourceRegisters) == false ||
+                position + 5 > words.size() || instStruct.format != getInstructionFormat(kind)) {
+                valid = false;
+                break;
+            }
+            instStruct.instructionConstant = words[position];
+            instStruct.significantBits = words[position + 1];
+            instStruct.isSignedConstant = words[position + 2] != 0;
+            instStruct.memoryReferenceSize = words[position + 3];
+            instStruct.isSignedMemory = words[position + 4] != 0;
+            position += 5;
+            if (original != NULL) {
+                /* The operands of the original are replaced once all blocks are read */
+                operandLists.push_back(std::make_pair(original,
+                    buildOperandList(&instStruct, getInstructionDescriptor(kind).operands)));
+                continue;
+            }
+            SgAsmMipsInstruction* built = buildInstruction(&instStruct);
+            if (restoreKind == CACHED_USER) {
+                restoredUser.insert(built);
+            }
+            blockLists[number].push_back(built);
+        }
+    }
+    if (valid == false || position != words.size()) {
+        /* The built nodes are unreachable and freed with the function */
+        boost::mutex::scoped_lock lock(cacheMutex);
+        misses++;
+        return false;
+    }
+    for(size_t index = 0; index < operandLists.size(); ++index) {
+        operandLists[index].first->set_operandList(operandLists[index].second);
+        invalidateDecodedInstruction(operandLists[index].first);
+    }
+    for(unsigned number = 0; number < function->size(); ++number) {
+        function->getBlock(number)->get_statementList().swap(blockLists[number]);
+    }
+    userInstructions->swap(restoredUser);
+    *decisionsMade = entry->decisionsMade;
+    boost::mutex::scoped_lock lock(cacheMutex);
+    hits++;
+    return true;
+}
+
+/* Reads the cached functions of a file */
+bool transformCache::load(std::string file) {
+    std::ifstream input(file.c_str(), std::ios::in | std::ios::binary);
+    if (!input) {
+        return false;
+    }
+    std::vector<uint64_t> words;
+    uint64_t word;
+    while (input.read(reinterpret_cast<char*>(&word), sizeof(word))) {
+        words.push_back(word);
+    }
+    if (words.size() < 3 || words[0] != transformCacheMagic || words[1] != transformCacheVersion) {
+        return false;
+    }
+    /* Read every function before any is added */
+    std::map<std::string, cachedFunction> loaded;
+    size_t position = 3;
+    for(uint64_t count = 0; count < words[2]; ++count) {
+        if (position >= words.size()) {
+            return false;
+        }
+        uint64_t nameLength = words[position++];
+        uint64_t nameWords = (nameLength + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        if (position + nameWords + 3 > words.size()) {
+            return false;
+        }
+        std::string name(reinterpret_cast<const char*>(&words[position]), nameLength);
+        position += nameWords;
+        cachedFunction entry;
+        entry.fingerprint = words[position];
+        entry.decisionsMade = words[position + 1];
+        uint64_t wordCount = words[position + 2];
+        position += 3;
+        if (position + wordCount > words.size()) {
+            return false;
+        }
+        entry.words.assign(words.begin() + position, words.begin() + position + wordCount);
+        position += wordCount;
+        loaded[name] = entry;
+    }
+    boost::mutex::scoped_lock lock(cacheMutex);
+    functions.swap(loaded);
+    return true;
+}
+
+/* Writes all cached functions to a file */
+bool transformCache::save(std::string file) {
+    boost::mutex::scoped_lock lock(cacheMutex);
+    std::vector<uint64_t> words;
+    words.push_back(transformCacheMagic);
+    words.push_back(transformCacheVersion);
+    words.push_back(functions.size());
+    for(std::map<std::string, cachedFunction>::iterator iter = functions.begin();
+        iter != functions.end(); ++iter) {
+        /* The name packed into whole words */
+        std::string name = iter->first;
+        words.push_back(name.size());
+        name.resize(((name.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t)) * sizeof(uint64_t), '\0');
+        for(size_t index = 0; index < name.size(); index += sizeof(uint64_t)) {
+            uint64_t nameWord;
+            name.copy(reinterpret_cast<char*>(&nameWord), sizeof(uint64_t), index);
+            words.push_back(nameWord);
+        }
+        words.push_back(iter->second.fingerprint);
+        words.push_back(iter->second.decisionsMade);
+        words.push_back(iter->second.words.size());
+        words.insert(words.end(), iter->second.words.begin(), iter->second.words.end());
+    }
+    /* Write to a temporary file and rename it */
+    std::string temporaryFile = file + ".tmp";
+    std::ofstream output(temporaryFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output) {
+        return false;
+    }
+    output.write(reinterpret_cast<const char*>(&words[0]), words.size() * sizeof(uint64_t));
+    output.close();
+    if (!output || std::rename(temporaryFile.c_str(), file.c_str()) != 0) {
+        std::remove(temporaryFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* Prints the counters */
+void transformCache::printStatistics() {
+    boost::mutex::scoped_lock lock(cacheMutex);
+    std::cout << "transform cache hits:" << std::dec << hits
+              << " misses:" << misses << " stored:" << stored << std::endl;
+}
@@ -0,0 +1,103 @@
+/* Voter library implementation */
+
+/* header file */
+#include "voterLibrary.hpp"
+/* std::swap */
+#include <algorithm>
+
+/*  STEPS of building a voter
+        1. Get the temporaries of the voter from the symbolic registers of
+        the active function.
+        2. Build the sequence, the destination is written by the last
+        instruction so it may be one of the copies. The conditional move
+        writes the destination first, the copies are ordered so that the
+        destination is the first copy when it is one of them.
+        3. Return the instructions in the order they are to be inserted. */
+
+/* Costs, indexed by voterKind */
+static const voterDescriptor voterDescriptors[VOTER_COUNT] = {
+    /* name                 instructions  cycles  temporaries */
+    { "bitwise majority",   4,            4,      2 },
+    { "compare select",     6,            6,      2 },
+    { "conditional move",   3,            3,      1 }
+};
+
+/* Returns the descriptor of a voter */
+const voterDescriptor& getVoterDescriptor(voterKind kind) {
+    if (kind >= VOTER_COUNT) {
+        ASSERT_not_reachable("Voter: unknown voter kind.");
+    }
+    return voterDescriptors[kind];
+}
+
+/* Two registers are the same register */
+static bool sameRegister(registerStruct& first, registerStruct& second) {
+    return first.regName == second.regName &&
+        (first.regName != symbolic_reg || first.symbolicNumber == second.symbolicNumber);
+}
+
+/* Builds an instruction with a destination and two source registers */
+static SgAsmMipsInstruction* buildRegisterInstruction(MipsInstructionKind kind, registerStruct destination,
+    registerStruct first, registerStruct second) {
+    instructionStruct inst;
+    inst.kind = kind;
+    inst.mnemonic = instructionMnemonic(kind);
+    inst.format = getInstructionFormat(kind);
+    inst.destinationRegisters.push_back(destination);
+    /* Build takes the source registers from the back, the first operand last */
+    inst.sourceRegisters.push_back(second);
+    inst.sourceRegisters.push_back(first);
+    return buildInstruction(&inst);
+}
+
+/* Builds the instructions of a voter */
+std::vector<SgAsmMipsInstruction*> buildVoter(voterKind kind, registerStruct destination,
+    registerStruct first, registerStruct second, registerStruct third) {
+    std::vector<SgAsmMipsInstruction*> sequence;
+    registerStruct zeroRegister;
+    zeroRegister.regName = zero;
+    switch (kind) {
+        case VOTER_BITWISE_MAJORITY: {
+            /* Bits where the first two agree, or where the third agrees with either */
+            registerStruct both = generateSymbolicRegister();
+            registerStruct either = generateSymbolicRegister();
+            sequence.push_back(buildRegisterInstruction(mips_and, both, first, second));
+            sequence.push_back(buildRegisterInstruction(mips_or, either, first, second));
+            sequence.push_back(buildRegisterInstruction(mips_and, either, either, third));
+            sequence.push_back(buildRegisterInstruction(mips_or, destination, both, either));
+            break;
+        }
+        case VOTER_COMPARE_SELECT: {
+            /*  The mask is all ones when the first two differ, the first is
+                then exchanged for the third with xor. */
+            registerStruct mask = generateSymbolicRegister();
+            registerStruct change = generateSymbolicRegister();
+            sequence.push_back(buildRegisterInstruction(mips_xor, mask, first, second));
+            sequence.push_back(buildRegisterInstruction(mips_sltu, mask, zeroRegister, mask));
+            sequence.push_back(buildRegisterInstruction(mips_subu, mask, zeroRegister, mask));
+            sequence.push_back(buildRegisterInstruction(mips_xor, change, first, third));
+            sequence.push_back(buildRegisterInstruction(mips_and, change, change, mask));
+            sequence.push_back(buildRegisterInstruction(mips_xor, destination, first, change));
+            break;
+        }
+        case VOTER_CONDITIONAL_MOVE: {
+            /* The vote is symmetric, make the destination the first copy */
+            if (sameRegister(destination, second)) {
+                std::swap(first, second);
+            } else if (sameRegister(destination, third)) {
+                std::swap(first, third);
+            }
+            registerStruct differ = generateSymbolicRegister();
+            sequence.push_back(buildRegisterInstruction(mips_xor, differ, first, second));
+            if (sameRegister(destination, first) == false) {
+                sequence.push_back(buildRegisterInstruction(mips_or, destination, first, zeroRegister));
+            }
+            sequence.push_back(buildRegisterInstruction(mips_movn, destination, third, differ));
+            break;
+        }
+        default: {
+            ASSERT_not_reachable("Voter: unknown voter kind.");
+        }
+    }
+    return sequence;
+}
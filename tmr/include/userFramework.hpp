@@ -13,8 +13,8 @@ class userFramework : public BinaryRewriter {
     public:
         //constructor
         userFramework(int, char**);
-        //overriding the decision function in the framework.
-        void transformDecision(SgAsmMipsInstruction*);
+        //handler registered for addu instead of overriding transformDecision.
+        void transformAddu(SgAsmMipsInstruction*);
 
     private:
         //Hide default constructor again.